@@ -0,0 +1,122 @@
+// active_anomaly_table.cpp
+#include "active_anomaly_table.h"
+#include <utility>
+
+namespace {
+
+constexpr size_t INITIAL_SLOTS = 64;
+
+// 64位键混合（splitmix64终结函数）
+inline uint64_t mixKey(uint64_t key) {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebull;
+    key ^= key >> 31;
+    return key;
+}
+
+} // namespace
+
+ActiveAnomalyTable::ActiveAnomalyTable() : slots_(INITIAL_SLOTS, EMPTY_SLOT) {}
+
+size_t ActiveAnomalyTable::slotFor(AnomalyKey key) const {
+    return static_cast<size_t>(mixKey(key)) & (slots_.size() - 1);
+}
+
+size_t ActiveAnomalyTable::findSlot(AnomalyKey key) const {
+    size_t mask = slots_.size() - 1;
+    for (size_t i = slotFor(key);; i = (i + 1) & mask) {
+        uint32_t position = slots_[i];
+        if (position == EMPTY_SLOT) {
+            return slots_.size();
+        }
+        if (keys_[position] == key) {
+            return i;
+        }
+    }
+}
+
+AnomalyInfo* ActiveAnomalyTable::find(AnomalyKey key) {
+    size_t slot = findSlot(key);
+    return slot == slots_.size() ? nullptr : &entries_[slots_[slot]];
+}
+
+const AnomalyInfo* ActiveAnomalyTable::find(AnomalyKey key) const {
+    size_t slot = findSlot(key);
+    return slot == slots_.size() ? nullptr : &entries_[slots_[slot]];
+}
+
+// 插入：装载因子超过1/2时扩容
+AnomalyInfo* ActiveAnomalyTable::insert(const AnomalyInfo& anomaly, bool& inserted) {
+    if (AnomalyInfo* existing = find(anomaly.key)) {
+        inserted = false;
+        return existing;
+    }
+    if ((keys_.size() + 1) * 2 > slots_.size()) {
+        grow();
+    }
+    size_t mask = slots_.size() - 1;
+    size_t i = slotFor(anomaly.key);
+    while (slots_[i] != EMPTY_SLOT) {
+        i = (i + 1) & mask;
+    }
+    slots_[i] = static_cast<uint32_t>(keys_.size());
+    keys_.push_back(anomaly.key);
+    entries_.push_back(anomaly);
+    inserted = true;
+    return &entries_.back();
+}
+
+// 删除：哈希槽后移填补，记录区以末尾元素填补空位
+bool ActiveAnomalyTable::erase(AnomalyKey key) {
+    size_t hole = findSlot(key);
+    if (hole == slots_.size()) {
+        return false;
+    }
+    size_t mask = slots_.size() - 1;
+    uint32_t position = slots_[hole];
+    slots_[hole] = EMPTY_SLOT;
+
+    // 后移法：将探测链上可前移的元素移入空位
+    for (size_t j = (hole + 1) & mask; slots_[j] != EMPTY_SLOT; j = (j + 1) & mask) {
+        size_t ideal = slotFor(keys_[slots_[j]]);
+        bool stays = hole <= j ? (hole < ideal && ideal <= j) : (hole < ideal || ideal <= j);
+        if (!stays) {
+            slots_[hole] = slots_[j];
+            slots_[j] = EMPTY_SLOT;
+            hole = j;
+        }
+    }
+
+    // 记录区：末尾元素移入被删除的位置
+    size_t last = keys_.size() - 1;
+    if (position != last) {
+        size_t moved_slot = findSlot(keys_[last]);
+        keys_[position] = keys_[last];
+        entries_[position] = std::move(entries_[last]);
+        slots_[moved_slot] = position;
+    }
+    keys_.pop_back();
+    entries_.pop_back();
+    return true;
+}
+
+void ActiveAnomalyTable::clear() {
+    keys_.clear();
+    entries_.clear();
+    slots_.assign(INITIAL_SLOTS, EMPTY_SLOT);
+}
+
+// 扩容为两倍并重建索引
+void ActiveAnomalyTable::grow() {
+    slots_.assign(slots_.size() * 2, EMPTY_SLOT);
+    size_t mask = slots_.size() - 1;
+    for (size_t position = 0; position < keys_.size(); ++position) {
+        size_t i = slotFor(keys_[position]);
+        while (slots_[i] != EMPTY_SLOT) {
+            i = (i + 1) & mask;
+        }
+        slots_[i] = static_cast<uint32_t>(position);
+    }
+}
@@ -0,0 +1,48 @@
+// active_anomaly_table.h
+#ifndef ACTIVE_ANOMALY_TABLE_H
+#define ACTIVE_ANOMALY_TABLE_H
+
+#include <cstdint>
+#include <vector>
+#include "anomaly_types.h"
+
+// 活动异常表：按异常键索引的扁平表
+// 键与记录分别连续存放（删除时用末尾元素填补空位），
+// 索引为线性探测开放寻址哈希，删除采用后移法，不留墓碑。
+class ActiveAnomalyTable {
+public:
+    ActiveAnomalyTable();
+
+    // 查找，不存在返回nullptr
+    AnomalyInfo* find(AnomalyKey key);
+    const AnomalyInfo* find(AnomalyKey key) const;
+
+    // 插入（键取自anomaly.key），已存在时返回已有记录且inserted为false
+    AnomalyInfo* insert(const AnomalyInfo& anomaly, bool& inserted);
+
+    // 删除，成功返回true
+    bool erase(AnomalyKey key);
+
+    size_t size() const { return keys_.size(); }
+    bool empty() const { return keys_.empty(); }
+
+    // 连续存放的键与记录，下标一一对应（删除会改变顺序）
+    const std::vector<AnomalyKey>& keys() const { return keys_; }
+    AnomalyInfo& at(size_t position) { return entries_[position]; }
+    const AnomalyInfo& at(size_t position) const { return entries_[position]; }
+
+    void clear();
+
+private:
+    static constexpr uint32_t EMPTY_SLOT = 0xFFFFFFFFu;
+
+    size_t slotFor(AnomalyKey key) const;   // 键的起始探测位置
+    size_t findSlot(AnomalyKey key) const;  // 键所在槽位，不存在返回slots_.size()
+    void grow();
+
+    std::vector<AnomalyKey> keys_;          // 连续存放的键
+    std::vector<AnomalyInfo> entries_;      // 连续存放的记录
+    std::vector<uint32_t> slots_;           // 哈希槽 -> 记录下标
+};
+
+#endif // ACTIVE_ANOMALY_TABLE_H
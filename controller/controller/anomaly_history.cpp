@@ -0,0 +1,197 @@
+// anomaly_history.cpp
+#include "anomaly_history.h"
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+constexpr size_t INDEX_COUNT = 3;
+constexpr int TYPE_COUNT = 3;   // AnomalyType取值个数
+constexpr int LEVEL_COUNT = 3;  // AnomalyLevel取值个数
+// std::set节点的估计开销：红黑树三个指针与颜色字段
+constexpr size_t SET_NODE_OVERHEAD = 4 * sizeof(void*);
+
+} // namespace
+
+AnomalyHistory::AnomalyHistory(const HistoryRetention& retention) {
+    setRetention(retention);
+}
+
+int64_t AnomalyHistory::toTime(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+}
+
+uint32_t AnomalyHistory::typeLevelKey(AnomalyType type, AnomalyLevel level) {
+    return (static_cast<uint32_t>(type) << 8) | static_cast<uint32_t>(level);
+}
+
+// 超出短字符串优化的部分才占用堆内存
+size_t AnomalyHistory::stringBytes(const AnomalyInfo& anomaly) {
+    const size_t inline_capacity = std::string().capacity();
+    auto heap = [inline_capacity](const std::string& text) {
+        return text.capacity() > inline_capacity ? text.capacity() + 1 : 0;
+    };
+    return heap(anomaly.device_id) + heap(anomaly.description);
+}
+
+void AnomalyHistory::setRetention(const HistoryRetention& retention) {
+    retention_ = retention;
+    retention_.max_records = std::max<size_t>(1, retention.max_records);
+    while (count_ > retention_.max_records) {
+        evictOldest();
+    }
+    // 按时间顺序重排为从0开始，此后可按新容量继续增长
+    std::vector<AnomalyInfo> ordered;
+    ordered.reserve(count_);
+    for (size_t i = 0; i < count_; ++i) {
+        ordered.push_back(std::move(slots_[(head_ + i) % slots_.size()]));
+    }
+    slots_.swap(ordered);
+    slots_.shrink_to_fit();
+    head_ = 0;
+}
+
+void AnomalyHistory::append(const AnomalyInfo& anomaly) {
+    // 按时间淘汰：以新记录的结束时间为当前时间
+    if (retention_.max_age.count() > 0) {
+        auto cutoff = anomaly.end_time - retention_.max_age;
+        while (count_ > 0 && slots_[head_].end_time < cutoff) {
+            evictOldest();
+        }
+    }
+    if (count_ == retention_.max_records) {
+        evictOldest();
+    }
+    if (count_ < slots_.size()) {
+        slots_[(head_ + count_) % slots_.size()] = anomaly; // 复用已淘汰的位置
+    } else {
+        if (head_ != 0) {
+            std::rotate(slots_.begin(), slots_.begin() + static_cast<std::ptrdiff_t>(head_), slots_.end());
+            head_ = 0;
+        }
+        if (slots_.size() == slots_.capacity()) {
+            // 倍增但不超过记录数上限，避免容量超出保留策略
+            slots_.reserve(std::min(retention_.max_records, std::max<size_t>(16, slots_.size() * 2)));
+        }
+        slots_.push_back(anomaly); // 未达到容量，增长
+    }
+    ++count_;
+    uint64_t sequence = next_sequence_++;
+    string_bytes_ += stringBytes(newest()); // 按副本的实际容量计
+    indexRecord(anomaly, sequence);
+}
+
+void AnomalyHistory::evictOldest() {
+    AnomalyInfo& oldest = slots_[head_];
+    unindexRecord(oldest, next_sequence_ - count_);
+    string_bytes_ -= stringBytes(oldest);
+    oldest.device_id = std::string();       // 释放字符串内存
+    oldest.description = std::string();
+    head_ = (head_ + 1) % slots_.size();
+    --count_;
+    ++evicted_;
+}
+
+void AnomalyHistory::indexRecord(const AnomalyInfo& anomaly, uint64_t sequence) {
+    int64_t time = toTime(anomaly.start_time);
+    by_device_.insert(IndexEntry{anomaly.device_index, time, sequence});
+    by_type_level_.insert(IndexEntry{typeLevelKey(anomaly.type, anomaly.level), time, sequence});
+    by_time_.insert(IndexEntry{0, time, sequence});
+}
+
+void AnomalyHistory::unindexRecord(const AnomalyInfo& anomaly, uint64_t sequence) {
+    int64_t time = toTime(anomaly.start_time);
+    by_device_.erase(IndexEntry{anomaly.device_index, time, sequence});
+    by_type_level_.erase(IndexEntry{typeLevelKey(anomaly.type, anomaly.level), time, sequence});
+    by_time_.erase(IndexEntry{0, time, sequence});
+}
+
+const AnomalyInfo& AnomalyHistory::record(uint64_t sequence) const {
+    uint64_t oldest = next_sequence_ - count_;
+    return slots_[(head_ + static_cast<size_t>(sequence - oldest)) % slots_.size()];
+}
+
+void AnomalyHistory::collect(const Index& index, uint32_t key, int64_t from, int64_t to,
+                             std::vector<uint64_t>& sequences) const {
+    auto first = index.lower_bound(IndexEntry{key, from, 0});
+    auto last = index.lower_bound(IndexEntry{key, to, 0});
+    for (auto it = first; it != last; ++it) {
+        sequences.push_back(it->sequence);
+    }
+}
+
+std::vector<AnomalyInfo> AnomalyHistory::query(const AnomalyHistoryQuery& query) const {
+    int64_t from = query.from == std::chrono::system_clock::time_point::min() ?
+        std::numeric_limits<int64_t>::min() : toTime(query.from);
+    int64_t to = query.to == std::chrono::system_clock::time_point::max() ?
+        std::numeric_limits<int64_t>::max() : toTime(query.to);
+    std::vector<uint64_t> sequences;
+    if (from >= to) {
+        return {};
+    }
+
+    // 选择最具选择性的索引：设备 > 类型+等级 > 类型或等级（合并各组合） > 时间
+    bool merged = false;
+    if (query.device != INVALID_DEVICE_INDEX) {
+        collect(by_device_, query.device, from, to, sequences);
+    } else if (query.filter_type && query.filter_level) {
+        collect(by_type_level_, typeLevelKey(query.type, query.level), from, to, sequences);
+    } else if (query.filter_type || query.filter_level) {
+        for (int type = 0; type < TYPE_COUNT; ++type) {
+            for (int level = 0; level < LEVEL_COUNT; ++level) {
+                if ((query.filter_type && static_cast<AnomalyType>(type) != query.type) ||
+                    (query.filter_level && static_cast<AnomalyLevel>(level) != query.level)) {
+                    continue;
+                }
+                collect(by_type_level_, typeLevelKey(static_cast<AnomalyType>(type),
+                                                     static_cast<AnomalyLevel>(level)), from, to, sequences);
+            }
+        }
+        merged = true;
+    } else {
+        collect(by_time_, 0, from, to, sequences);
+    }
+    if (merged) {
+        std::sort(sequences.begin(), sequences.end(), [this](uint64_t a, uint64_t b) {
+            int64_t ta = toTime(record(a).start_time);
+            int64_t tb = toTime(record(b).start_time);
+            return ta != tb ? ta < tb : a < b;
+        });
+    }
+
+    // 设备索引命中后再按类型、等级过滤
+    std::vector<const AnomalyInfo*> matched;
+    matched.reserve(sequences.size());
+    for (uint64_t sequence : sequences) {
+        const AnomalyInfo& anomaly = record(sequence);
+        if ((query.filter_type && anomaly.type != query.type) ||
+            (query.filter_level && anomaly.level != query.level)) {
+            continue;
+        }
+        matched.push_back(&anomaly);
+    }
+    size_t skip = query.limit != 0 && matched.size() > query.limit ? matched.size() - query.limit : 0;
+    std::vector<AnomalyInfo> result;
+    result.reserve(matched.size() - skip);
+    for (size_t i = skip; i < matched.size(); ++i) {
+        result.push_back(*matched[i]);
+    }
+    return result;
+}
+
+size_t AnomalyHistory::memoryUsage() const {
+    size_t node = sizeof(IndexEntry) + SET_NODE_OVERHEAD;
+    return sizeof(*this) + slots_.capacity() * sizeof(AnomalyInfo) + string_bytes_ +
+        count_ * INDEX_COUNT * node;
+}
+
+void AnomalyHistory::clear() {
+    slots_.clear();
+    slots_.shrink_to_fit();
+    head_ = 0;
+    count_ = 0;
+    string_bytes_ = 0;
+    by_device_.clear();
+    by_type_level_.clear();
+    by_time_.clear();
+}
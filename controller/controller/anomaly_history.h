@@ -0,0 +1,98 @@
+// anomaly_history.h
+#ifndef ANOMALY_HISTORY_H
+#define ANOMALY_HISTORY_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <vector>
+#include "anomaly_types.h"
+
+// 历史保留策略：超过记录数上限时淘汰最早的记录，结束时间早于保留时长的记录在追加时淘汰
+struct HistoryRetention {
+    size_t max_records = 10000;                     // 记录数上限（0按1处理）
+    std::chrono::seconds max_age = std::chrono::hours(24 * 7); // 保留时长，0为不按时间淘汰
+};
+
+// 历史查询条件（按开始时间[from, to)，未启用的条件不过滤）
+struct AnomalyHistoryQuery {
+    DeviceIndex device = INVALID_DEVICE_INDEX;      // 设备，INVALID_DEVICE_INDEX为全部
+    bool filter_type = false;
+    AnomalyType type = AnomalyType::DEVICE_FAULT;
+    bool filter_level = false;
+    AnomalyLevel level = AnomalyLevel::INFO;
+    std::chrono::system_clock::time_point from = std::chrono::system_clock::time_point::min();
+    std::chrono::system_clock::time_point to = std::chrono::system_clock::time_point::max();
+    size_t limit = 0;                               // 最多返回条数（取最新的），0为不限
+};
+
+// 有界异常历史：固定容量环形缓冲，按追加顺序淘汰，内存不随运行时间增长。
+// 二级索引（设备、类型+等级、时间）均以（键, 开始时间, 序号）有序存放，
+// 按条件查询先在最具选择性的索引上二分定位时间区间，代价为O(log n + 命中数)。
+// 非线程安全，由调用者加锁
+class AnomalyHistory {
+public:
+    explicit AnomalyHistory(const HistoryRetention& retention = HistoryRetention());
+
+    // 修改保留策略：缩小容量时立即淘汰最早的记录
+    void setRetention(const HistoryRetention& retention);
+    const HistoryRetention& retention() const { return retention_; }
+
+    // 追加一条已结束的异常，按保留策略淘汰旧记录
+    void append(const AnomalyInfo& anomaly);
+
+    // 查询，结果按开始时间升序
+    std::vector<AnomalyInfo> query(const AnomalyHistoryQuery& query) const;
+
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    uint64_t evictedCount() const { return evicted_; }
+
+    // 最近一条记录（非空时有效）
+    const AnomalyInfo& newest() const { return slots_[(head_ + count_ - 1) % slots_.size()]; }
+
+    // 占用内存估计（记录、字符串与索引节点）
+    size_t memoryUsage() const;
+
+    void clear();
+
+private:
+    struct IndexEntry {
+        uint32_t key;           // 设备索引或类型+等级；时间索引为0
+        int64_t time;           // 开始时间
+        uint64_t sequence;      // 追加序号（同一时间内保持追加顺序）
+        bool operator<(const IndexEntry& other) const {
+            if (key != other.key) {
+                return key < other.key;
+            }
+            return time != other.time ? time < other.time : sequence < other.sequence;
+        }
+    };
+    using Index = std::set<IndexEntry>;
+
+    static int64_t toTime(std::chrono::system_clock::time_point time);
+    static uint32_t typeLevelKey(AnomalyType type, AnomalyLevel level);
+    static size_t stringBytes(const AnomalyInfo& anomaly);
+
+    void evictOldest();
+    void indexRecord(const AnomalyInfo& anomaly, uint64_t sequence);
+    void unindexRecord(const AnomalyInfo& anomaly, uint64_t sequence);
+    // 在一个索引的键区间内按时间收集序号
+    void collect(const Index& index, uint32_t key, int64_t from, int64_t to,
+                 std::vector<uint64_t>& sequences) const;
+    const AnomalyInfo& record(uint64_t sequence) const;
+
+    HistoryRetention retention_;
+    std::vector<AnomalyInfo> slots_;    // 环形缓冲
+    size_t head_ = 0;                   // 最早记录所在位置
+    size_t count_ = 0;
+    uint64_t next_sequence_ = 0;        // 下一条记录的序号（最早记录序号 = next_sequence_ - count_）
+    uint64_t evicted_ = 0;
+    size_t string_bytes_ = 0;           // 记录中字符串占用的堆内存
+    Index by_device_;
+    Index by_type_level_;
+    Index by_time_;
+};
+
+#endif // ANOMALY_HISTORY_H
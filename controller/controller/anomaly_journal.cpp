@@ -0,0 +1,486 @@
+// anomaly_journal.cpp
+#include "anomaly_journal.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include "timing_wheel.h"
+
+namespace {
+
+// 文件格式：
+//   文件头（16字节）：magic(4) version(2) reserved(2) reserved(8)
+//   记录：length(4) crc(4) payload(length)，crc为payload的CRC-32C
+//   payload：event(1) type(1) level(1) state(1) flags(1) reserved(1) rule_id(2)
+//            key(8) device_index(4) device_id_len(2) description_len(2)
+//            value(8) start_us(8) end_us(8) device_id description
+//   提交标记payload：event(1) reserved(3) group_crc(4) group_bytes(8)，
+//            group_crc为本组提交标记之前全部记录字节的CRC-32C
+constexpr uint32_t MAGIC = 0x4C4A4D41;          // "AMJL"
+constexpr uint16_t VERSION = 1;
+constexpr size_t FILE_HEADER_SIZE = 16;
+constexpr size_t RECORD_HEADER_SIZE = 8;
+constexpr size_t FIXED_PAYLOAD_SIZE = 48;
+constexpr size_t COMMIT_PAYLOAD_SIZE = 16;
+constexpr uint32_t MAX_PAYLOAD_SIZE = FIXED_PAYLOAD_SIZE + 2 * 0xFFFF;
+
+enum RecordFlag : uint8_t {
+    FLAG_HANDLED = 1u << 0,
+    FLAG_NEEDS_CONFIRMATION = 1u << 1,
+    FLAG_AWAITING_CONFIRMATION = 1u << 2
+};
+
+template <typename T>
+void put(char* out, size_t offset, T value) {
+    std::memcpy(out + offset, &value, sizeof(T));
+}
+
+template <typename T>
+T get(const char* in, size_t offset) {
+    T value;
+    std::memcpy(&value, in + offset, sizeof(T));
+    return value;
+}
+
+int64_t toMicros(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+}
+
+std::chrono::system_clock::time_point fromMicros(int64_t us) {
+    return std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::microseconds(us)));
+}
+
+// 编码一条生命周期记录并追加到out
+void encodeRecord(JournalEvent event, const AnomalyInfo& anomaly, std::vector<char>& out) {
+    uint16_t id_len = static_cast<uint16_t>(std::min<size_t>(anomaly.device_id.size(), 0xFFFF));
+    uint16_t text_len = static_cast<uint16_t>(std::min<size_t>(anomaly.description.size(), 0xFFFF));
+    uint32_t length = static_cast<uint32_t>(FIXED_PAYLOAD_SIZE + id_len + text_len);
+    size_t base = out.size();
+    out.resize(base + RECORD_HEADER_SIZE + length);
+    char* p = out.data() + base + RECORD_HEADER_SIZE;
+    uint8_t flags = static_cast<uint8_t>((anomaly.is_handled ? FLAG_HANDLED : 0) |
+                                         (anomaly.needs_manual_confirmation ? FLAG_NEEDS_CONFIRMATION : 0) |
+                                         (anomaly.awaiting_confirmation ? FLAG_AWAITING_CONFIRMATION : 0));
+    put<uint8_t>(p, 0, static_cast<uint8_t>(event));
+    put<uint8_t>(p, 1, static_cast<uint8_t>(anomaly.type));
+    put<uint8_t>(p, 2, static_cast<uint8_t>(anomaly.level));
+    put<uint8_t>(p, 3, static_cast<uint8_t>(anomaly.state));
+    put<uint8_t>(p, 4, flags);
+    put<uint8_t>(p, 5, 0);
+    put<uint16_t>(p, 6, anomaly.rule_id);
+    put<uint64_t>(p, 8, anomaly.key);
+    put<uint32_t>(p, 16, anomaly.device_index);
+    put<uint16_t>(p, 20, id_len);
+    put<uint16_t>(p, 22, text_len);
+    put<double>(p, 24, anomaly.value);
+    put<int64_t>(p, 32, toMicros(anomaly.start_time));
+    put<int64_t>(p, 40, toMicros(anomaly.end_time));
+    std::memcpy(p + FIXED_PAYLOAD_SIZE, anomaly.device_id.data(), id_len);
+    std::memcpy(p + FIXED_PAYLOAD_SIZE + id_len, anomaly.description.data(), text_len);
+    put<uint32_t>(out.data() + base, 0, length);
+    put<uint32_t>(out.data() + base, 4, crc32c(p, length));
+}
+
+// 追加组提交标记
+void encodeCommit(std::vector<char>& out) {
+    uint32_t group_crc = crc32c(out.data(), out.size());
+    uint64_t group_bytes = out.size();
+    size_t base = out.size();
+    out.resize(base + RECORD_HEADER_SIZE + COMMIT_PAYLOAD_SIZE);
+    char* p = out.data() + base + RECORD_HEADER_SIZE;
+    std::memset(p, 0, COMMIT_PAYLOAD_SIZE);
+    put<uint8_t>(p, 0, static_cast<uint8_t>(JournalEvent::COMMIT));
+    put<uint32_t>(p, 4, group_crc);
+    put<uint64_t>(p, 8, group_bytes);
+    put<uint32_t>(out.data() + base, 0, static_cast<uint32_t>(COMMIT_PAYLOAD_SIZE));
+    put<uint32_t>(out.data() + base, 4, crc32c(p, COMMIT_PAYLOAD_SIZE));
+}
+
+// 解码并校验一条记录（record指向记录头），失败返回false
+bool decodeRecord(const char* record, AnomalyInfo& anomaly) {
+    uint32_t length = get<uint32_t>(record, 0);
+    const char* p = record + RECORD_HEADER_SIZE;
+    if (length < FIXED_PAYLOAD_SIZE || crc32c(p, length) != get<uint32_t>(record, 4)) {
+        return false;
+    }
+    uint16_t id_len = get<uint16_t>(p, 20);
+    uint16_t text_len = get<uint16_t>(p, 22);
+    if (FIXED_PAYLOAD_SIZE + id_len + text_len != length) {
+        return false;
+    }
+    uint8_t flags = get<uint8_t>(p, 4);
+    anomaly = AnomalyInfo();
+    anomaly.type = static_cast<AnomalyType>(get<uint8_t>(p, 1));
+    anomaly.level = static_cast<AnomalyLevel>(get<uint8_t>(p, 2));
+    anomaly.state = static_cast<AnomalyState>(get<uint8_t>(p, 3));
+    anomaly.is_handled = (flags & FLAG_HANDLED) != 0;
+    anomaly.needs_manual_confirmation = (flags & FLAG_NEEDS_CONFIRMATION) != 0;
+    anomaly.awaiting_confirmation = (flags & FLAG_AWAITING_CONFIRMATION) != 0;
+    anomaly.rule_id = get<uint16_t>(p, 6);
+    anomaly.key = get<uint64_t>(p, 8);
+    anomaly.device_index = get<uint32_t>(p, 16);
+    anomaly.value = get<double>(p, 24);
+    anomaly.start_time = fromMicros(get<int64_t>(p, 32));
+    anomaly.end_time = fromMicros(get<int64_t>(p, 40));
+    anomaly.device_id.assign(p + FIXED_PAYLOAD_SIZE, id_len);
+    anomaly.description.assign(p + FIXED_PAYLOAD_SIZE + id_len, text_len);
+    anomaly.pending_timer = TimingWheel::INVALID_TIMER;
+    anomaly.hysteresis_hold = false;
+    anomaly.clear_since_ms = -1;
+    return true;
+}
+
+void encodeFileHeader(std::vector<char>& out) {
+    out.assign(FILE_HEADER_SIZE, 0);
+    put<uint32_t>(out.data(), 0, MAGIC);
+    put<uint16_t>(out.data(), 4, VERSION);
+}
+
+// 遍历[begin, end)内的记录头，对每条记录调用visit(offset, length, event)；
+// 遇到不完整或长度异常的记录时停止，返回已遍历到的位置
+template <typename Visit>
+uint64_t walkRecords(const char* data, uint64_t begin, uint64_t end, Visit visit) {
+    uint64_t position = begin;
+    while (end - position >= RECORD_HEADER_SIZE) {
+        uint32_t length = get<uint32_t>(data + position, 0);
+        if (length == 0 || length > MAX_PAYLOAD_SIZE || end - position - RECORD_HEADER_SIZE < length) {
+            break;
+        }
+        visit(position, length, static_cast<JournalEvent>(get<uint8_t>(data + position + RECORD_HEADER_SIZE, 0)));
+        position += RECORD_HEADER_SIZE + length;
+    }
+    return position;
+}
+
+} // namespace
+
+AnomalyJournal::~AnomalyJournal() {
+    close();
+}
+
+bool AnomalyJournal::open(const std::string& path, size_t history_limit, JournalReplay& replay_out) {
+    if (isOpen()) {
+        return false;
+    }
+    path_ = path;
+    file_ = openFile(path, false);
+    if (file_ == INVALID_FILE) {
+        return false;
+    }
+    if (!replay(history_limit, replay_out)) {
+        closeFile(file_);
+        file_ = INVALID_FILE;
+        return false;
+    }
+    stopping_ = false;
+    open_.store(true, std::memory_order_release);
+    writer_ = std::thread(&AnomalyJournal::writerLoop, this);
+    return true;
+}
+
+// 回放：第一遍只跳读记录头找到最后一个提交标记并校验最后一组（只有最后一组可能不完整），
+// 第二遍按异常键记录最后一条记录的位置，最后只解码仍活动的异常与最近的历史
+bool AnomalyJournal::replay(size_t history_limit, JournalReplay& out) {
+    out = JournalReplay();
+    history_limit_ = history_limit;
+    open_records_.clear();
+    closed_records_.clear();
+    uint64_t size = 0;
+    if (!fileSize(file_, size)) {
+        return false;
+    }
+    MappedFile view;
+    if (!mapFile(file_, size, view)) {
+        return false;
+    }
+    const char* data = view.data;
+    if (size >= FILE_HEADER_SIZE && get<uint32_t>(data, 0) != MAGIC) {
+        unmapFile(view);
+        return false; // 不是异常日志，不覆盖
+    }
+
+    uint64_t valid_end = FILE_HEADER_SIZE;
+    if (size >= FILE_HEADER_SIZE) {
+        uint64_t last_commit_end = FILE_HEADER_SIZE;
+        uint64_t previous_commit_end = FILE_HEADER_SIZE;
+        uint64_t last_commit_offset = 0;
+        walkRecords(data, FILE_HEADER_SIZE, size, [&](uint64_t offset, uint32_t length, JournalEvent event) {
+            if (event == JournalEvent::COMMIT && length == COMMIT_PAYLOAD_SIZE) {
+                previous_commit_end = last_commit_end;
+                last_commit_end = offset + RECORD_HEADER_SIZE + length;
+                last_commit_offset = offset;
+            }
+        });
+        valid_end = last_commit_end;
+        if (last_commit_offset != 0) {
+            const char* commit = data + last_commit_offset;
+            const char* payload = commit + RECORD_HEADER_SIZE;
+            uint64_t group_bytes = get<uint64_t>(payload, 8);
+            bool intact = crc32c(payload, COMMIT_PAYLOAD_SIZE) == get<uint32_t>(commit, 4) &&
+                last_commit_offset - previous_commit_end == group_bytes &&
+                crc32c(data + previous_commit_end, group_bytes) == get<uint32_t>(payload, 4);
+            if (!intact) {
+                valid_end = previous_commit_end; // 最后一组写入不完整
+            }
+        }
+
+        std::unordered_map<AnomalyKey, uint64_t> latest;
+        std::deque<uint64_t> closed;
+        walkRecords(data, FILE_HEADER_SIZE, valid_end, [&](uint64_t offset, uint32_t, JournalEvent event) {
+            ++out.records;
+            AnomalyKey key = get<uint64_t>(data + offset + RECORD_HEADER_SIZE, 8);
+            switch (event) {
+                case JournalEvent::RAISED:
+                case JournalEvent::ACTIVATED:
+                case JournalEvent::UPDATED:
+                    latest[key] = offset;
+                    break;
+                case JournalEvent::CLOSED:
+                    latest.erase(key);
+                    closed.push_back(offset);
+                    if (closed.size() > history_limit) {
+                        closed.pop_front();
+                    }
+                    break;
+                case JournalEvent::DISCARDED:
+                    latest.erase(key);
+                    break;
+                case JournalEvent::COMMIT:
+                    --out.records;
+                    break;
+            }
+        });
+
+        // 按日志顺序解码，同时保留记录字节供压缩使用
+        std::vector<uint64_t> active_offsets;
+        active_offsets.reserve(latest.size());
+        for (const auto& entry : latest) {
+            active_offsets.push_back(entry.second);
+        }
+        std::sort(active_offsets.begin(), active_offsets.end());
+        auto recordBytes = [&](uint64_t offset) {
+            return std::string(data + offset, RECORD_HEADER_SIZE + get<uint32_t>(data + offset, 0));
+        };
+        for (uint64_t offset : closed) {
+            AnomalyInfo anomaly;
+            if (!decodeRecord(data + offset, anomaly)) {
+                ++out.corrupt_records;
+                continue;
+            }
+            out.history.push_back(std::move(anomaly));
+            closed_records_.push_back(recordBytes(offset));
+        }
+        for (uint64_t offset : active_offsets) {
+            AnomalyInfo anomaly;
+            if (!decodeRecord(data + offset, anomaly)) {
+                ++out.corrupt_records;
+                continue;
+            }
+            open_records_[anomaly.key] = recordBytes(offset);
+            out.active.push_back(std::move(anomaly));
+        }
+    }
+    unmapFile(view);
+
+    // 截断未完成提交的尾部；空文件或文件头不完整时重写文件头
+    if (size < FILE_HEADER_SIZE) {
+        std::vector<char> header;
+        encodeFileHeader(header);
+        if (!truncateFile(file_, 0) || !writeAll(file_, header.data(), header.size()) || !syncFile(file_)) {
+            return false;
+        }
+        out.truncated_bytes = size;
+        valid_end = FILE_HEADER_SIZE;
+    } else if (valid_end < size) {
+        out.truncated_bytes = size - valid_end;
+        if (!truncateFile(file_, valid_end) || !syncFile(file_)) {
+            return false;
+        }
+    } else if (!truncateFile(file_, size)) {
+        return false; // 仅移动写位置到末尾
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_bytes_ = valid_end;
+    return true;
+}
+
+void AnomalyJournal::close() {
+    if (!isOpen()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_cv_.notify_one();
+    writer_.join();
+    closeFile(file_);
+    file_ = INVALID_FILE;
+    open_.store(false, std::memory_order_release);
+    commit_cv_.notify_all();
+}
+
+void AnomalyJournal::append(JournalEvent event, const AnomalyInfo& anomaly) {
+    if (!isOpen()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_.size() >= MAX_PENDING_BYTES) {
+            ++dropped_; // 磁盘跟不上：丢弃而不阻塞监测线程
+            return;
+        }
+        encodeRecord(event, anomaly, pending_);
+        ++appended_;
+    }
+    wake_cv_.notify_one();
+}
+
+bool AnomalyJournal::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t target = appended_;
+    uint64_t failures = write_failures_;
+    commit_cv_.wait(lock, [&]() { return committed_ >= target || write_failures_ != failures || !isOpen(); });
+    return committed_ >= target;
+}
+
+JournalStats AnomalyJournal::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    JournalStats stats;
+    stats.appended = appended_;
+    stats.committed = committed_;
+    stats.commits = commits_;
+    stats.dropped = dropped_;
+    stats.write_failures = write_failures_;
+    stats.compactions = compactions_;
+    stats.file_bytes = file_bytes_;
+    return stats;
+}
+
+// 后台写线程：每次取走全部待提交记录，加提交标记后一次写入并刷盘
+void AnomalyJournal::writerLoop() {
+    uint64_t compacted_bytes = 0; // 上次压缩后的文件大小
+    uint64_t finished = 0;        // 已落盘或已放弃的记录序号
+    for (;;) {
+        uint64_t target = 0;
+        uint64_t base = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_cv_.wait(lock, [this]() { return stopping_ || !pending_.empty(); });
+            if (pending_.empty()) {
+                break; // 停止且已无待提交记录
+            }
+            writing_.swap(pending_);
+            target = appended_;
+            base = file_bytes_;
+        }
+        size_t records_end = writing_.size();
+        encodeCommit(writing_);
+        bool written = writeAll(file_, writing_.data(), writing_.size()) && syncFile(file_);
+        if (!written) {
+            truncateFile(file_, base); // 丢弃写了一半的组，保持文件可回放
+            writing_.resize(records_end); // 去掉提交标记
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ++write_failures_;
+                if (stopping_) {
+                    dropped_ += target - finished; // 停止时不再重试
+                    finished = target;
+                } else {
+                    // 本组放回待提交缓冲之前，稍后与新记录一并重试
+                    writing_.insert(writing_.end(), pending_.begin(), pending_.end());
+                    pending_.swap(writing_);
+                    wake_cv_.wait_for(lock, std::chrono::milliseconds(WRITE_RETRY_MS),
+                                      [this]() { return stopping_; });
+                }
+            }
+            commit_cv_.notify_all(); // 唤醒flush报告失败
+            writing_.clear();
+            continue;
+        }
+        walkRecords(writing_.data(), 0, records_end, [this](uint64_t offset, uint32_t length, JournalEvent) {
+            trackRecord(writing_.data() + offset, RECORD_HEADER_SIZE + length);
+        });
+        uint64_t file_bytes = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            committed_ += target - finished; // 只计入本组实际写入的记录
+            finished = target;
+            ++commits_;
+            file_bytes_ += writing_.size();
+            file_bytes = file_bytes_;
+        }
+        commit_cv_.notify_all();
+        writing_.clear();
+
+        // 超过门限且比上次压缩后翻倍时压缩（活动异常很多时避免反复压缩）
+        uint64_t threshold = compact_bytes_.load(std::memory_order_relaxed);
+        if (threshold != 0 && file_bytes > threshold && file_bytes > 2 * compacted_bytes && compact()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            compacted_bytes = file_bytes_;
+        }
+    }
+}
+
+void AnomalyJournal::trackRecord(const char* record, size_t size) {
+    const char* payload = record + RECORD_HEADER_SIZE;
+    AnomalyKey key = get<uint64_t>(payload, 8);
+    switch (static_cast<JournalEvent>(get<uint8_t>(payload, 0))) {
+        case JournalEvent::RAISED:
+        case JournalEvent::ACTIVATED:
+        case JournalEvent::UPDATED:
+            open_records_[key].assign(record, size);
+            break;
+        case JournalEvent::CLOSED:
+            open_records_.erase(key);
+            closed_records_.emplace_back(record, size);
+            if (closed_records_.size() > history_limit_) {
+                closed_records_.pop_front();
+            }
+            break;
+        case JournalEvent::DISCARDED:
+            open_records_.erase(key);
+            break;
+        case JournalEvent::COMMIT:
+            break;
+    }
+}
+
+// 压缩：以最近历史与活动异常重写为只含一组提交的新文件，刷盘后原子替换
+bool AnomalyJournal::compact() {
+    std::vector<char> content;
+    encodeFileHeader(content);
+    std::vector<char> group;
+    for (const std::string& record : closed_records_) {
+        group.insert(group.end(), record.begin(), record.end());
+    }
+    for (const auto& entry : open_records_) {
+        group.insert(group.end(), entry.second.begin(), entry.second.end());
+    }
+    encodeCommit(group);
+    content.insert(content.end(), group.begin(), group.end());
+
+    std::string temporary = path_ + ".compact";
+    FileHandle file = openFile(temporary, true);
+    if (file == INVALID_FILE) {
+        return false;
+    }
+    bool written = writeAll(file, content.data(), content.size()) && syncFile(file);
+    closeFile(file);
+    if (!written) {
+        return false;
+    }
+    closeFile(file_);
+    bool replaced = replaceFile(temporary, path_);
+    file_ = openFile(path_, false);
+    uint64_t size = 0;
+    if (file_ == INVALID_FILE || !fileSize(file_, size) || !truncateFile(file_, size)) {
+        return false; // 无法重新打开：后续写入失败，不影响已落盘内容
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_bytes_ = size;
+    if (replaced) {
+        ++compactions_;
+    }
+    return replaced;
+}
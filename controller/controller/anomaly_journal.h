@@ -0,0 +1,120 @@
+// anomaly_journal.h
+#ifndef ANOMALY_JOURNAL_H
+#define ANOMALY_JOURNAL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "anomaly_types.h"
+#include "file_io.h"
+
+// 异常生命周期事件
+enum class JournalEvent : uint8_t {
+    RAISED,         // 检出（待确认）
+    ACTIVATED,      // 确认并执行处置动作
+    UPDATED,        // 等级升高或人工确认状态变化
+    CLOSED,         // 解除并进入历史
+    DISCARDED,      // 未确认即消失（瞬态），不进入历史
+    COMMIT          // 组提交标记（内部使用）
+};
+
+// 回放结果
+struct JournalReplay {
+    std::vector<AnomalyInfo> active;    // 未结束的异常（各自最后一条记录的状态）
+    std::vector<AnomalyInfo> history;   // 最近解除的异常（按解除顺序）
+    uint64_t records = 0;               // 有效记录数
+    uint64_t truncated_bytes = 0;       // 截断的未完成提交的尾部字节数
+    uint64_t corrupt_records = 0;       // 校验失败而被跳过的记录数
+};
+
+// 日志运行统计
+struct JournalStats {
+    uint64_t appended = 0;              // 已追加的记录数
+    uint64_t committed = 0;             // 已落盘的记录数
+    uint64_t commits = 0;               // 组提交次数
+    uint64_t dropped = 0;               // 待提交缓冲已满或停止时写入失败而丢弃的记录数
+    uint64_t write_failures = 0;        // 写入或刷盘失败次数（失败的组保留重试）
+    uint64_t compactions = 0;           // 压缩次数
+    uint64_t file_bytes = 0;            // 当前日志文件大小
+};
+
+// 异常日志：只追加的二进制文件，记录异常生命周期事件。
+// 监测线程只把记录编码到内存缓冲（不做I/O），后台线程成组写入并刷盘（组提交）：
+// 刷盘期间到达的记录在下一次一并提交。每组以提交标记结束，标记含整组校验；
+// 前一组刷盘完成后才写下一组，因此崩溃只可能损坏最后一组，打开时截断到最后一个完整提交。
+// 写入或刷盘失败时截回组起点，该组留在待提交缓冲中稍后重试，失败次数计入统计。
+// 打开时以内存映射只读遍历记录头，按异常键只保留最后一条记录的位置，
+// 仅解码仍活动的异常与最近的历史，回放代价接近一次顺序扫描。
+// 文件超过压缩门限时由后台线程以活动异常与最近历史重写（先写临时文件再原子替换）。
+// 记录按本机字节序存放，不跨平台交换
+class AnomalyJournal {
+public:
+    static constexpr uint64_t DEFAULT_COMPACT_BYTES = 64ull << 20;  // 64MB
+    static constexpr size_t MAX_PENDING_BYTES = 16u << 20;          // 待提交缓冲上限16MB
+    static constexpr uint32_t WRITE_RETRY_MS = 100;                 // 写入失败后的重试间隔
+
+    AnomalyJournal() = default;
+    ~AnomalyJournal();
+    AnomalyJournal(const AnomalyJournal&) = delete;
+    AnomalyJournal& operator=(const AnomalyJournal&) = delete;
+
+    // 打开（不存在则创建）并回放，history_limit为回放与压缩保留的历史条数；随后启动后台写线程。
+    // 文件无法打开或不是异常日志时返回false
+    bool open(const std::string& path, size_t history_limit, JournalReplay& replay);
+
+    // 提交剩余记录并停止后台线程
+    void close();
+
+    bool isOpen() const { return open_.load(std::memory_order_acquire); }
+
+    // 追加一条记录（编码到待提交缓冲后立即返回），线程安全
+    void append(JournalEvent event, const AnomalyInfo& anomaly);
+
+    // 等待此前追加的记录全部落盘；期间写入失败或日志已关闭时返回false
+    bool flush();
+
+    // 设置压缩门限（字节），0为不压缩
+    void setCompactThreshold(uint64_t bytes) { compact_bytes_.store(bytes, std::memory_order_relaxed); }
+
+    JournalStats stats() const;
+
+private:
+    void writerLoop();
+    bool replay(size_t history_limit, JournalReplay& out);
+    void trackRecord(const char* record, size_t size); // 维护压缩用的活动异常与最近历史
+    bool compact();
+
+    std::string path_;
+    FileHandle file_ = INVALID_FILE;
+    std::atomic<bool> open_{false};
+    bool stopping_ = false;
+    std::thread writer_;
+
+    mutable std::mutex mutex_;                  // 保护待提交缓冲与提交序号
+    std::condition_variable wake_cv_;           // 有新记录或停止请求
+    std::condition_variable commit_cv_;         // 一组提交完成
+    std::vector<char> pending_;                 // 待提交记录
+    uint64_t appended_ = 0;                     // 已追加记录序号
+    uint64_t committed_ = 0;                    // 已落盘记录数（失败重试中的组不计入）
+    uint64_t commits_ = 0;
+    uint64_t dropped_ = 0;
+    uint64_t write_failures_ = 0;
+    uint64_t compactions_ = 0;
+    uint64_t file_bytes_ = 0;
+
+    // 以下仅后台线程使用
+    std::vector<char> writing_;                 // 正在提交的一组
+    size_t history_limit_ = 0;
+    std::unordered_map<AnomalyKey, std::string> open_records_; // 活动异常的最后一条记录
+    std::deque<std::string> closed_records_;    // 最近解除的记录
+    std::atomic<uint64_t> compact_bytes_{DEFAULT_COMPACT_BYTES};
+};
+
+#endif // ANOMALY_JOURNAL_H
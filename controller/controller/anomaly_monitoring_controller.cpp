@@ -5,517 +5,1734 @@
 #include <cmath>
 #include <thread>
 #include <chrono>
+#include <cstdio>
 
 // 常量定义
-constexpr std::chrono::milliseconds MONITORING_INTERVAL(100); // 监测间隔100ms
+constexpr std::chrono::milliseconds MONITORING_INTERVAL(100); // 无新数据时的最长监测间隔100ms
+constexpr std::chrono::microseconds DEFAULT_MIN_SCAN_PERIOD(2000); // 默认最小扫描周期2ms
+constexpr size_t MAX_PENDING_SAMPLES = 1 << 20;               // 待检测样本队列上限
+constexpr std::chrono::milliseconds RECOVERY_STEP_INTERVAL(1000); // 恢复爬坡步长间隔1s
 
 // 构造函数
 AnomalyMonitoringController::AnomalyMonitoringController() 
     : enabled_(false),
+      full_scan_(true),
+      rescan_requested_(false),
+      dropped_samples_(0),
+      restored_anomalies_(0),
+      checkpoint_interval_(0),
+      checkpoint_restore_us_(-1),
+      timer_epoch_(std::chrono::steady_clock::now()),
       normal_voltage_(220.0),
       normal_frequency_(50.0),
       max_hydrogen_concentration_(1.0),
       max_hydrogen_pressure_(1.5),
       anomaly_duration_threshold_ms_(5000), // 5秒
-      running_(false) {}
+      recovery_rate_percent_per_minute_(5.0), // 5%/分钟
+      rules_dirty_(true),
+      statistic_overflows_(0),
+      next_setpoint_batch_(1),
+      setpoints_pending_(false),
+      running_(false),
+      initialized_(false),
+      wake_pending_(false),
+      pending_since_ns_(0),
+      min_scan_period_us_(DEFAULT_MIN_SCAN_PERIOD.count()),
+      scan_trigger_ns_(0),
+      scan_count_(0),
+      event_wakeups_(0),
+      detection_count_(0),
+      confirmed_anomalies_(0),
+      transient_anomalies_(0),
+      pending_anomalies_(0),
+      suppressed_transitions_(0),
+      voltage_events_(0),
+      setpoint_batches_(0),
+      issued_setpoints_(0),
+      coalesced_setpoints_(0),
+      last_latency_us_(0),
+      max_latency_us_(0),
+      total_latency_us_(0),
+      last_scan_us_(0),
+      max_scan_us_(0) {
+    std::fill(std::begin(forecast_horizon_ms_), std::end(forecast_horizon_ms_), -1);
+    rules_.loadBuiltinRules();
+    dispatcher_.setFormatter([this](const ControllerEvent& event, std::string& text) {
+        formatEvent(event, text);
+    });
+}
 
 // 析构函数
 AnomalyMonitoringController::~AnomalyMonitoringController() {
-    running_ = false; // 停止运行标志
+    shutdown(); // 停止运行标志
+}
+
+// 请求停止监测循环
+void AnomalyMonitoringController::shutdown() {
+    running_ = false;
+    wakeMonitor();
+}
+
+namespace {
+
+int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t toMicros(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+}
+
+// 以异常信息构造事件记录
+ControllerEvent anomalyEvent(ControllerEventKind kind, const AnomalyInfo& anomaly) {
+    ControllerEvent event{};
+    event.kind = kind;
+    event.type = anomaly.type;
+    event.level = anomaly.level;
+    event.rule = anomaly.rule_id;
+    event.key = anomaly.key;
+    event.device = anomaly.device_index;
+    event.detail = anomaly.detail;
+    event.anomaly_start_us = toMicros(anomaly.start_time);
+    return event;
+}
+
+// 原子地更新最大值
+void updateMax(std::atomic<int64_t>& target, int64_t value) {
+    int64_t current = target.load(std::memory_order_relaxed);
+    while (value > current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+} // namespace
+
+// 状态变化（使能、停止）时唤醒监测线程：
+// 先改标志，再经互斥锁同步，保证等待方不会错过通知
+void AnomalyMonitoringController::wakeMonitor() {
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+    }
+    wake_cv_.notify_all();
+}
+
+// 新数据到达：仅本轮首个到达者短暂获取唤醒锁，其余生产者只做一次原子交换
+void AnomalyMonitoringController::notifyTelemetry() {
+    int64_t expected = 0;
+    pending_since_ns_.compare_exchange_strong(expected, steadyNowNs(), std::memory_order_relaxed);
+    if (!wake_pending_.exchange(true, std::memory_order_acq_rel)) {
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex_);
+        }
+        wake_cv_.notify_one();
+    }
+}
+
+// 记录检测时延：从本轮数据到达到检出异常
+void AnomalyMonitoringController::recordDetection() {
+    detection_count_.fetch_add(1, std::memory_order_relaxed);
+    if (scan_trigger_ns_ == 0) {
+        return; // 定时扫描检出，无对应的数据到达时间
+    }
+    int64_t latency_us = (steadyNowNs() - scan_trigger_ns_) / 1000;
+    last_latency_us_.store(latency_us, std::memory_order_relaxed);
+    total_latency_us_.fetch_add(latency_us, std::memory_order_relaxed);
+    updateMax(max_latency_us_, latency_us);
+}
+
+// 设置最小扫描周期
+void AnomalyMonitoringController::setMinScanPeriod(std::chrono::microseconds period) {
+    min_scan_period_us_ = std::max<int64_t>(0, period.count());
+}
+
+// 获取运行指标
+MonitoringMetrics AnomalyMonitoringController::getMetrics() const {
+    MonitoringMetrics metrics;
+    metrics.scan_count = scan_count_.load(std::memory_order_relaxed);
+    metrics.event_wakeups = event_wakeups_.load(std::memory_order_relaxed);
+    metrics.detection_count = detection_count_.load(std::memory_order_relaxed);
+    metrics.confirmed_anomalies = confirmed_anomalies_.load(std::memory_order_relaxed);
+    metrics.transient_anomalies = transient_anomalies_.load(std::memory_order_relaxed);
+    metrics.pending_anomalies = pending_anomalies_.load(std::memory_order_relaxed);
+    metrics.suppressed_transitions = suppressed_transitions_.load(std::memory_order_relaxed);
+    metrics.voltage_events = voltage_events_.load(std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(anomaly_mutex_);
+        metrics.history_records = anomaly_history_.size();
+        metrics.history_evicted = anomaly_history_.evictedCount();
+        metrics.history_memory_bytes = anomaly_history_.memoryUsage();
+    }
+    JournalStats journal = journal_.stats();
+    metrics.journal_committed = journal.committed;
+    metrics.journal_dropped = journal.dropped;
+    metrics.journal_write_failures = journal.write_failures;
+    metrics.restored_anomalies = restored_anomalies_.load(std::memory_order_relaxed);
+    metrics.checkpoint_saves = checkpoint_store_.savedCount();
+    metrics.checkpoint_restore_us = checkpoint_restore_us_.load(std::memory_order_relaxed);
+    metrics.setpoint_batches = setpoint_batches_.load(std::memory_order_relaxed);
+    metrics.issued_setpoints = issued_setpoints_.load(std::memory_order_relaxed);
+    metrics.coalesced_setpoints = coalesced_setpoints_.load(std::memory_order_relaxed);
+    metrics.callback_dispatch = dispatcher_.metrics();
+    metrics.last_detection_latency_us = last_latency_us_.load(std::memory_order_relaxed);
+    metrics.max_detection_latency_us = max_latency_us_.load(std::memory_order_relaxed);
+    metrics.mean_detection_latency_us = metrics.detection_count == 0 ? 0 :
+        total_latency_us_.load(std::memory_order_relaxed) / static_cast<int64_t>(metrics.detection_count);
+    metrics.last_scan_duration_us = last_scan_us_.load(std::memory_order_relaxed);
+    metrics.max_scan_duration_us = max_scan_us_.load(std::memory_order_relaxed);
+    metrics.dropped_samples = dropped_samples_.load(std::memory_order_relaxed);
+    metrics.telemetry_read_retries = telemetry_.readRetries();
+    metrics.statistic_overflows = statistic_overflows_.load(std::memory_order_relaxed);
+    return metrics;
 }
 
 // 初始化系统
 bool AnomalyMonitoringController::initialize() {
+    {
+        std::lock_guard<std::mutex> lock(status_mutex_);
+        if (!registry_.isFrozen()) {
+            if (registry_.totalDeviceCount() == 0) {
+                registerDefaultDevices(); // 未注册设备时使用默认站点配置
+            }
+            registry_.freeze(); // 冻结设备集合
+            telemetry_.allocate(registry_);
+            scan_table_.allocate(registry_);
+            changed_rows_.allocate(registry_);
+            createDerivedDetectors();
+            
+            // 兼容接口使用的默认设备
+            legacy_devices_.pv = registry_.find("PV_Inverter");
+            legacy_devices_.wind = registry_.find("Wind_Controller");
+            legacy_devices_.ess = registry_.find("ESS_PCS");
+            legacy_devices_.electrolyzer = registry_.find("Electrolyzer");
+            legacy_devices_.grid = registry_.find("Grid");
+            legacy_devices_.hydrogen = registry_.find("Hydrogen_System");
+            initialized_.store(true, std::memory_order_release); // 发布已分配的存储
+        }
+        std::unordered_set<AnomalyKey> replayed;
+        std::unordered_map<AnomalyKey, AnomalyInfo> journal_pending;
+        if (!journal_path_.empty() && !journal_.isOpen() && !restoreFromJournal(replayed, journal_pending)) {
+            return false; // 异常日志无法打开，可修正后重试
+        }
+        if (!checkpoint_path_.empty() && !checkpoint_store_.isOpen()) {
+            checkpoint_store_.open(checkpoint_path_);
+            restoreCheckpoint(replayed, journal_pending); // 在异常日志之后：同一异常以日志为准，只补充计时状态
+        }
+        discardJournalPending(journal_pending);
+    }
+    dispatcher_.start(); // 启动回调分发线程
+    // 启动恢复爬坡调度器：设定值与完成通知均在调度线程执行，不阻塞监测线程；
+    // 到期的设定值并入本轮批次，与处置动作按控制目标合并
+    ramp_scheduler_.start(
+        [this](const std::vector<RampState>& steps) { mergeRampSteps(steps); },
+        [this](const RampState& ramp) { onRampComplete(ramp); });
+    
     running_ = true; // 设置运行标志
     return true;
 }
 
+// 注册默认站点设备（与SystemStatus字段一一对应）
+void AnomalyMonitoringController::registerDefaultDevices() {
+    registry_.registerDevice(DeviceClass::PV_INVERTER, "PV_Inverter", 100.0, "PV");
+    registry_.registerDevice(DeviceClass::WIND_CONTROLLER, "Wind_Controller", 100.0, "WIND");
+    registry_.registerDevice(DeviceClass::ESS_PCS, "ESS_PCS", 100.0, "ESS");
+    registry_.registerDevice(DeviceClass::ELECTROLYZER, "Electrolyzer", 100.0, "HYDROGEN");
+    registry_.registerDevice(DeviceClass::GRID, "Grid", 100.0, "GRID");
+    registry_.registerDevice(DeviceClass::HYDROGEN_SYSTEM, "Hydrogen_System", 100.0, "HYDROGEN");
+}
+
+// 注册设备
+DeviceIndex AnomalyMonitoringController::registerDevice(DeviceClass device_class,
+                                                        const std::string& name,
+                                                        double rated_power_kw,
+                                                        const std::string& control_target) {
+    std::lock_guard<std::mutex> lock(status_mutex_);
+    return registry_.registerDevice(device_class, name, rated_power_kw, control_target);
+}
+
+// 登记检测规则
+bool AnomalyMonitoringController::addAnomalyRule(const AnomalyRuleSpec& rule) {
+    std::lock_guard<std::mutex> lock(status_mutex_);
+    if (registry_.isFrozen() || !rules_.addRule(rule)) {
+        return false; // 已初始化，或标识重复、无效
+    }
+    rules_dirty_ = true;
+    return true;
+}
+
+// 设置规则滞回
+bool AnomalyMonitoringController::setRuleHysteresis(RuleId rule, ThresholdBand clear,
+                                                    std::chrono::milliseconds min_clear_time) {
+    if (!(clear.low < clear.high) || min_clear_time.count() < 0) {
+        return false; // 恢复带为空
+    }
+    std::lock_guard<std::mutex> lock(status_mutex_);
+    int32_t min_clear_ms = static_cast<int32_t>(std::min<int64_t>(min_clear_time.count(), INT32_MAX));
+    if (!rules_.setHysteresis(rule, clear, min_clear_ms)) {
+        return false;
+    }
+    rules_dirty_ = true; // 下一轮扫描前重新编译
+    return true;
+}
+
+// 设置趋势预测时域
+bool AnomalyMonitoringController::setForecastHorizon(TelemetryChannel source, std::chrono::milliseconds horizon) {
+    if (horizon.count() < 0 || source >= TelemetryChannel::COUNT) {
+        return false;
+    }
+    bool found = false;
+    for (const ForecastSpec& spec : builtinForecasters()) {
+        found = found || spec.source == source;
+    }
+    if (!found) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(status_mutex_);
+    forecast_horizon_ms_[static_cast<size_t>(source)] =
+        static_cast<int32_t>(std::min<int64_t>(horizon.count(), INT32_MAX));
+    rules_dirty_ = true; // 下一轮扫描前由监测线程应用
+    return true;
+}
+
+// 设置异常历史保留策略
+void AnomalyMonitoringController::setHistoryRetention(const HistoryRetention& retention) {
+    std::lock_guard<std::mutex> lock(anomaly_mutex_);
+    anomaly_history_.setRetention(retention);
+}
+
+// 查询异常历史
+std::vector<AnomalyInfo> AnomalyMonitoringController::queryAnomalyHistory(const AnomalyHistoryQuery& query) const {
+    std::lock_guard<std::mutex> lock(anomaly_mutex_);
+    return anomaly_history_.query(query);
+}
+
+// 启用异常日志
+bool AnomalyMonitoringController::enableJournal(const std::string& path) {
+    std::lock_guard<std::mutex> lock(status_mutex_);
+    if (registry_.isFrozen() || path.empty()) {
+        return false;
+    }
+    journal_path_ = path;
+    return true;
+}
+
+// 启用状态检查点
+bool AnomalyMonitoringController::enableCheckpoint(const std::string& path, std::chrono::milliseconds interval) {
+    std::lock_guard<std::mutex> lock(status_mutex_);
+    if (registry_.isFrozen() || path.empty() || interval.count() < 0) {
+        return false;
+    }
+    checkpoint_path_ = path;
+    checkpoint_interval_ = interval;
+    return true;
+}
+
+// 按名称查找设备
+DeviceIndex AnomalyMonitoringController::findDevice(const std::string& name) const {
+    return registry_.find(name);
+}
+
 // 1.主监测循环
 void AnomalyMonitoringController::runMonitoringLoop() {
+    auto last_scan = std::chrono::steady_clock::now() - MONITORING_INTERVAL;
+    auto next_timer = std::chrono::steady_clock::time_point::max(); // 最早的确认定时器到期或恢复计时届满时间
+    std::chrono::milliseconds checkpoint_interval(0);
+    {
+        std::lock_guard<std::mutex> lock(status_mutex_);
+        checkpoint_interval = checkpoint_interval_;
+        // 续接检查点中的恢复爬坡（此时回调已注册），从保存时的设定功率继续
+        for (const RampState& ramp : restored_ramps_) {
+            ramp_scheduler_.startRamp(ramp.device, ramp.tag, ramp.current_kw, ramp.target_kw,
+                                      ramp.step_kw, ramp.step_interval);
+        }
+        restored_ramps_.clear();
+    }
+    auto next_checkpoint = std::chrono::steady_clock::now() + checkpoint_interval;
     while (running_) {
-        // 1.检查是否使能
         if (!enabled_) {
-            std::this_thread::sleep_for(std::chrono::seconds(1)); // 未使能时休眠1秒
-            continue;
+            flushSetpoints(); // 未使能期间爬坡调度线程自行下发，此前并入的由此下发
         }
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            // 1.检查是否使能：未使能时等待使能或停止请求
+            if (!enabled_) {
+                wake_cv_.wait(lock, [this]() { return !running_ || enabled_; });
+                continue;
+            }
+            // 等待新数据、最长监测间隔、确认定时器到期或恢复计时届满、待下发的爬坡设定值、停止请求
+            wake_cv_.wait_until(lock, std::min(last_scan + MONITORING_INTERVAL, next_timer), [this]() {
+                return !running_ || !enabled_ || wake_pending_.load(std::memory_order_acquire) ||
+                    setpoints_pending_.load(std::memory_order_acquire);
+            });
+            if (!running_ || !enabled_) {
+                continue;
+            }
+            // 连续数据流下按最小扫描周期限速（停止请求仍可立即打断）
+            auto earliest = last_scan + std::chrono::microseconds(min_scan_period_us_.load());
+            wake_cv_.wait_until(lock, earliest, [this]() { return !running_; });
+            if (!running_) {
+                break;
+            }
+        }
+        // 本轮开始前清除唤醒标志，扫描期间到达的数据将触发下一轮
+        bool event_triggered = wake_pending_.exchange(false, std::memory_order_acq_rel);
+        scan_trigger_ns_ = pending_since_ns_.exchange(0, std::memory_order_relaxed);
+        last_scan = std::chrono::steady_clock::now();
+        if (event_triggered) {
+            event_wakeups_.fetch_add(1, std::memory_order_relaxed);
+        }
+        
         // 2.检查异常
         checkAnomalies();
         // 3.检查异常恢复
-        std::vector<std::string> resolved_anomalies; // 已解决的异常列表
+        std::vector<AnomalyInfo> resolved_anomalies; // 已解决的异常列表
+        int64_t next_clear_ms = TimingWheel::NO_DEADLINE; // 最早的恢复计时届满时间
         {
             std::lock_guard<std::mutex> lock(anomaly_mutex_); // 加锁保护异常数据
-            for (auto& [id, anomaly] : active_anomalies_) {
-                if (isAnomalyResolved(anomaly)) { // 检查异常是否已解决
-                    resolved_anomalies.push_back(id); // 添加到已解决列表
-                    anomaly.end_time = std::chrono::system_clock::now(); // 设置结束时间
-                    anomaly_history_.push_back(anomaly); // 添加到历史记录
-                    
-                    if (status_callback_) {
-                        status_callback_("异常已解除: " + anomaly.description); // 回调通知
+            int64_t now_ms = timerNowMs();
+            for (size_t i = 0; i < active_anomalies_.size();) {
+                AnomalyInfo& anomaly = active_anomalies_.at(i);
+                const CompiledRule* rule = rules_.compiled(anomaly.rule_id);
+                if (anomaly.awaiting_confirmation || (rule != nullptr && rule->event_driven)) {
+                    ++i; // 等待人工确认，或由事件结束时解除
+                    continue;
+                }
+                // 确认窗口内回到恢复条件的瞬态异常：取消确认定时器，不通知、不记录历史
+                if (anomaly.state == AnomalyState::PENDING) {
+                    if (!isAnomalyResolved(anomaly)) {
+                        ++i;
+                        continue;
                     }
+                    pending_timers_.cancel(anomaly.pending_timer);
+                    pending_anomalies_.fetch_sub(1, std::memory_order_relaxed);
+                    transient_anomalies_.fetch_add(1, std::memory_order_relaxed);
+                    journalAnomaly(JournalEvent::DISCARDED, anomaly);
+                    active_anomalies_.erase(anomaly.key);
+                    continue;
                 }
-            }
-            // 移除已解除的异常
-            for (const auto& id : resolved_anomalies) {
-                active_anomalies_.erase(id); // 从活动异常中移除
+                if (!isClearSustained(anomaly, now_ms, next_clear_ms)) { // 检查异常是否已解决（含滞回）
+                    ++i;
+                    continue;
+                }
+                anomaly.end_time = std::chrono::system_clock::now(); // 设置结束时间
                 
-                // 处理异常恢复
-                auto it = std::find_if(anomaly_history_.begin(), anomaly_history_.end(),
-                                      [&](const AnomalyInfo& a) { return a.description == id; });
-                if (it != anomaly_history_.end()) {
-                    handleAnomalyRecovery(*it); // 处理异常恢复
+                postAnomalyEvent(ControllerEventKind::ANOMALY_CLEARED, anomaly); // 回调通知
+                // 安全异常需要人工确认：保留在活动表中等待确认
+                if (anomaly.type == AnomalyType::SAFETY_FAULT && anomaly.needs_manual_confirmation) {
+                    anomaly.awaiting_confirmation = true;
+                    journalAnomaly(JournalEvent::UPDATED, anomaly);
+                    postAnomalyEvent(ControllerEventKind::CONFIRMATION_REQUIRED, anomaly);
+                    ++i;
+                    continue;
                 }
+                anomaly_history_.append(anomaly); // 添加到历史记录
+                journalAnomaly(JournalEvent::CLOSED, anomaly);
+                resolved_anomalies.push_back(anomaly); // 添加到已解决列表
+                active_anomalies_.erase(anomaly.key); // 从活动异常中移除（末尾记录补入当前位置）
             }
         }
-        std::this_thread::sleep_for(MONITORING_INTERVAL); // 按监测间隔100s休眠
+        // 处理异常恢复（仅提交爬坡任务，不阻塞监测线程）
+        for (const auto& anomaly : resolved_anomalies) {
+            handleAnomalyRecovery(anomaly);
+        }
+        // 4.确认持续满确认窗口的异常
+        int64_t next_ms = std::min(confirmPendingAnomalies(), next_clear_ms);
+        flushSafetyActions(); // 安全操作先于功率设定入队
+        flushSetpoints(); // 本轮的功率设定合并后一次下发
+        next_timer = next_ms == TimingWheel::NO_DEADLINE ? std::chrono::steady_clock::time_point::max() :
+            timer_epoch_ + std::chrono::milliseconds(next_ms);
+        
+        int64_t scan_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - last_scan).count();
+        last_scan_us_.store(scan_us, std::memory_order_relaxed);
+        updateMax(max_scan_us_, scan_us);
+        scan_count_.fetch_add(1, std::memory_order_relaxed);
+        
+        // 5.定期保存状态检查点（采集后交给后台线程写入）
+        if (checkpoint_store_.isOpen() && checkpoint_interval.count() > 0 &&
+            std::chrono::steady_clock::now() >= next_checkpoint) {
+            checkpoint_store_.saveAsync(captureCheckpoint(false));
+            next_checkpoint = std::chrono::steady_clock::now() + checkpoint_interval;
+        }
     }
+    if (checkpoint_store_.isOpen()) {
+        checkpoint_store_.save(captureCheckpoint(true)); // 停机检查点：同步写入
+    }
+    flushSetpoints(); // 退出前并入的爬坡设定值
+    dispatcher_.flush(); // 投递完停机前产生的回调
 }
 
-// 2.检查异常
+// 2.检查异常：按编译后的规则执行计划逐列扫描
 void AnomalyMonitoringController::checkAnomalies() {
-    SystemStatus status;
+    if (rules_dirty_.exchange(false)) {
+        compileRules(); // 控制参数已变化
+        full_scan_ = true; // 阈值已变化，全部设备重新判定
+    }
+    if (rescan_requested_.exchange(false)) {
+        full_scan_ = true;
+    }
+    
+    // 逐个检测自上轮以来批量接入的样本，短时尖峰不会被后续样本覆盖
     {
-        std::lock_guard<std::mutex> lock(status_mutex_); // 加锁获取当前状态
-        status = current_status_;
+        std::lock_guard<std::mutex> lock(sample_mutex_);
+        draining_samples_.swap(pending_samples_);
+        draining_voltage_events_.swap(pending_voltage_events_);
     }
+    for (const TelemetrySample& sample : draining_samples_) {
+        checkSampleValue(sample.device, sample.channel, sample.value, sample.timestamp);
+        checkDerivedSample(sample);
+    }
+    draining_samples_.clear(); // 保留容量，稳态下不再分配
+    for (const TimedVoltageEvent& event : draining_voltage_events_) {
+        handleVoltageEvent(event);
+    }
+    draining_voltage_events_.clear();
+    
+    telemetry_.collectChanges(scan_table_, changed_rows_); // 无锁获取有写入设备的一致快照
     
     auto now = std::chrono::system_clock::now(); // 当前时间
+    updateDerivedChannels();
+    updateStatisticStreams();
     
-    // 检查设备故障
-    if (status.pv_inverter_fault) {
-        AnomalyInfo anomaly;
-        anomaly.type = AnomalyType::DEVICE_FAULT;
-        anomaly.level = AnomalyLevel::CRITICAL;
-        anomaly.device_id = "PV_Inverter";
-        anomaly.description = "光伏逆变器故障";
-        anomaly.start_time = now;
-        anomaly.is_handled = false;
-        anomaly.needs_manual_confirmation = false;
-        
-        handleAnomaly(anomaly); // 处理异常
+    // 每条规则以向量化内核比较取值与阈值，得到越限位图；只有越限设备进入逐台处理。
+    // 源通道取值只在写入时变化，派生通道与统计量只在接入样本时变化，
+    // 仅判定本轮取值有变化的设备，扫描量与变化率成正比
+    for (const CompiledRule& rule : rules_.plan()) {
+        if (rule.event_driven) {
+            continue;
+        }
+        const double* values = ruleValues(rule);
+        auto on_violation = [&](size_t row, int level) {
+            raiseAnomaly(rule, makeDeviceIndex(rule.device_class, static_cast<uint32_t>(row)),
+                         level, values[row], now);
+        };
+        if (full_scan_) {
+            scanRule(rule, values, screen_mask_.data(), on_violation);
+        } else {
+            scanRuleChanged(rule, values, ruleChanges(rule), on_violation);
+        }
     }
-    
-    if (status.wind_controller_fault) {
-        AnomalyInfo anomaly;
-        anomaly.type = AnomalyType::DEVICE_FAULT;
-        anomaly.level = AnomalyLevel::CRITICAL;
-        anomaly.device_id = "Wind_Controller";
-        anomaly.description = "风机控制器故障";
-        anomaly.start_time = now;
-        anomaly.is_handled = false;
-        anomaly.needs_manual_confirmation = false;
-        
-        handleAnomaly(anomaly);
+    changed_rows_.clear();
+    for (StatisticStream& stream : statistic_streams_) {
+        std::fill(stream.changed.begin(), stream.changed.end(), 0);
+    }
+    full_scan_ = false;
+}
+
+// 带时间戳的样本按采集时间接入变化率与漂移检测器，派生值立即按规则检测（不等整列扫描）
+void AnomalyMonitoringController::checkDerivedSample(const TelemetrySample& sample) {
+    size_t device_class = static_cast<size_t>(deviceClassOf(sample.device));
+    size_t channel = static_cast<size_t>(sample.channel);
+    int detector = rate_detector_of_[device_class][channel];
+    if (detector >= 0) {
+        RateOfChangeDetector& rate_detector = rate_detectors_[static_cast<size_t>(detector)];
+        double rate = rate_detector.update(localIndexOf(sample.device), toMicros(sample.timestamp), sample.value);
+        checkSampleValue(sample.device, rate_detector.spec().output, rate, sample.timestamp);
+    }
+    detector = drift_detector_of_[device_class][channel];
+    if (detector >= 0) {
+        DriftDetector& drift_detector = drift_detectors_[static_cast<size_t>(detector)];
+        double drift = drift_detector.update(localIndexOf(sample.device), toMicros(sample.timestamp), sample.value);
+        checkSampleValue(sample.device, drift_detector.spec().output, drift, sample.timestamp);
+    }
+    detector = forecaster_of_[device_class][channel];
+    if (detector >= 0) {
+        TrendForecaster& forecaster = forecasters_[static_cast<size_t>(detector)];
+        double forecast = forecaster.update(localIndexOf(sample.device), toMicros(sample.timestamp), sample.value);
+        checkSampleValue(sample.device, forecaster.spec().output, forecast, sample.timestamp);
+    }
+}
+
+// 单个样本先接入该通道的统计流，再按规则检测（使用统计量的规则取更新后的统计值）
+void AnomalyMonitoringController::checkSampleValue(DeviceIndex device, TelemetryChannel channel, double value,
+                                                   std::chrono::system_clock::time_point time) {
+    DeviceClass device_class = deviceClassOf(device);
+    uint32_t row = localIndexOf(device);
+    const std::vector<uint32_t>& streams =
+        streams_of_channel_[static_cast<size_t>(device_class)][static_cast<size_t>(channel)];
+    if (!streams.empty()) {
+        int64_t time_us = toMicros(time);
+        for (uint32_t stream : streams) {
+            statistic_streams_[stream].stats.update(row, time_us, value);
+        }
+    }
+    const CompiledRule* last = rules_.rulesEnd(device_class, channel);
+    for (const CompiledRule* rule = rules_.rulesBegin(device_class, channel); rule != last; ++rule) {
+        int32_t stream = rule_streams_[rule->id];
+        double rule_value = stream < 0 ? value : statistic_streams_[static_cast<size_t>(stream)].stats.value(row);
+        int level = classifyValue(*rule, row, rule_value);
+        if (level >= 0) {
+            raiseAnomaly(*rule, device, level, rule_value, time);
+        }
+    }
+}
+
+// 电压暂降/暂升事件：开始与加深时按事件等级产生异常（起始时间为越限时刻），
+// 结束时以恢复时刻为结束时间解除，并按EN 50160表格记录幅值与持续时间分档
+void AnomalyMonitoringController::handleVoltageEvent(const TimedVoltageEvent& timed) {
+    const VoltageEvent& event = timed.event;
+    bool is_dip = event.type == VoltageEventType::DIP;
+    const CompiledRule* rule = rules_.compiled(is_dip ? RULE_VOLTAGE_DIP : RULE_VOLTAGE_SWELL);
+    if (rule == nullptr) {
+        return;
+    }
+    double voltage = event.magnitude_pu * normal_voltage_;
+    if (event.phase != VoltageEventPhase::END) {
+        bool critical = is_dip ? event.magnitude_pu < 0.7 : event.magnitude_pu >= 1.2;
+        raiseAnomaly(*rule, timed.device, static_cast<int>(critical ? AnomalyLevel::CRITICAL : AnomalyLevel::WARNING),
+                     voltage, timed.time);
+        return;
     }
     
-    if (status.ess_pcs_fault) {
-        AnomalyInfo anomaly;
-        anomaly.type = AnomalyType::DEVICE_FAULT;
-        anomaly.level = AnomalyLevel::CRITICAL;
-        anomaly.device_id = "ESS_PCS";
-        anomaly.description = "储能PCS故障";
-        anomaly.start_time = now;
+    voltage_events_.fetch_add(1, std::memory_order_relaxed);
+    double duration_ms = std::chrono::duration<double, std::milli>(timed.time - timed.start_time).count();
+    AnomalyInfo resolved;
+    {
+        std::lock_guard<std::mutex> lock(anomaly_mutex_);
+        AnomalyInfo* anomaly = active_anomalies_.find(makeAnomalyKey(rule->id, timed.device));
+        if (anomaly == nullptr) {
+            return;
+        }
+        if (anomaly->state == AnomalyState::PENDING) {
+            pending_timers_.cancel(anomaly->pending_timer);
+            pending_anomalies_.fetch_sub(1, std::memory_order_relaxed);
+            transient_anomalies_.fetch_add(1, std::memory_order_relaxed);
+        }
+        anomaly->value = voltage;
+        anomaly->detail = AnomalyDetail();
+        anomaly->detail.value = voltage;
+        anomaly->detail.magnitude_pu = event.magnitude_pu;
+        anomaly->detail.duration_ms = duration_ms;
+        anomaly->detail.phase_mask = event.phase_mask;
+        describeAnomaly(*anomaly);
+        anomaly->start_time = timed.start_time;
+        anomaly->end_time = timed.time;
+        postAnomalyEvent(ControllerEventKind::ANOMALY_CLEARED, *anomaly);
+        bool activated = anomaly->state == AnomalyState::ACTIVE;
+        resolved = *anomaly;
+        if (activated) {
+            anomaly_history_.append(resolved);
+        }
+        journalAnomaly(activated ? JournalEvent::CLOSED : JournalEvent::DISCARDED, resolved);
+        active_anomalies_.erase(resolved.key);
+        if (!activated) {
+            return; // 未确认即结束，未执行处置动作
+        }
+    }
+    handleAnomalyRecovery(resolved);
+}
+
+// 快照后更新统计流（在派生通道之后，派生通道也可统计）：只接入本轮有写入的设备，按其采集时间
+void AnomalyMonitoringController::updateStatisticStreams() {
+    uint64_t overflows = 0;
+    for (StatisticStream& stream : statistic_streams_) {
+        stream.stats.updateColumn(scan_table_.column(stream.device_class, stream.channel),
+                                  scan_table_.sampleTimes(stream.device_class),
+                                  changed_rows_.words(stream.device_class, stream.channel),
+                                  stream.changed.data(), stream.stats.rows());
+        overflows += stream.stats.overflows();
+    }
+    statistic_overflows_.store(overflows, std::memory_order_relaxed);
+}
+
+const double* AnomalyMonitoringController::ruleValues(const CompiledRule& rule) const {
+    int32_t stream = rule_streams_[rule.id];
+    return stream < 0 ? scan_table_.column(rule.device_class, rule.channel) :
+        statistic_streams_[static_cast<size_t>(stream)].stats.output();
+}
+
+const uint64_t* AnomalyMonitoringController::ruleChanges(const CompiledRule& rule) {
+    int32_t stream = rule_streams_[rule.id];
+    return stream < 0 ? changed_rows_.words(rule.device_class, rule.channel) :
+        statistic_streams_[static_cast<size_t>(stream)].changed.data();
+}
+
+double AnomalyMonitoringController::ruleValue(const CompiledRule& rule, DeviceIndex device) const {
+    return ruleValues(rule)[localIndexOf(device)];
+}
+
+// 派生通道不在共享存储中，快照后由检测器状态补齐，随后与其他通道一同扫描
+// 派生通道只接入本轮有写入的设备，按各自的采集时间（带时间戳样本已逐个接入，同一时刻不再重复）；
+// 输出有变化的设备记入派生通道的变更位，其规则与统计流同源通道一样只处理变更设备
+void AnomalyMonitoringController::updateDerivedChannels() {
+    for (RateOfChangeDetector& detector : rate_detectors_) {
+        const RateDetectorSpec& spec = detector.spec();
+        detector.updateColumn(scan_table_.column(spec.device_class, spec.source),
+                              scan_table_.sampleTimes(spec.device_class),
+                              changed_rows_.words(spec.device_class, spec.source),
+                              scan_table_.column(spec.device_class, spec.output),
+                              changed_rows_.words(spec.device_class, spec.output),
+                              scan_table_.rowCount(spec.device_class));
+    }
+    for (DriftDetector& detector : drift_detectors_) {
+        const DriftDetectorSpec& spec = detector.spec();
+        detector.updateColumn(scan_table_.column(spec.device_class, spec.source),
+                              scan_table_.sampleTimes(spec.device_class),
+                              changed_rows_.words(spec.device_class, spec.source),
+                              scan_table_.column(spec.device_class, spec.output),
+                              changed_rows_.words(spec.device_class, spec.output),
+                              scan_table_.rowCount(spec.device_class));
+    }
+    for (TrendForecaster& forecaster : forecasters_) {
+        const ForecastSpec& spec = forecaster.spec();
+        forecaster.updateColumn(scan_table_.column(spec.device_class, spec.source),
+                                scan_table_.sampleTimes(spec.device_class),
+                                changed_rows_.words(spec.device_class, spec.source),
+                                scan_table_.column(spec.device_class, spec.output),
+                                changed_rows_.words(spec.device_class, spec.output),
+                                scan_table_.rowCount(spec.device_class));
+    }
+}
+
+// 构造越限异常信息并处理
+void AnomalyMonitoringController::raiseAnomaly(const CompiledRule& rule, DeviceIndex device, int level,
+                                               double value, std::chrono::system_clock::time_point time) {
+    AnomalyInfo anomaly;
+    anomaly.key = makeAnomalyKey(rule.id, device);
+    anomaly.rule_id = rule.id;
+    anomaly.type = rule.type;
+    anomaly.level = static_cast<AnomalyLevel>(level);
+    anomaly.state = AnomalyState::PENDING;
+    anomaly.pending_timer = TimingWheel::INVALID_TIMER;
+    anomaly.device_index = device;
+    anomaly.value = value;
+    anomaly.detail.value = value;
+    int forecaster = forecasterOfOutput(rule.device_class, rule.channel);
+    if (forecaster >= 0) {
+        // 预测类规则附带按当前估计到达该等级上限的时间
+        double limit = rule.high[level][localIndexOf(device) * rule.stride];
+        anomaly.detail.forecast_s =
+            forecasters_[static_cast<size_t>(forecaster)].timeToReach(localIndexOf(device), limit);
+    }
+    anomaly.start_time = time;
+    anomaly.is_handled = false;
+    anomaly.needs_manual_confirmation = rule.needs_manual_confirmation;
+    anomaly.awaiting_confirmation = false;
+    anomaly.hysteresis_hold = false;
+    anomaly.clear_since_ms = -1;
+    handleAnomaly(anomaly); // 处理异常
+}
+
+// 3.处理异常：首次出现进入待确认状态，持续满确认窗口后才确认并执行动作
+void AnomalyMonitoringController::handleAnomaly(const AnomalyInfo& detected) {
+    std::lock_guard<std::mutex> lock(anomaly_mutex_); // 加锁保护异常数据
+    // 按异常键查找：同一规则同一设备只保留一条活动异常，测量值漂移不产生新异常
+    bool inserted = false;
+    AnomalyInfo& anomaly = *active_anomalies_.insert(detected, inserted);
+    if (inserted) {
+        recordDetection(); // 新异常
+        anomaly.device_id = registry_.info(anomaly.device_index).name;
+        describeAnomaly(anomaly); // 描述文本只在新异常与等级升高时生成
+        journalAnomaly(JournalEvent::RAISED, anomaly);
+        const CompiledRule* rule = rules_.compiled(anomaly.rule_id);
+        int64_t window_ms = rule != nullptr && rule->persistence_ms >= 0 ? rule->persistence_ms :
+            anomaly_duration_threshold_ms_.load();
+        if (window_ms <= 0) {
+            activateAnomaly(anomaly); // 无确认窗口，立即确认
+        } else {
+            anomaly.pending_timer = pending_timers_.arm(anomaly.key, timerNowMs() + window_ms);
+            pending_anomalies_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+    anomaly.value = detected.value; // 更新测量值
+    if (anomaly.hysteresis_hold) {
+        // 已离开越限带但未满足恢复条件期间再次越限：无滞回时此处会先解除再重新告警
+        suppressed_transitions_.fetch_add(1, std::memory_order_relaxed);
+        anomaly.hysteresis_hold = false;
+    }
+    anomaly.clear_since_ms = -1; // 恢复计时重新开始
+    bool reopened = anomaly.awaiting_confirmation;
+    if (reopened) {
+        anomaly.awaiting_confirmation = false; // 等待确认期间条件再次出现
+        anomaly.end_time = std::chrono::system_clock::time_point();
+    }
+    if (detected.level <= anomaly.level) {
+        if (reopened) {
+            journalAnomaly(JournalEvent::UPDATED, anomaly);
+        }
+        return; // 异常已存在，不重复处理
+    }
+    // 等级升高：待确认期间只记录最高等级，确认时按其处理；已确认的按新等级重新处理
+    anomaly.level = detected.level;
+    anomaly.detail = detected.detail;
+    describeAnomaly(anomaly);
+    if (anomaly.state == AnomalyState::ACTIVE) {
         anomaly.is_handled = false;
-        anomaly.needs_manual_confirmation = false;
-        
-        handleAnomaly(anomaly);
+        executeAnomalyActions(anomaly);
     }
+    journalAnomaly(JournalEvent::UPDATED, anomaly);
+}
+
+// 确认异常（持有anomaly_mutex_）
+void AnomalyMonitoringController::activateAnomaly(AnomalyInfo& anomaly) {
+    anomaly.state = AnomalyState::ACTIVE;
+    anomaly.pending_timer = TimingWheel::INVALID_TIMER;
+    confirmed_anomalies_.fetch_add(1, std::memory_order_relaxed);
+    // 异常确认后取消该设备正在进行的恢复爬坡
+    if (ramp_scheduler_.cancel(anomaly.device_index)) {
+        postAnomalyEvent(ControllerEventKind::RECOVERY_CANCELLED, anomaly);
+    }
+    executeAnomalyActions(anomaly);
+    journalAnomaly(JournalEvent::ACTIVATED, anomaly);
+}
+
+// 按规则表中该等级配置的动作处理（持有anomaly_mutex_）
+void AnomalyMonitoringController::executeAnomalyActions(AnomalyInfo& anomaly) {
+    const CompiledRule* rule = rules_.compiled(anomaly.rule_id);
+    uint32_t actions = rule == nullptr ? ACTION_NONE : rule->actions[static_cast<size_t>(anomaly.level)];
     
-    if (status.electrolyzer_fault) {
-        AnomalyInfo anomaly;
-        anomaly.type = AnomalyType::DEVICE_FAULT;
-        anomaly.level = AnomalyLevel::CRITICAL;
-        anomaly.device_id = "Electrolyzer";
-        anomaly.description = "电解槽故障";
-        anomaly.start_time = now;
-        anomaly.is_handled = false;
-        anomaly.needs_manual_confirmation = false;
-        
-        handleAnomaly(anomaly);
+    if (actions & ACTION_DERATE_HALF) {
+        double new_power = scan_table_.value(anomaly.device_index, TelemetryChannel::POWER) * 0.5;
+        postSetpoint(anomaly, new_power); // 功率减半
+    }
+    if (actions & ACTION_SHUTDOWN) {
+        postSetpoint(anomaly, 0.0); // 设备停机
+    }
+    if ((actions & ACTION_PROTECT_CRITICAL_LOAD) &&
+        scan_table_.value(anomaly.device_index, TelemetryChannel::ISLAND_MODE) > 0.5) {
+        postAnomalyEvent(ControllerEventKind::CRITICAL_LOAD_PROTECTED, anomaly);
+    }
+    if (actions & ACTION_START_VENTILATION) {
+        deferSafetyAction(SafetyAction::START_VENTILATION, anomaly);
+    }
+    if (actions & ACTION_START_PRESSURE_RELIEF) {
+        deferSafetyAction(SafetyAction::START_PRESSURE_RELIEF, anomaly);
+    }
+    if (actions & ACTION_ENTER_SAFE_MODE) {
+        deferSafetyAction(SafetyAction::ENTER_SAFE_MODE, anomaly);
+    }
+    postAnomalyEvent(ControllerEventKind::ANOMALY_ACTIVATED, anomaly, actions);
+    // 标记为已处理
+    anomaly.is_handled = true;
+}
+
+// 确认定时器到期：条件在确认窗口内未消失（否则定时器已在恢复检查中取消）
+int64_t AnomalyMonitoringController::confirmPendingAnomalies() {
+    std::lock_guard<std::mutex> lock(anomaly_mutex_);
+    pending_timers_.advance(timerNowMs(), [this](uint64_t key) {
+        AnomalyInfo* anomaly = active_anomalies_.find(key);
+        if (anomaly != nullptr && anomaly->state == AnomalyState::PENDING) {
+            pending_anomalies_.fetch_sub(1, std::memory_order_relaxed);
+            activateAnomaly(*anomaly);
+        }
+    });
+    return pending_timers_.nextExpiry();
+}
+
+int64_t AnomalyMonitoringController::timerNowMs() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - timer_epoch_).count();
+}
+
+// 4.处理异常恢复：按额定功率的设定速率爬坡，由爬坡调度器异步执行。
+// 只有执行过停机或降功率动作的异常才恢复出力（仅通风、泄压等动作的规则不改变设备功率）
+void AnomalyMonitoringController::handleAnomalyRecovery(const AnomalyInfo& anomaly) {
+    // 安全异常需要人工确认
+    if (anomaly.type == AnomalyType::SAFETY_FAULT && anomaly.needs_manual_confirmation) {
+        postAnomalyEvent(ControllerEventKind::CONFIRMATION_REQUIRED, anomaly);
+        return;
+    }
+    if (!hasPowerAction(anomaly)) {
+        return;
     }
     
-    // 检查电网电压异常
-    if (status.grid_voltage >= 1.1 * normal_voltage_ || status.grid_voltage <= 0.9 * normal_voltage_) {
-        AnomalyInfo anomaly;
-        anomaly.type = AnomalyType::GRID_FAULT;
-        anomaly.level = determineAnomalyLevel(AnomalyType::GRID_FAULT, status.grid_voltage);
-        anomaly.device_id = "Grid";
-        anomaly.description = "电网电压异常: " + std::to_string(status.grid_voltage) + "V";
-        anomaly.start_time = now;
-        anomaly.is_handled = false;
-        anomaly.needs_manual_confirmation = false;
-        
-        handleAnomaly(anomaly);
-    }
-    // 检查电网频率异常
-    if (status.grid_frequency >= 50.5 || status.grid_frequency <= 49.5) {
-        AnomalyInfo anomaly;
-        anomaly.type = AnomalyType::GRID_FAULT;
-        anomaly.level = determineAnomalyLevel(AnomalyType::GRID_FAULT, status.grid_frequency);
-        anomaly.device_id = "Grid";
-        anomaly.description = "电网频率异常: " + std::to_string(status.grid_frequency) + "Hz";
-        anomaly.start_time = now;
-        anomaly.is_handled = false;
-        anomaly.needs_manual_confirmation = false;
-        
-        handleAnomaly(anomaly);
+    // 按5%/分钟速率恢复系统出力
+    postAnomalyEvent(ControllerEventKind::RECOVERY_STARTED, anomaly);
+    
+    if (deviceClassOf(anomaly.device_index) == DeviceClass::GRID) {
+        // 电网恢复：先闭合并网开关，再逐步恢复功率
+        postSafetyAction(SafetyAction::CLOSE_GRID_SWITCH, anomaly);
     }
     
-    // 检查安全异常
-    //检查氢浓度
-    if (status.hydrogen_concentration >= max_hydrogen_concentration_) {
-        AnomalyInfo anomaly;
-        anomaly.type = AnomalyType::SAFETY_FAULT;
-        anomaly.level = determineAnomalyLevel(AnomalyType::SAFETY_FAULT, status.hydrogen_concentration);
-        anomaly.device_id = "Hydrogen_System";
-        anomaly.description = "氢浓度异常: " + std::to_string(status.hydrogen_concentration) + "%";
-        anomaly.start_time = now;
-        anomaly.is_handled = false;
-        anomaly.needs_manual_confirmation = true;
-        
-        handleAnomaly(anomaly);
-    }
-    //检查氢罐压力
-    if (status.hydrogen_tank_pressure >= max_hydrogen_pressure_) {
-        AnomalyInfo anomaly;
-        anomaly.type = AnomalyType::SAFETY_FAULT;
-        anomaly.level = determineAnomalyLevel(AnomalyType::SAFETY_FAULT, status.hydrogen_tank_pressure);
-        anomaly.device_id = "Hydrogen_System";
-        anomaly.description = "氢罐压力异常: " + std::to_string(status.hydrogen_tank_pressure) + "MPa";
-        anomaly.start_time = now;
-        anomaly.is_handled = false;
-        anomaly.needs_manual_confirmation = true;
-        
-        handleAnomaly(anomaly);
+    // 每步增量 = 额定功率 × 速率(%/分钟) / 60 × 步长(秒)
+    double rated_power = registry_.info(anomaly.device_index).rated_power_kw;
+    double step_seconds = std::chrono::duration<double>(RECOVERY_STEP_INTERVAL).count();
+    double step_kw = rated_power * (recovery_rate_percent_per_minute_ / 100.0) / 60.0 * step_seconds;
+    ramp_scheduler_.startRamp(anomaly.device_index, anomaly.key, recoveryStartPower(anomaly.device_index),
+                              rated_power, step_kw, RECOVERY_STEP_INTERVAL);
+}
+
+// 异常确认后各等级执行的动作：等级只升不降，取不高于当前等级的各级动作
+bool AnomalyMonitoringController::hasPowerAction(const AnomalyInfo& anomaly) const {
+    const AnomalyRuleSpec* spec = rules_.spec(anomaly.rule_id); // 初始化后规则定义的动作不再修改
+    if (spec == nullptr) {
+        return false;
+    }
+    uint32_t actions = ACTION_NONE;
+    for (size_t level = 0; level <= static_cast<size_t>(anomaly.level); ++level) {
+        actions |= spec->actions[level];
     }
+    return (actions & (ACTION_SHUTDOWN | ACTION_DERATE_HALF)) != 0;
 }
 
-// 3.处理异常
-void AnomalyMonitoringController::handleAnomaly(const AnomalyInfo& anomaly) {
-    std::lock_guard<std::mutex> lock(anomaly_mutex_); // 加锁保护异常数据
-    // 检查是否已存在相同异常
-    if (active_anomalies_.find(anomaly.description) != active_anomalies_.end()) {
-        return; // 异常已存在，不重复处理
+// 从最近下发给该设备控制目标的设定功率开始爬坡（降功率后不先降到0再回升）；
+// 未下发过设定时取实测功率，均无数据时从0开始
+double AnomalyMonitoringController::recoveryStartPower(DeviceIndex device) {
+    const std::string& target = registry_.info(device).control_target;
+    {
+        std::lock_guard<std::mutex> lock(anomaly_mutex_);
+        auto it = commanded_kw_.find(target);
+        if (it != commanded_kw_.end()) {
+            return std::max(0.0, it->second);
+        }
     }
-    // 添加新异常
-    active_anomalies_[anomaly.description] = anomaly;
-    // 检查异常持续时间
-    auto now = std::chrono::system_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - anomaly.start_time);//异常持续时间
-    if (duration.count() >= anomaly_duration_threshold_ms_) {
-        // 根据异常等级处理
-        switch (anomaly.level) {
-            case AnomalyLevel::INFO:
-                // 提示级：仅记录和通知
-                if (status_callback_) {
-                    status_callback_("提示级异常: " + anomaly.description);
-                }
-                break;
-                
-            case AnomalyLevel::WARNING:
-                // 一般级：设备功率减半
-                if (anomaly.device_id == "PV_Inverter") {
-                    double new_power = current_status_.pv_power * 0.5;
-                    if (control_callback_) {
-                        control_callback_("PV", new_power);
-                    }
-                } else if (anomaly.device_id == "Wind_Controller") {
-                    double new_power = current_status_.wind_power * 0.5;
-                    if (control_callback_) {
-                        control_callback_("WIND", new_power);
-                    }
-                } else if (anomaly.device_id == "ESS_PCS") {
-                    double new_power = current_status_.ess_power * 0.5;
-                    if (control_callback_) {
-                        control_callback_("ESS", new_power);
-                    }
-                }
-                
-                if (status_callback_) {
-                    status_callback_("一般级异常: " + anomaly.description + ", 设备功率减半");
-                }
-                break;
-                
-            case AnomalyLevel::CRITICAL:
-                // 事故级：设备停机或特殊处理
-                if (anomaly.device_id == "PV_Inverter") {
-                    if (control_callback_) {
-                        control_callback_("PV", 0);
-                    }
-                } else if (anomaly.device_id == "Wind_Controller") {
-                    if (control_callback_) {
-                        control_callback_("WIND", 0);
-                    }
-                } else if (anomaly.device_id == "ESS_PCS") {
-                    if (control_callback_) {
-                        control_callback_("ESS", 0);
-                    }
-                } else if (anomaly.device_id == "Electrolyzer") {
-                    if (control_callback_) {
-                        control_callback_("HYDROGEN", 0);
-                    }
-                } else if (anomaly.device_id == "Grid") {
-                    if (control_callback_) {
-                        control_callback_("GRID", 0);
-                    }
-                    
-                    if (current_status_.is_island_mode) {
-                        if (status_callback_) {
-                            status_callback_("孤岛模式，保障重要负荷");
-                        }
-                    }
-                } else if (anomaly.device_id == "Hydrogen_System") {
-                    if (control_callback_) {
-                        control_callback_("HYDROGEN", 0);
+    double row[TELEMETRY_CHANNEL_COUNT];
+    telemetry_.readRow(device, row); // 可能在确认恢复的调用线程执行：读共享存储而非扫描表
+    double power = row[static_cast<size_t>(TelemetryChannel::POWER)];
+    return std::isnan(power) ? 0.0 : std::max(0.0, power);
+}
+
+// 记录异常生命周期事件：仅编码到日志的待提交缓冲，不在监测线程做I/O
+void AnomalyMonitoringController::journalAnomaly(JournalEvent event, const AnomalyInfo& anomaly) {
+    if (journal_.isOpen()) {
+        journal_.append(event, anomaly);
+    }
+}
+
+// 产生异常相关的状态事件（只入队定长记录，无订阅者时跳过）
+void AnomalyMonitoringController::postAnomalyEvent(ControllerEventKind kind, const AnomalyInfo& anomaly,
+                                                   uint32_t actions) {
+    if (dispatcher_.hasSubscriber(callbackKindOf(kind))) {
+        ControllerEvent event = anomalyEvent(kind, anomaly);
+        event.actions = actions;
+        postEvent(event);
+    }
+}
+
+// 将处置动作的功率设定并入本轮批次（持有anomaly_mutex_），同一控制目标按优先级合并
+void AnomalyMonitoringController::postSetpoint(const AnomalyInfo& anomaly, double power_kw) {
+    if (dispatcher_.hasSubscriber(CallbackKind::CONTROL)) {
+        ControllerEvent event = anomalyEvent(ControllerEventKind::SETPOINT, anomaly);
+        event.power_kw = power_kw;
+        if (scan_setpoints_.add(event, registry_.info(anomaly.device_index).control_target)) {
+            coalesced_setpoints_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+// 爬坡调度的设定值并入本轮批次（爬坡调度线程）：与同一控制目标的处置动作按优先级合并，
+// 不会在停机设定之后单独下发。监测循环扫描中由其在本轮末尾下发，未运行或未使能时直接下发
+void AnomalyMonitoringController::mergeRampSteps(const std::vector<RampState>& steps) {
+    if (!dispatcher_.hasSubscriber(CallbackKind::CONTROL)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(anomaly_mutex_);
+        for (const RampState& step : steps) {
+            if (!ramp_scheduler_.isCurrent(step.device, step.generation)) {
+                continue; // 投递途中已被异常确认取消：停机设定之后不再下发旧的爬坡值
+            }
+            ControllerEvent event = deviceEvent(ControllerEventKind::SETPOINT, step.device, step.tag,
+                                                step.current_kw);
+            if (scan_setpoints_.add(event, registry_.info(step.device).control_target)) {
+                coalesced_setpoints_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        setpoints_pending_.store(true, std::memory_order_release);
+    }
+    if (running_ && enabled_) {
+        wakeMonitor();
+    } else {
+        flushSetpoints();
+    }
+}
+
+// 下发本轮合并后的功率设定（可由监测线程或爬坡调度线程调用）：在锁内交换批次，锁外入队
+void AnomalyMonitoringController::flushSetpoints() {
+    std::lock_guard<std::mutex> issue(issue_mutex_);
+    {
+        std::lock_guard<std::mutex> lock(anomaly_mutex_);
+        setpoints_pending_.store(false, std::memory_order_relaxed);
+        if (scan_setpoints_.empty()) {
+            return;
+        }
+        issuing_setpoints_.swap(scan_setpoints_);
+        for (size_t i = 0; i < issuing_setpoints_.size(); ++i) {
+            const std::string& target = issuing_setpoints_.target(i);
+            auto it = commanded_kw_.find(target);
+            if (it == commanded_kw_.end()) {
+                it = commanded_kw_.emplace(target, 0.0).first; // 每个控制目标首次下发时分配一次
+            }
+            it->second = issuing_setpoints_.at(i).power_kw;
+        }
+    }
+    postSetpointBatch(issuing_setpoints_);
+}
+
+// 批次内的设定以同一批次号连续入队，分发线程到齐后一次交给批量控制订阅者
+void AnomalyMonitoringController::postSetpointBatch(SetpointBatch& batch) {
+    if (batch.empty()) {
+        return;
+    }
+    uint64_t id = next_setpoint_batch_.fetch_add(1, std::memory_order_relaxed);
+    uint32_t size = static_cast<uint32_t>(batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+        ControllerEvent event = batch.at(i);
+        event.batch = id;
+        event.batch_size = size;
+        postEvent(event);
+    }
+    setpoint_batches_.fetch_add(1, std::memory_order_relaxed);
+    issued_setpoints_.fetch_add(size, std::memory_order_relaxed);
+    batch.clear();
+}
+
+// 产生安全操作事件
+void AnomalyMonitoringController::postSafetyAction(SafetyAction action, const AnomalyInfo& anomaly) {
+    if (dispatcher_.hasSubscriber(CallbackKind::SAFETY)) {
+        ControllerEvent event = anomalyEvent(ControllerEventKind::SAFETY_ACTION, anomaly);
+        event.action = action;
+        postEvent(event);
+    }
+}
+
+// 处置动作的安全操作在持有anomaly_mutex_时只暂存（安全通道满时入队会等待），解锁后由监测线程入队
+void AnomalyMonitoringController::deferSafetyAction(SafetyAction action, const AnomalyInfo& anomaly) {
+    if (dispatcher_.hasSubscriber(CallbackKind::SAFETY)) {
+        ControllerEvent event = anomalyEvent(ControllerEventKind::SAFETY_ACTION, anomaly);
+        event.action = action;
+        event.timestamp_us = toMicros(std::chrono::system_clock::now()); // 事件时间为动作产生时刻
+        scan_safety_actions_.push_back(event);
+    }
+}
+
+void AnomalyMonitoringController::flushSafetyActions() {
+    {
+        std::lock_guard<std::mutex> lock(anomaly_mutex_);
+        if (scan_safety_actions_.empty()) {
+            return;
+        }
+        issuing_safety_actions_.swap(scan_safety_actions_);
+    }
+    for (ControllerEvent& event : issuing_safety_actions_) {
+        dispatcher_.post(event);
+    }
+    issuing_safety_actions_.clear(); // 保留容量
+}
+
+// 产生设备事件（恢复爬坡的完成通知）
+void AnomalyMonitoringController::postDeviceEvent(ControllerEventKind kind, DeviceIndex device,
+                                                  AnomalyKey key, double power_kw) {
+    if (dispatcher_.hasSubscriber(callbackKindOf(kind))) {
+        ControllerEvent event = deviceEvent(kind, device, key, power_kw);
+        postEvent(event);
+    }
+}
+
+// 构造设备事件（恢复爬坡的设定值与完成通知），key为触发恢复的异常键
+ControllerEvent AnomalyMonitoringController::deviceEvent(ControllerEventKind kind, DeviceIndex device,
+                                                         AnomalyKey key, double power_kw) const {
+    ControllerEvent event{};
+    event.kind = kind;
+    event.key = key;
+    event.rule = ruleIdOf(key);
+    const AnomalyRuleSpec* spec = rules_.spec(event.rule);
+    event.type = spec != nullptr ? spec->type : AnomalyType::DEVICE_FAULT;
+    event.level = AnomalyLevel::INFO;
+    event.device = device;
+    event.power_kw = power_kw;
+    return event;
+}
+
+void AnomalyMonitoringController::postEvent(ControllerEvent& event) {
+    event.timestamp_us = toMicros(std::chrono::system_clock::now());
+    dispatcher_.post(event);
+}
+
+// 按描述数值生成异常描述
+void AnomalyMonitoringController::describeAnomaly(AnomalyInfo& anomaly) const {
+    anomaly.description.clear();
+    appendDescription(anomaly.rule_id, anomaly.detail, anomaly.description);
+}
+
+// 追加异常描述文本：越限测量值（预测类规则附带预计到达上限的时间），
+// 电压暂降/暂升事件按EN 50160表格附带幅值与持续时间分档
+void AnomalyMonitoringController::appendDescription(RuleId rule, const AnomalyDetail& detail,
+                                                    std::string& text) const {
+    const AnomalyRuleSpec* spec = rules_.spec(rule);
+    if (spec == nullptr) {
+        return;
+    }
+    char buffer[160];
+    if (std::isfinite(detail.magnitude_pu)) {
+        bool is_dip = rule == RULE_VOLTAGE_DIP;
+        char phases[VoltageEventDetector::MAX_PHASES + 1];
+        size_t count = 0;
+        for (uint32_t p = 0; p < VoltageEventDetector::MAX_PHASES; ++p) {
+            if (detail.phase_mask & (1u << p)) {
+                phases[count++] = static_cast<char>('A' + p);
+            }
+        }
+        phases[count] = '\0';
+        std::snprintf(buffer, sizeof(buffer), "%s: %s%.1f%%(%s), 持续%.0fms(%s), %s相",
+                      spec->name.c_str(), is_dip ? "残余电压" : "最高电压",
+                      detail.magnitude_pu * 100.0,
+                      is_dip ? dipDepthClass(detail.magnitude_pu) : swellMagnitudeClass(detail.magnitude_pu),
+                      detail.duration_ms, eventDurationClass(detail.duration_ms), phases);
+        text += buffer;
+        return;
+    }
+    text += spec->name;
+    if (!spec->unit.empty()) {
+        std::snprintf(buffer, sizeof(buffer), ": %f", detail.value);
+        text += buffer;
+        text += spec->unit;
+    }
+    if (std::isfinite(detail.forecast_s)) {
+        std::snprintf(buffer, sizeof(buffer), "，预计%.1fs后达到上限", detail.forecast_s);
+        text += buffer;
+    }
+}
+
+// 生成字符串订阅者收到的文本（在分发线程中执行，规则名称与设备集合初始化后不再变化）
+void AnomalyMonitoringController::formatEvent(const ControllerEvent& event, std::string& text) const {
+    switch (event.kind) {
+        case ControllerEventKind::ANOMALY_ACTIVATED:
+            switch (event.level) {
+                case AnomalyLevel::INFO:
+                    text += "提示级异常: ";
+                    appendDescription(event.rule, event.detail, text);
+                    break;
+                case AnomalyLevel::WARNING:
+                    text += "一般级异常: ";
+                    appendDescription(event.rule, event.detail, text);
+                    if (event.actions & ACTION_DERATE_HALF) {
+                        text += ", 设备功率减半";
                     }
-                    
-                    if (anomaly.description.find("氢浓度异常") != std::string::npos) {
-                        if (safety_callback_) {
-                            safety_callback_("启动通风系统");
-                        }
-                    } else if (anomaly.description.find("氢罐压力异常") != std::string::npos) {
-                        if (safety_callback_) {
-                            safety_callback_("启动泄压系统");
-                        }
+                    break;
+                case AnomalyLevel::CRITICAL:
+                    text += "事故级异常: ";
+                    appendDescription(event.rule, event.detail, text);
+                    if (event.actions & ACTION_SHUTDOWN) {
+                        text += ", 设备已停机";
                     }
-                    
-                    if (safety_callback_) {
-                        safety_callback_("转入保安全模式");
+                    break;
+            }
+            break;
+        case ControllerEventKind::ANOMALY_CLEARED:
+            text += "异常已解除: ";
+            appendDescription(event.rule, event.detail, text);
+            break;
+        case ControllerEventKind::CONFIRMATION_REQUIRED:
+            text += "安全异常恢复需要人工确认: ";
+            appendDescription(event.rule, event.detail, text);
+            break;
+        case ControllerEventKind::RECOVERY_CONFIRMED:
+            text += "安全异常恢复已确认: ";
+            appendDescription(event.rule, event.detail, text);
+            break;
+        case ControllerEventKind::RECOVERY_STARTED:
+            text += "开始恢复系统出力: ";
+            appendDescription(event.rule, event.detail, text);
+            break;
+        case ControllerEventKind::RECOVERY_CANCELLED:
+            text += "恢复过程已取消: ";
+            appendDescription(event.rule, event.detail, text);
+            break;
+        case ControllerEventKind::RAMP_COMPLETED:
+            text += "系统出力恢复完成: ";
+            text += rules_.ruleName(event.rule);
+            text += " (";
+            text += registry_.info(event.device).name;
+            text += ")";
+            break;
+        case ControllerEventKind::GRID_RECONNECTED:
+            text += "电网恢复完成，已并网并恢复正常功率输出";
+            break;
+        case ControllerEventKind::CRITICAL_LOAD_PROTECTED:
+            text += "孤岛模式，保障重要负荷";
+            break;
+        case ControllerEventKind::SETPOINT:
+            text += registry_.info(event.device).control_target;
+            break;
+        case ControllerEventKind::SAFETY_ACTION:
+            text += safetyActionText(event.action);
+            break;
+    }
+}
+
+// 回放异常日志（持有status_mutex_，设备集合已冻结）：
+// 已确认的异常连同人工确认状态恢复到活动表，恢复条件由后续扫描按新数据重新判定，处置动作不重复执行；
+// 待确认的异常交给检查点补充剩余确认时间，检查点中没有的随后丢弃；
+// 事件类异常在停机期间的结果未知，以当前时间结束并进入历史
+bool AnomalyMonitoringController::restoreFromJournal(std::unordered_set<AnomalyKey>& replayed,
+                                                     std::unordered_map<AnomalyKey, AnomalyInfo>& pending) {
+    JournalReplay replay;
+    if (!journal_.open(journal_path_, anomaly_history_.retention().max_records, replay)) {
+        return false; // 无法打开或不是异常日志
+    }
+    std::lock_guard<std::mutex> lock(anomaly_mutex_);
+    for (const AnomalyInfo& anomaly : replay.history) {
+        anomaly_history_.append(anomaly);
+    }
+    uint64_t restored = 0;
+    for (AnomalyInfo& anomaly : replay.active) {
+        const AnomalyRuleSpec* spec = rules_.spec(anomaly.rule_id);
+        bool known = spec != nullptr && registry_.isValid(anomaly.device_index) &&
+            registry_.info(anomaly.device_index).name == anomaly.device_id;
+        if (!known) {
+            journal_.append(JournalEvent::DISCARDED, anomaly); // 规则或设备配置已变化
+            continue;
+        }
+        if (anomaly.state != AnomalyState::ACTIVE) {
+            replayed.insert(anomaly.key);
+            pending.emplace(anomaly.key, anomaly);
+            continue;
+        }
+        if (spec->event_driven) {
+            anomaly.end_time = std::chrono::system_clock::now();
+            anomaly_history_.append(anomaly);
+            journal_.append(JournalEvent::CLOSED, anomaly);
+            continue;
+        }
+        anomaly.detail.value = anomaly.value; // 描述数值未持久化，以测量值代替
+        bool inserted = false;
+        active_anomalies_.insert(anomaly, inserted);
+        restored += inserted ? 1 : 0;
+        replayed.insert(anomaly.key);
+    }
+    restored_anomalies_.store(restored, std::memory_order_relaxed);
+    return true;
+}
+
+// 日志中待确认、检查点未补充确认计时的异常：停机期间的结果未知，丢弃
+void AnomalyMonitoringController::discardJournalPending(const std::unordered_map<AnomalyKey, AnomalyInfo>& pending) {
+    for (const auto& entry : pending) {
+        journal_.append(JournalEvent::DISCARDED, entry.second);
+    }
+}
+
+// 采集状态检查点：定时状态换算为相对采集时刻的时长
+ControllerCheckpoint AnomalyMonitoringController::captureCheckpoint(bool clean_shutdown) {
+    ControllerCheckpoint checkpoint;
+    checkpoint.created = std::chrono::system_clock::now();
+    checkpoint.clean_shutdown = clean_shutdown;
+    checkpoint.device_fingerprint = deviceFingerprint(registry_);
+    checkpoint.normal_voltage = normal_voltage_;
+    checkpoint.normal_frequency = normal_frequency_;
+    checkpoint.max_hydrogen_concentration = max_hydrogen_concentration_;
+    checkpoint.max_hydrogen_pressure = max_hydrogen_pressure_;
+    checkpoint.anomaly_duration_threshold_ms = anomaly_duration_threshold_ms_;
+    checkpoint.recovery_rate_percent_per_minute = recovery_rate_percent_per_minute_;
+    {
+        std::lock_guard<std::mutex> lock(status_mutex_);
+        std::copy(std::begin(forecast_horizon_ms_), std::end(forecast_horizon_ms_),
+                  std::begin(checkpoint.forecast_horizon_ms));
+        for (const AnomalyRuleSpec& spec : rules_.specs()) {
+            checkpoint.hysteresis.push_back(CheckpointHysteresis{spec.id, spec.clear, spec.min_clear_ms});
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(anomaly_mutex_);
+        int64_t now_ms = timerNowMs();
+        checkpoint.anomalies.reserve(active_anomalies_.size());
+        for (size_t i = 0; i < active_anomalies_.size(); ++i) {
+            const AnomalyInfo& anomaly = active_anomalies_.at(i);
+            CheckpointAnomaly item{anomaly, -1, -1};
+            if (anomaly.state == AnomalyState::PENDING) {
+                int64_t deadline = pending_timers_.deadline(anomaly.pending_timer);
+                item.confirm_remaining_ms = deadline == TimingWheel::NO_DEADLINE ? 0 :
+                    std::max<int64_t>(0, deadline - now_ms);
+            }
+            if (anomaly.clear_since_ms >= 0) {
+                item.clear_elapsed_ms = now_ms - anomaly.clear_since_ms;
+            }
+            checkpoint.anomalies.push_back(std::move(item));
+        }
+    }
+    checkpoint.ramps = ramp_scheduler_.snapshot();
+    return checkpoint;
+}
+
+// 恢复状态检查点（持有status_mutex_，设备集合已冻结）：
+// 控制参数与规则设置总是恢复；设备集合不变时恢复活动异常（待确认异常按剩余确认时间重新计时，
+// 停机期间不计入）与恢复爬坡。启用异常日志时异常以日志为准：检查点只为日志中仍未结束的异常
+// （replayed）补充恢复计时、滞回状态与待确认计时，检查点之后已解除或丢弃的异常不再恢复；
+// 未启用异常日志时以检查点为异常来源
+void AnomalyMonitoringController::restoreCheckpoint(const std::unordered_set<AnomalyKey>& replayed,
+                                                    std::unordered_map<AnomalyKey, AnomalyInfo>& pending) {
+    auto begin = std::chrono::steady_clock::now();
+    ControllerCheckpoint checkpoint;
+    if (!checkpoint_store_.load(checkpoint)) {
+        return; // 无检查点或已损坏：按初始状态启动
+    }
+    normal_voltage_ = checkpoint.normal_voltage;
+    normal_frequency_ = checkpoint.normal_frequency;
+    max_hydrogen_concentration_ = checkpoint.max_hydrogen_concentration;
+    max_hydrogen_pressure_ = checkpoint.max_hydrogen_pressure;
+    anomaly_duration_threshold_ms_ = checkpoint.anomaly_duration_threshold_ms;
+    recovery_rate_percent_per_minute_ = checkpoint.recovery_rate_percent_per_minute;
+    std::copy(std::begin(checkpoint.forecast_horizon_ms), std::end(checkpoint.forecast_horizon_ms),
+              std::begin(forecast_horizon_ms_));
+    for (const CheckpointHysteresis& item : checkpoint.hysteresis) {
+        if (item.clear.low < item.clear.high && item.min_clear_ms >= 0) {
+            rules_.setHysteresis(item.rule, item.clear, item.min_clear_ms);
+        }
+    }
+    rules_dirty_ = true;
+    
+    if (checkpoint.device_fingerprint == deviceFingerprint(registry_)) {
+        std::lock_guard<std::mutex> lock(anomaly_mutex_);
+        int64_t now_ms = timerNowMs();
+        uint64_t restored = 0;
+        bool journaled = journal_.isOpen();
+        for (const CheckpointAnomaly& item : checkpoint.anomalies) {
+            const AnomalyRuleSpec* spec = rules_.spec(item.info.rule_id);
+            if (spec == nullptr || spec->event_driven || !registry_.isValid(item.info.device_index)) {
+                continue; // 规则已删除，或事件类异常（停机期间的结果未知）
+            }
+            if (journaled && replayed.count(item.info.key) == 0) {
+                continue; // 日志中已解除、丢弃或从未记录：以日志为准
+            }
+            AnomalyInfo* anomaly = active_anomalies_.find(item.info.key);
+            bool inserted = false;
+            if (anomaly == nullptr) {
+                auto journal_pending = pending.find(item.info.key);
+                if (journaled) {
+                    if (journal_pending == pending.end() || item.info.state != AnomalyState::PENDING) {
+                        continue; // 日志中的状态与检查点不一致，不恢复
                     }
+                    anomaly = active_anomalies_.insert(journal_pending->second, inserted); // 待确认异常取日志中的记录
+                    pending.erase(journal_pending);
+                } else {
+                    anomaly = active_anomalies_.insert(item.info, inserted);
                 }
-                
-                if (status_callback_) {
-                    status_callback_("事故级异常: " + anomaly.description + ", 设备已停机");
+                anomaly->detail.value = anomaly->value; // 描述数值未持久化，以测量值代替
+                if (anomaly->state == AnomalyState::PENDING) {
+                    anomaly->pending_timer = pending_timers_.arm(anomaly->key, now_ms + item.confirm_remaining_ms);
+                    pending_anomalies_.fetch_add(1, std::memory_order_relaxed);
                 }
-                break;
+                ++restored;
+            }
+            anomaly->clear_since_ms = item.clear_elapsed_ms >= 0 ? now_ms - item.clear_elapsed_ms : -1;
+            anomaly->hysteresis_hold = item.info.hysteresis_hold;
+        }
+        restored_anomalies_.fetch_add(restored, std::memory_order_relaxed);
+        for (const RampState& ramp : checkpoint.ramps) {
+            if (registry_.isValid(ramp.device)) {
+                restored_ramps_.push_back(ramp);
+            }
         }
-        // 标记为已处理
-        active_anomalies_[anomaly.description].is_handled = true;
     }
+    checkpoint_restore_us_.store(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - begin).count(), std::memory_order_relaxed);
 }
 
-// 4.处理异常恢复
-void AnomalyMonitoringController::handleAnomalyRecovery(const AnomalyInfo& anomaly) {
-    // 安全异常需要人工确认
-    if (anomaly.type == AnomalyType::SAFETY_FAULT && anomaly.needs_manual_confirmation) {
-        if (status_callback_) {
-            status_callback_("安全异常恢复需要人工确认: " + anomaly.description);
+// 恢复爬坡完成（在爬坡调度线程中执行）
+void AnomalyMonitoringController::onRampComplete(const RampState& ramp) {
+    if (deviceClassOf(ramp.device) == DeviceClass::GRID) {
+        postDeviceEvent(ControllerEventKind::GRID_RECONNECTED, ramp.device, ramp.tag, ramp.target_kw);
+    }
+    postDeviceEvent(ControllerEventKind::RAMP_COMPLETED, ramp.device, ramp.tag, ramp.target_kw);
+}
+
+// 创建变化率、漂移检测器与趋势预测器（初始化时调用，设备集合已冻结）
+void AnomalyMonitoringController::createDerivedDetectors() {
+    for (auto& by_channel : rate_detector_of_) {
+        std::fill(std::begin(by_channel), std::end(by_channel), static_cast<int8_t>(-1));
+    }
+    for (auto& by_channel : drift_detector_of_) {
+        std::fill(std::begin(by_channel), std::end(by_channel), static_cast<int8_t>(-1));
+    }
+    for (auto& by_channel : forecaster_of_) {
+        std::fill(std::begin(by_channel), std::end(by_channel), static_cast<int8_t>(-1));
+    }
+    rate_detectors_.clear();
+    for (const RateDetectorSpec& spec : builtinRateDetectors()) {
+        size_t rows = registry_.deviceCount(spec.device_class);
+        if (rows == 0) {
+            continue;
         }
-        return;
+        rate_detector_of_[static_cast<size_t>(spec.device_class)][static_cast<size_t>(spec.source)] =
+            static_cast<int8_t>(rate_detectors_.size());
+        rate_detectors_.emplace_back(spec);
+        rate_detectors_.back().allocate(rows);
     }
-    
-    // 按5%/分钟速率恢复系统出力
-    if (status_callback_) {
-        status_callback_("开始恢复系统出力: " + anomaly.description);
+    drift_detectors_.clear();
+    for (const DriftDetectorSpec& spec : builtinDriftDetectors()) {
+        size_t rows = registry_.deviceCount(spec.device_class);
+        if (rows == 0) {
+            continue;
+        }
+        drift_detector_of_[static_cast<size_t>(spec.device_class)][static_cast<size_t>(spec.source)] =
+            static_cast<int8_t>(drift_detectors_.size());
+        drift_detectors_.emplace_back(spec);
+        drift_detectors_.back().allocate(rows);
+    }
+    forecasters_.clear();
+    for (const ForecastSpec& spec : builtinForecasters()) {
+        size_t rows = registry_.deviceCount(spec.device_class);
+        if (rows == 0) {
+            continue;
+        }
+        forecaster_of_[static_cast<size_t>(spec.device_class)][static_cast<size_t>(spec.source)] =
+            static_cast<int8_t>(forecasters_.size());
+        forecasters_.emplace_back(spec);
+        forecasters_.back().allocate(rows);
     }
-    
-   // 计算恢复速率 (5%/分钟 = 0.0833%/秒)
-   double recovery_rate_per_second = 5.0 / 60.0;
-    
-   if (anomaly.device_id == "PV_Inverter") {
-       double target_power = 100.0; // 假设额定功率100kW
-       double current_power = 0.0;
-       
-       while (current_power < target_power) {
-           double increment = target_power * (recovery_rate_per_second / 100.0);
-           current_power = std::min(current_power + increment, target_power);
-           
-           if (control_callback_) {
-               control_callback_("PV", current_power);
-           }
-           
-           std::this_thread::sleep_for(std::chrono::seconds(1));
-       }
-   } else if (anomaly.device_id == "Wind_Controller") {
-       double target_power = 100.0; // 假设风机额定功率100kW
-       double current_power = 0.0;
-       
-       while (current_power < target_power) {
-           double increment = target_power * (recovery_rate_per_second / 100.0);
-           current_power = std::min(current_power + increment, target_power);
-           
-           if (control_callback_) {
-               control_callback_("WIND", current_power);
-           }
-           
-           std::this_thread::sleep_for(std::chrono::seconds(1));
-       }
-   } else if (anomaly.device_id == "ESS_PCS") {
-       double target_power = 100.0; // 假设储能额定功率100kW
-       double current_power = 0.0;
-       
-       while (current_power < target_power) {
-           double increment = target_power * (recovery_rate_per_second / 100.0);
-           current_power = std::min(current_power + increment, target_power);
-           
-           if (control_callback_) {
-               control_callback_("ESS", current_power);
-           }
-           
-           std::this_thread::sleep_for(std::chrono::seconds(1));
-       }
-   } else if (anomaly.device_id == "Electrolyzer") {
-       double target_power = 100.0; // 假设电解槽额定功率100kW
-       double current_power = 0.0;
-       
-       while (current_power < target_power) {
-           double increment = target_power * (recovery_rate_per_second / 100.0);
-           current_power = std::min(current_power + increment, target_power);
-           
-           if (control_callback_) {
-               control_callback_("HYDROGEN", current_power);
-           }
-           
-           std::this_thread::sleep_for(std::chrono::seconds(1));
-       }
-   } else if (anomaly.device_id == "Grid") {
-       // 电网恢复：先闭合并网开关，再逐步恢复功率
-       if (safety_callback_) {
-           safety_callback_("闭合并网开关");
-       }
-       
-       double target_power = 100.0; // 假设额定上网功率100kW
-       double current_power = 0.0;
-       
-       while (current_power < target_power) {
-           double increment = target_power * (recovery_rate_per_second / 100.0);
-           current_power = std::min(current_power + increment, target_power);
-           
-           if (control_callback_) {
-               control_callback_("GRID", current_power);
-           }
-           
-           std::this_thread::sleep_for(std::chrono::seconds(1));
-       }
-       
-       if (status_callback_) {
-           status_callback_("电网恢复完成，已并网并恢复正常功率输出");
-       }
-   } else if (anomaly.device_id == "Hydrogen_System") {
-       double target_power = 100.0; // 假设制氢系统额定功率100kW
-       double current_power = 0.0;
-       
-       while (current_power < target_power) {
-           double increment = target_power * (recovery_rate_per_second / 100.0);
-           current_power = std::min(current_power + increment, target_power);
-           
-           if (control_callback_) {
-               control_callback_("HYDROGEN", current_power);
-           }
-           
-           std::this_thread::sleep_for(std::chrono::seconds(1));
-       }
-   }
-   
-   if (status_callback_) {
-       status_callback_("系统出力恢复完成: " + anomaly.description);
-   }
-    
- 
 }
 
-// 5.确定异常等级
-AnomalyLevel AnomalyMonitoringController::determineAnomalyLevel(AnomalyType type, double value) {
-    switch (type) {
-        case AnomalyType::DEVICE_FAULT:
-            return AnomalyLevel::CRITICAL; // 设备故障均为事故级
-            
-        case AnomalyType::GRID_FAULT:
-            // 电网异常根据偏离程度确定等级
-            if (value >= 1.15 * normal_voltage_ || value <= 0.85 * normal_voltage_ ||
-                value >= 51.0 || value <= 49.0) {
-                return AnomalyLevel::CRITICAL;
-            } else if (value >= 1.1 * normal_voltage_ || value <= 0.9 * normal_voltage_ ||
-                       value >= 50.5 || value <= 49.5) {
-                return AnomalyLevel::WARNING;
-            } else {
-                return AnomalyLevel::INFO;
+// 以派生通道查找趋势预测器下标，-1为无
+int AnomalyMonitoringController::forecasterOfOutput(DeviceClass device_class, TelemetryChannel output) const {
+    for (size_t i = 0; i < forecasters_.size(); ++i) {
+        const ForecastSpec& spec = forecasters_[i].spec();
+        if (spec.device_class == device_class && spec.output == output) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+// 为使用统计量的规则分配统计流：已有的流保留状态（重新编译不丢失历史），只补充新的组合
+void AnomalyMonitoringController::createStatisticStreams() {
+    RuleId max_id = 0;
+    for (const CompiledRule& rule : rules_.plan()) {
+        max_id = std::max(max_id, rule.id);
+    }
+    rule_streams_.assign(static_cast<size_t>(max_id) + 1, -1);
+    for (const CompiledRule& rule : rules_.plan()) {
+        if (rule.statistic == ChannelStatistic::VALUE) {
+            continue;
+        }
+        std::vector<uint32_t>& streams =
+            streams_of_channel_[static_cast<size_t>(rule.device_class)][static_cast<size_t>(rule.channel)];
+        int32_t found = -1;
+        for (uint32_t index : streams) {
+            const StreamStatistics& stats = statistic_streams_[index].stats;
+            if (stats.kind() == rule.statistic && stats.windowMs() == rule.statistic_window_ms &&
+                stats.sampleMs() == (rule.statistic_sample_ms > 0 ? rule.statistic_sample_ms :
+                                     StreamStatistics::DEFAULT_SAMPLE_MS)) {
+                found = static_cast<int32_t>(index);
+                break;
             }
-            
-        case AnomalyType::SAFETY_FAULT:
-            // 安全异常根据偏离程度确定等级
-            if (value >= 2.0 * max_hydrogen_concentration_ || value >= 2.0 * max_hydrogen_pressure_) {
-                return AnomalyLevel::CRITICAL;
-            } else if (value >= 1.5 * max_hydrogen_concentration_ || value >= 1.5 * max_hydrogen_pressure_) {
-                return AnomalyLevel::WARNING;
-            } else {
-                return AnomalyLevel::INFO;
+        }
+        if (found < 0) {
+            found = static_cast<int32_t>(statistic_streams_.size());
+            statistic_streams_.push_back(StatisticStream{
+                rule.device_class, rule.channel,
+                StreamStatistics(rule.statistic, rule.statistic_window_ms, rule.statistic_sample_ms, rule.rows),
+                std::vector<uint64_t>(maskWordCount(rule.rows), 0)});
+            streams.push_back(static_cast<uint32_t>(found));
+        }
+        rule_streams_[rule.id] = found;
+    }
+}
+
+// 5.编译检测规则：阈值按当前控制参数换算为绝对值
+void AnomalyMonitoringController::compileRules() {
+    double base_values[THRESHOLD_BASE_COUNT];
+    base_values[static_cast<size_t>(ThresholdBase::ABSOLUTE)] = 1.0;
+    base_values[static_cast<size_t>(ThresholdBase::NORMAL_VOLTAGE)] = normal_voltage_;
+    base_values[static_cast<size_t>(ThresholdBase::NORMAL_FREQUENCY)] = normal_frequency_;
+    base_values[static_cast<size_t>(ThresholdBase::MAX_HYDROGEN_CONCENTRATION)] = max_hydrogen_concentration_;
+    base_values[static_cast<size_t>(ThresholdBase::MAX_HYDROGEN_PRESSURE)] = max_hydrogen_pressure_;
+    base_values[static_cast<size_t>(ThresholdBase::RATED_POWER)] = 1.0; // 逐台设备取额定功率
+    {
+        std::lock_guard<std::mutex> lock(status_mutex_); // 与运行中的规则修改互斥
+        rules_.compile(base_values, registry_);
+        for (TrendForecaster& forecaster : forecasters_) {
+            int32_t horizon_ms = forecast_horizon_ms_[static_cast<size_t>(forecaster.spec().source)];
+            if (horizon_ms >= 0) {
+                forecaster.setHorizon(horizon_ms);
             }
+        }
     }
+    createStatisticStreams();
     
-    return AnomalyLevel::INFO; // 默认返回提示级
+    // 越限位图按最大设备类别分配，扫描时不再分配
+    size_t words = 0;
+    for (size_t cls = 0; cls < DEVICE_CLASS_COUNT; ++cls) {
+        words = std::max(words, maskWordCount(registry_.deviceCount(static_cast<DeviceClass>(cls))));
+    }
+    screen_mask_.assign(words, 0);
 }
 
-// 6.检查异常是否已解决
+// 6.检查异常是否已解决（基于本轮扫描的遥测快照，按规则的恢复条件判定）
 bool AnomalyMonitoringController::isAnomalyResolved(const AnomalyInfo& anomaly) {
-    SystemStatus status;
+    const CompiledRule* rule = rules_.compiled(anomaly.rule_id);
+    if (rule == nullptr) {
+        return false;
+    }
+    return isValueCleared(*rule, localIndexOf(anomaly.device_index), ruleValue(*rule, anomaly.device_index));
+}
+
+// 滞回：取值回到恢复条件内并持续满最短恢复时间才解除；
+// 处于越限带与恢复带之间（回差带）时保持异常，不计入恢复时间
+bool AnomalyMonitoringController::isClearSustained(AnomalyInfo& anomaly, int64_t now_ms, int64_t& next_check_ms) {
+    const CompiledRule* rule = rules_.compiled(anomaly.rule_id);
+    if (rule == nullptr) {
+        return false;
+    }
+    size_t row = localIndexOf(anomaly.device_index);
+    double value = ruleValue(*rule, anomaly.device_index);
+    if (!isValueCleared(*rule, row, value)) {
+        if (classifyValue(*rule, row, value) < 0) {
+            anomaly.hysteresis_hold = true; // 回差带内
+        }
+        anomaly.clear_since_ms = -1;
+        return false;
+    }
+    if (anomaly.clear_since_ms < 0) {
+        anomaly.clear_since_ms = now_ms;
+    }
+    int64_t due_ms = anomaly.clear_since_ms + rule->min_clear_ms;
+    if (now_ms < due_ms) {
+        anomaly.hysteresis_hold = true; // 恢复计时中
+        next_check_ms = std::min(next_check_ms, due_ms);
+        return false;
+    }
+    return true;
+}
+
+// 7.更新系统状态（写者不加锁，不等待监测线程）
+bool AnomalyMonitoringController::updateDeviceTelemetry(DeviceIndex device, TelemetryChannel channel, double value) {
+    if (channel >= TelemetryChannel::COUNT || isDerivedChannel(channel) ||
+        !initialized_.load(std::memory_order_acquire) || !registry_.isValid(device)) {
+        return false; // 未初始化、设备不存在或派生通道
+    }
+    telemetry_.write(device, channel, value, toMicros(std::chrono::system_clock::now())); // 无时间戳：取写入时刻
+    notifyTelemetry();
+    return true;
+}
+
+// 批量接入带时间戳的样本：样本逐个写入共享存储（无锁），整批一次性加入待检测队列
+size_t AnomalyMonitoringController::ingestSamples(const TelemetrySample* samples, size_t count) {
+    if (!initialized_.load(std::memory_order_acquire) || samples == nullptr) {
+        return 0;
+    }
+    size_t accepted = 0;
     {
-        std::lock_guard<std::mutex> lock(status_mutex_); // 加锁获取当前状态
-        status = current_status_;
+        std::lock_guard<std::mutex> lock(sample_mutex_);
+        size_t capacity = MAX_PENDING_SAMPLES - std::min(MAX_PENDING_SAMPLES, pending_samples_.size());
+        for (size_t i = 0; i < count; ++i) {
+            const TelemetrySample& sample = samples[i];
+            if (sample.channel >= TelemetryChannel::COUNT || isDerivedChannel(sample.channel) ||
+                !registry_.isValid(sample.device)) {
+                continue; // 跳过无效样本
+            }
+            if (accepted == capacity) {
+                dropped_samples_.fetch_add(1, std::memory_order_relaxed); // 队列已满
+                continue;
+            }
+            telemetry_.write(sample.device, sample.channel, sample.value, toMicros(sample.timestamp));
+            pending_samples_.push_back(sample);
+            ++accepted;
+        }
     }
-    
-    // 根据异常类型检查是否已解决
-    switch (anomaly.type) {
-        case AnomalyType::DEVICE_FAULT:
-            if (anomaly.device_id == "PV_Inverter") {
-                return !status.pv_inverter_fault;
-            } else if (anomaly.device_id == "Wind_Controller") {
-                return !status.wind_controller_fault;
-            } else if (anomaly.device_id == "ESS_PCS") {
-                return !status.ess_pcs_fault;
-            } else if (anomaly.device_id == "Electrolyzer") {
-                return !status.electrolyzer_fault;
+    if (accepted > 0) {
+        notifyTelemetry();
+    }
+    return accepted;
+}
+
+size_t AnomalyMonitoringController::ingestSamples(const std::vector<TelemetrySample>& samples) {
+    return ingestSamples(samples.data(), samples.size());
+}
+
+uint64_t AnomalyMonitoringController::droppedSampleCount() const {
+    return dropped_samples_.load(std::memory_order_relaxed);
+}
+
+// 启用波形前端
+bool AnomalyMonitoringController::enableWaveformInput(DeviceIndex device, double sample_rate_hz, uint32_t phases) {
+    if (!initialized_.load(std::memory_order_acquire) || !registry_.isValid(device) ||
+        deviceClassOf(device) != DeviceClass::GRID) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(waveform_mutex_); // 额定参数在此锁内修改，前端不会按旧参数建立
+    std::unique_ptr<WaveformFrontEnd> front_end(new WaveformFrontEnd{
+        PhasorEstimator(sample_rate_hz, normal_frequency_, phases),
+        VoltageEventDetector(sample_rate_hz, normal_frequency_, phases, normal_voltage_), {}, {}, {}});
+    if (!front_end->estimator.isValid() || !front_end->event_detector.isValid()) {
+        return false; // 采样率过低或相数无效
+    }
+    waveform_inputs_[device] = std::move(front_end);
+    return true;
+}
+
+// 额定频率或声明电压变化后按新参数重建波形前端（采样率与相数不变，新参数下无效的前端不再产生结果）。
+// 进行中的电压事件以当前时刻结束，对应异常正常解除；调用者持有waveform_mutex_
+void AnomalyMonitoringController::rebuildWaveformInputs() {
+    if (waveform_inputs_.empty()) {
+        return;
+    }
+    auto now = std::chrono::system_clock::now();
+    size_t finished = 0;
+    for (auto& input : waveform_inputs_) {
+        WaveformFrontEnd& front_end = *input.second;
+        double sample_rate_hz = front_end.estimator.sampleRate();
+        uint32_t phases = front_end.estimator.phases();
+        front_end.events.clear();
+        if (front_end.event_detector.finish(front_end.events) > 0) {
+            std::lock_guard<std::mutex> lock(sample_mutex_);
+            for (const VoltageEvent& event : front_end.events) {
+                auto duration = std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                    std::chrono::duration<double>(static_cast<double>(event.duration_frames) / sample_rate_hz));
+                pending_voltage_events_.push_back(TimedVoltageEvent{input.first, event, now, now - duration});
+                ++finished;
             }
-            break;
-            
-        case AnomalyType::GRID_FAULT:
-            if (anomaly.description.find("电压异常") != std::string::npos) {
-                return status.grid_voltage >= 0.9 * normal_voltage_ && 
-                       status.grid_voltage <= 1.1 * normal_voltage_;
-            } else if (anomaly.description.find("频率异常") != std::string::npos) {
-                return status.grid_frequency >= 49.5 && status.grid_frequency <= 50.5;
+        }
+        front_end.estimator = PhasorEstimator(sample_rate_hz, normal_frequency_, phases);
+        front_end.event_detector = VoltageEventDetector(sample_rate_hz, normal_frequency_, phases, normal_voltage_);
+    }
+    if (finished > 0) {
+        notifyTelemetry();
+    }
+}
+
+// 接入原始波形：每个周波产生一组电压、频率样本，时间戳为周波结束时刻。
+// 多相时上报偏离额定电压最大的一相，单相跌落或升高不会被其他相平均掉；
+// 半周波电压事件按帧序号换算为绝对时间后交给监测线程
+size_t AnomalyMonitoringController::ingestWaveform(DeviceIndex device, const double* samples, size_t frames,
+                                                   std::chrono::system_clock::time_point first_sample_time) {
+    std::lock_guard<std::mutex> lock(waveform_mutex_);
+    auto it = waveform_inputs_.find(device);
+    if (it == waveform_inputs_.end() || samples == nullptr) {
+        return 0;
+    }
+    WaveformFrontEnd& front_end = *it->second;
+    front_end.cycles.clear();
+    front_end.events.clear();
+    size_t cycles = front_end.estimator.process(samples, frames, front_end.cycles);
+    front_end.event_detector.process(samples, frames, front_end.events);
+    double sample_period_s = 1.0 / front_end.estimator.sampleRate();
+    auto frameTime = [&](size_t frame) {
+        return first_sample_time + std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::duration<double>(static_cast<double>(frame + 1) * sample_period_s));
+    };
+    if (!front_end.events.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(sample_mutex_);
+            for (const VoltageEvent& event : front_end.events) {
+                auto time = frameTime(event.frame);
+                auto duration = std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                    std::chrono::duration<double>(static_cast<double>(event.duration_frames) * sample_period_s));
+                pending_voltage_events_.push_back(TimedVoltageEvent{device, event, time, time - duration});
             }
-            break;
-            
-        case AnomalyType::SAFETY_FAULT:
-            if (anomaly.description.find("氢浓度异常") != std::string::npos) {
-                return status.hydrogen_concentration < max_hydrogen_concentration_;
-            } else if (anomaly.description.find("氢罐压力异常") != std::string::npos) {
-                return status.hydrogen_tank_pressure < max_hydrogen_pressure_;
+        }
+        notifyTelemetry();
+    }
+    if (cycles == 0) {
+        return 0;
+    }
+    double nominal = normal_voltage_;
+    front_end.samples.clear();
+    for (const PhasorMeasurement& m : front_end.cycles) {
+        auto time = frameTime(m.frame);
+        double voltage = m.rms[0];
+        for (uint32_t p = 1; p < front_end.estimator.phases(); ++p) {
+            if (std::fabs(m.rms[p] - nominal) > std::fabs(voltage - nominal)) {
+                voltage = m.rms[p];
             }
-            break;
+        }
+        front_end.samples.push_back(TelemetrySample{time, device, TelemetryChannel::GRID_VOLTAGE, voltage});
+        if (!std::isnan(m.frequency_hz)) {
+            front_end.samples.push_back(TelemetrySample{time, device, TelemetryChannel::GRID_FREQUENCY,
+                                                        m.frequency_hz});
+        }
     }
-    
-    return false; // 默认返回未解决
+    ingestSamples(front_end.samples);
+    return cycles;
 }
 
-// 7.更新系统状态
 void AnomalyMonitoringController::updateSystemStatus(const SystemStatus& status) {
-    std::lock_guard<std::mutex> lock(status_mutex_); // 加锁更新状态
-    current_status_ = status;
+    if (!initialized_.load(std::memory_order_acquire)) {
+        return;
+    }
+    const LegacyDevices& d = legacy_devices_;
+    int64_t time_us = toMicros(std::chrono::system_clock::now()); // 状态快照无时间戳：取写入时刻
+    if (d.pv != INVALID_DEVICE_INDEX) {
+        ChannelUpdate updates[] = {
+            {TelemetryChannel::POWER, status.pv_power},
+            {TelemetryChannel::FAULT, status.pv_inverter_fault ? 1.0 : 0.0},
+        };
+        telemetry_.writeRow(d.pv, updates, 2, time_us);
+    }
+    if (d.wind != INVALID_DEVICE_INDEX) {
+        ChannelUpdate updates[] = {
+            {TelemetryChannel::POWER, status.wind_power},
+            {TelemetryChannel::FAULT, status.wind_controller_fault ? 1.0 : 0.0},
+        };
+        telemetry_.writeRow(d.wind, updates, 2, time_us);
+    }
+    if (d.ess != INVALID_DEVICE_INDEX) {
+        ChannelUpdate updates[] = {
+            {TelemetryChannel::POWER, status.ess_power},
+            {TelemetryChannel::FAULT, status.ess_pcs_fault ? 1.0 : 0.0},
+        };
+        telemetry_.writeRow(d.ess, updates, 2, time_us);
+    }
+    if (d.electrolyzer != INVALID_DEVICE_INDEX) {
+        ChannelUpdate updates[] = {
+            {TelemetryChannel::POWER, status.hydrogen_power},
+            {TelemetryChannel::FAULT, status.electrolyzer_fault ? 1.0 : 0.0},
+        };
+        telemetry_.writeRow(d.electrolyzer, updates, 2, time_us);
+    }
+    if (d.grid != INVALID_DEVICE_INDEX) {
+        ChannelUpdate updates[] = {
+            {TelemetryChannel::GRID_VOLTAGE, status.grid_voltage},
+            {TelemetryChannel::GRID_FREQUENCY, status.grid_frequency},
+            {TelemetryChannel::ISLAND_MODE, status.is_island_mode ? 1.0 : 0.0},
+        };
+        telemetry_.writeRow(d.grid, updates, 3, time_us);
+    }
+    if (d.hydrogen != INVALID_DEVICE_INDEX) {
+        ChannelUpdate updates[] = {
+            {TelemetryChannel::POWER, status.hydrogen_power},
+            {TelemetryChannel::HYDROGEN_CONCENTRATION, status.hydrogen_concentration},
+            {TelemetryChannel::HYDROGEN_TANK_PRESSURE, status.hydrogen_tank_pressure},
+        };
+        telemetry_.writeRow(d.hydrogen, updates, 3, time_us);
+    }
+    notifyTelemetry();
 }
 
 // 8.确认安全异常恢复
-void AnomalyMonitoringController::confirmSafetyAnomalyRecovery(const std::string& anomaly_id) {
-    std::lock_guard<std::mutex> lock(anomaly_mutex_); // 加锁保护异常数据
+bool AnomalyMonitoringController::confirmSafetyAnomalyRecovery(AnomalyKey key) {
+    AnomalyInfo anomaly;
+    {
+        std::lock_guard<std::mutex> lock(anomaly_mutex_); // 加锁保护异常数据
+        
+        AnomalyInfo* entry = active_anomalies_.find(key);
+        if (entry == nullptr || entry->type != AnomalyType::SAFETY_FAULT ||
+            entry->state != AnomalyState::ACTIVE) {
+            return false; // 不存在、非安全异常或尚未确认
+        }
+        anomaly = *entry;
+        anomaly.needs_manual_confirmation = false; // 标记为已确认
+        anomaly.awaiting_confirmation = false;
+        
+        postAnomalyEvent(ControllerEventKind::RECOVERY_CONFIRMED, anomaly);
+        
+        if (anomaly.end_time < anomaly.start_time) {
+            anomaly.end_time = std::chrono::system_clock::now(); // 条件尚未消失即确认
+        }
+        anomaly_history_.append(anomaly);
+        journalAnomaly(JournalEvent::CLOSED, anomaly);
+        active_anomalies_.erase(key);
+    }
+    rescan_requested_ = true; // 条件仍存在时由下一轮扫描重新告警，不等取值变化
     
-    for (auto& [id, anomaly] : active_anomalies_) {
-        if (anomaly.description == anomaly_id && anomaly.type == AnomalyType::SAFETY_FAULT) {
-            anomaly.needs_manual_confirmation = false; // 标记为已确认
-            
-            if (status_callback_) {
-                status_callback_("安全异常恢复已确认: " + anomaly.description);
+    handleAnomalyRecovery(anomaly); // 处理恢复过程（异步爬坡）
+    return true;
+}
+
+void AnomalyMonitoringController::confirmSafetyAnomalyRecovery(const std::string& anomaly_id) {
+    std::vector<AnomalyKey> matched;
+    {
+        std::lock_guard<std::mutex> lock(anomaly_mutex_);
+        for (size_t i = 0; i < active_anomalies_.size(); ++i) {
+            const AnomalyInfo& anomaly = active_anomalies_.at(i);
+            if (anomaly.type == AnomalyType::SAFETY_FAULT &&
+                (anomaly.description == anomaly_id || rules_.ruleName(anomaly.rule_id) == anomaly_id)) {
+                matched.push_back(anomaly.key);
             }
-            
-            // 处理异常恢复
-            anomaly.end_time = std::chrono::system_clock::now();
-            anomaly_history_.push_back(anomaly);
-            active_anomalies_.erase(id);
-            
-            handleAnomalyRecovery(anomaly); // 处理恢复过程
-            break;
         }
     }
+    for (AnomalyKey key : matched) {
+        confirmSafetyAnomalyRecovery(key);
+    }
 }
 
 // 设置控制参数
@@ -524,32 +1741,100 @@ void AnomalyMonitoringController::setControlParameters(double normal_voltage,
                                                      double max_hydrogen_concentration,
                                                      double max_hydrogen_pressure,
                                                      int anomaly_duration_threshold_ms) {
-    normal_voltage_ = normal_voltage;
-    normal_frequency_ = normal_frequency;
+    {
+        std::lock_guard<std::mutex> lock(waveform_mutex_);
+        bool nominal_changed = normal_voltage_ != normal_voltage || normal_frequency_ != normal_frequency;
+        normal_voltage_ = normal_voltage;
+        normal_frequency_ = normal_frequency;
+        if (nominal_changed) {
+            rebuildWaveformInputs(); // 波形前端按额定参数划分周波与换算标幺值
+        }
+    }
     max_hydrogen_concentration_ = max_hydrogen_concentration;
     max_hydrogen_pressure_ = max_hydrogen_pressure;
     anomaly_duration_threshold_ms_ = anomaly_duration_threshold_ms;
+    rules_dirty_ = true; // 下一轮扫描前按新参数重新编译规则
+}
+
+// 设置恢复爬坡速率
+void AnomalyMonitoringController::setRecoveryRampRate(double percent_per_minute) {
+    if (percent_per_minute > 0.0) {
+        recovery_rate_percent_per_minute_ = percent_per_minute;
+    }
 }
 
 // 使能监测功能
 void AnomalyMonitoringController::enableMonitoring(bool enabled) {
     enabled_ = enabled;
+    wakeMonitor();
+}
+
+// 设置事件回调函数
+void AnomalyMonitoringController::setEventCallback(EventCallback callback) {
+    dispatcher_.setEventCallback(std::move(callback));
 }
 
 // 设置状态回调函数
 void AnomalyMonitoringController::setStatusCallback(StatusCallback callback) {
-    std::lock_guard<std::mutex> lock(callback_mutex_);
-    status_callback_ = callback;
+    dispatcher_.setStatusCallback(std::move(callback));
 }
 
 // 设置控制回调函数
 void AnomalyMonitoringController::setControlCallback(ControlCallback callback) {
-    std::lock_guard<std::mutex> lock(callback_mutex_);
-    control_callback_ = callback;
+    dispatcher_.setControlCallback(std::move(callback));
 }
 
 // 设置安全回调函数
 void AnomalyMonitoringController::setSafetyCallback(SafetyCallback callback) {
-    std::lock_guard<std::mutex> lock(callback_mutex_);
-    safety_callback_ = callback;
+    dispatcher_.setSafetyCallback(std::move(callback));
+}
+
+void AnomalyMonitoringController::setControlBatchCallback(ControlBatchCallback callback) {
+    dispatcher_.setControlBatchCallback(std::move(callback));
+}
+
+// 增加事件订阅者
+AnomalyMonitoringController::SubscriberId AnomalyMonitoringController::addEventSubscriber(EventCallback callback) {
+    return dispatcher_.addEventSubscriber(std::move(callback));
+}
+
+// 增加状态订阅者
+AnomalyMonitoringController::SubscriberId AnomalyMonitoringController::addStatusSubscriber(StatusCallback callback) {
+    return dispatcher_.addStatusSubscriber(std::move(callback));
+}
+
+// 增加控制订阅者
+AnomalyMonitoringController::SubscriberId AnomalyMonitoringController::addControlSubscriber(ControlCallback callback) {
+    return dispatcher_.addControlSubscriber(std::move(callback));
+}
+
+// 增加安全订阅者
+AnomalyMonitoringController::SubscriberId AnomalyMonitoringController::addSafetySubscriber(SafetyCallback callback) {
+    return dispatcher_.addSafetySubscriber(std::move(callback));
+}
+
+AnomalyMonitoringController::SubscriberId AnomalyMonitoringController::addControlBatchSubscriber(
+    ControlBatchCallback callback) {
+    return dispatcher_.addControlBatchSubscriber(std::move(callback));
+}
+
+// 按过滤条件订阅
+AnomalyMonitoringController::SubscriberId AnomalyMonitoringController::subscribe(
+    const EventSubscription& subscription, EventCallback callback) {
+    return dispatcher_.subscribe(subscription, std::move(callback));
+}
+
+// 按过滤条件订阅者的投递指标
+std::vector<SubscriberMetrics> AnomalyMonitoringController::getSubscriberMetrics() const {
+    return dispatcher_.subscriberMetrics();
+}
+
+// 注销订阅者
+bool AnomalyMonitoringController::removeSubscriber(SubscriberId id) {
+    return dispatcher_.removeSubscriber(id);
+}
+
+// 等待回调投递完成
+void AnomalyMonitoringController::flushCallbacks() {
+    dispatcher_.flush();
 }
\ No newline at end of file
@@ -6,36 +6,29 @@
 #include <string>
 #include <chrono>
 #include <mutex>
+#include <condition_variable>
 #include <atomic>
 #include <functional>
-#include <map>
-#include <deque>
-
-// 异常等级枚举
-enum class AnomalyLevel {
-    INFO,       // 提示级
-    WARNING,    // 一般级
-    CRITICAL    // 事故级
-};
-
-// 异常类型枚举
-enum class AnomalyType {
-    DEVICE_FAULT,   // 设备故障
-    GRID_FAULT,     // 电网异常
-    SAFETY_FAULT    // 安全异常
-};
-
-// 异常信息结构体
-struct AnomalyInfo {
-    AnomalyType type;                               // 异常类型
-    AnomalyLevel level;                             // 异常等级
-    std::string device_id;                          // 设备标识
-    std::string description;                        // 异常描述
-    std::chrono::system_clock::time_point start_time; // 异常开始时间
-    std::chrono::system_clock::time_point end_time;   // 异常结束时间
-    bool is_handled;                                // 是否已处理
-    bool needs_manual_confirmation;                 // 是否需要人工确认
-};
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include "anomaly_types.h"
+#include "active_anomaly_table.h"
+#include "anomaly_history.h"
+#include "anomaly_journal.h"
+#include "anomaly_rules.h"
+#include "callback_dispatcher.h"
+#include "controller_checkpoint.h"
+#include "phasor_estimator.h"
+#include "power_quality.h"
+#include "device_registry.h"
+#include "drift_detector.h"
+#include "ramp_scheduler.h"
+#include "rate_detector.h"
+#include "setpoint_batch.h"
+#include "telemetry_store.h"
+#include "timing_wheel.h"
+#include "trend_forecaster.h"
 
 // 系统状态结构体
 struct SystemStatus {
@@ -54,6 +47,47 @@ struct SystemStatus {
     bool is_island_mode;             // 是否孤岛模式标志
 };
 
+// 带绝对时间的电压事件（波形前端 -> 监测线程）
+struct TimedVoltageEvent {
+    DeviceIndex device;
+    VoltageEvent event;
+    std::chrono::system_clock::time_point time; // START/DEEPEN为越限时刻，END为恢复时刻
+    std::chrono::system_clock::time_point start_time; // 事件开始时刻（END有效）
+};
+
+// 运行指标（供外部核查检测时延）
+struct MonitoringMetrics {
+    uint64_t scan_count;                // 扫描轮数
+    uint64_t event_wakeups;             // 因新数据唤醒的扫描轮数
+    uint64_t detection_count;           // 新检出的异常数（含待确认）
+    uint64_t confirmed_anomalies;       // 持续满确认窗口后确认的异常数
+    uint64_t transient_anomalies;       // 确认窗口内消失、未执行动作的瞬态异常数
+    uint64_t pending_anomalies;         // 当前待确认的异常数
+    uint64_t suppressed_transitions;    // 滞回抑制的解除/再告警次数
+    uint64_t voltage_events;            // 已结束的电压暂降/暂升事件数
+    int64_t last_detection_latency_us;  // 最近一次检测时延(us)：数据到达 -> 检出
+    int64_t max_detection_latency_us;   // 最大检测时延(us)
+    int64_t mean_detection_latency_us;  // 平均检测时延(us)
+    int64_t last_scan_duration_us;      // 最近一轮扫描耗时(us)
+    int64_t max_scan_duration_us;       // 最大扫描耗时(us)
+    uint64_t dropped_samples;           // 丢弃样本数
+    uint64_t telemetry_read_retries;    // 遥测快照重试次数
+    uint64_t statistic_overflows;       // 采样快于规则预期、统计缓冲已满的样本数（窗口缩短或极值保留延长）
+    uint64_t history_records;           // 历史记录条数
+    uint64_t history_evicted;           // 按保留策略淘汰的历史记录数
+    uint64_t history_memory_bytes;      // 历史记录占用内存估计(字节)
+    uint64_t journal_committed;         // 已落盘的异常日志记录数
+    uint64_t journal_dropped;           // 因写入跟不上而丢弃的异常日志记录数
+    uint64_t journal_write_failures;    // 异常日志写入或刷盘失败次数
+    uint64_t restored_anomalies;        // 启动时由异常日志与状态检查点恢复的活动异常数
+    uint64_t checkpoint_saves;          // 已保存的状态检查点数
+    int64_t checkpoint_restore_us;      // 启动时恢复状态检查点的耗时(us)，-1为未恢复
+    uint64_t setpoint_batches;          // 已下发的功率设定批次数（每轮扫描至多一批）
+    uint64_t issued_setpoints;          // 合并后下发的功率设定数
+    uint64_t coalesced_setpoints;       // 同一控制目标被合并掉的功率设定数
+    DispatchMetrics callback_dispatch;  // 回调分发队列深度与投递时延
+};
+
 // 异常监测控制器类
 class AnomalyMonitoringController {
 public:
@@ -63,13 +97,83 @@ public:
     // 初始化系统
     bool initialize();
     
-    // 主监测循环
+    // 主监测循环（事件驱动：新数据、定时到期或停止请求时立即唤醒）
     void runMonitoringLoop();
     
-    // 更新系统状态
+    // 请求停止监测循环
+    void shutdown();
+    
+    // 设置最小扫描周期（连续数据流下限制扫描频率）
+    void setMinScanPeriod(std::chrono::microseconds period);
+    
+    // 获取运行指标
+    MonitoringMetrics getMetrics() const;
+    
+    // 注册设备（须在initialize()之前调用），返回设备索引
+    DeviceIndex registerDevice(DeviceClass device_class,
+                               const std::string& name,
+                               double rated_power_kw = 100.0,
+                               const std::string& control_target = "");
+    
+    // 登记检测规则（须在initialize()之前调用），标识重复或无效时返回false
+    bool addAnomalyRule(const AnomalyRuleSpec& rule);
+    
+    // 设置规则的滞回：恢复条件（相对基准值，low < 取值 < high）与最短恢复时间，
+    // 运行中可调，下一轮扫描生效；规则不存在或恢复带无效时返回false
+    bool setRuleHysteresis(RuleId rule, ThresholdBand clear, std::chrono::milliseconds min_clear_time);
+    
+    // 设置源通道趋势预测的时域（预计在时域内越限即提前告警），运行中可调，下一轮扫描生效；
+    // 该通道没有内置预测器或时域为负时返回false
+    bool setForecastHorizon(TelemetryChannel source, std::chrono::milliseconds horizon);
+    
+    // 设置异常历史的保留策略（记录数上限、保留时长），缩小上限时立即淘汰最早的记录
+    void setHistoryRetention(const HistoryRetention& retention);
+    
+    // 按设备、类型、等级与开始时间区间查询异常历史，结果按开始时间升序
+    std::vector<AnomalyInfo> queryAnomalyHistory(const AnomalyHistoryQuery& query) const;
+    
+    // 启用异常日志（须在initialize()之前调用）：异常生命周期事件由后台线程成组写入该文件，
+    // initialize()时回放日志恢复未结束的异常与最近的历史（日志无法打开时initialize()返回false）；
+    // 已初始化时返回false
+    bool enableJournal(const std::string& path);
+    
+    // 启用状态检查点（须在initialize()之前调用）：控制参数、规则滞回、预测时域、
+    // 活动异常（含待确认异常的剩余确认时间与恢复计时）与进行中的恢复爬坡，
+    // 按interval定期（0为仅停机时）及监测循环退出时保存到该文件，initialize()时恢复；
+    // 已初始化或间隔为负时返回false
+    bool enableCheckpoint(const std::string& path, std::chrono::milliseconds interval);
+    
+    // 按名称查找设备索引
+    DeviceIndex findDevice(const std::string& name) const;
+    
+    // 更新单台设备的遥测值
+    bool updateDeviceTelemetry(DeviceIndex device, TelemetryChannel channel, double value);
+    
+    // 批量接入带时间戳的样本（每批仅加锁一次），返回接收的样本数；
+    // 监测线程对批内每个样本逐一检测，不会只看到最后一个值
+    size_t ingestSamples(const TelemetrySample* samples, size_t count);
+    size_t ingestSamples(const std::vector<TelemetrySample>& samples);
+    
+    // 启用并网点设备的波形前端（须在initialize()之后调用）：按采样率接入原始相电压波形，
+    // 逐周波估计有效值与频率，结果作为带时间戳的样本进入电压、频率检测；
+    // 同时按半周波有效值检测电压暂降/暂升事件；phases为1~3
+    bool enableWaveformInput(DeviceIndex device, double sample_rate_hz, uint32_t phases);
+    
+    // 接入交错存放的原始电压采样（每帧phases个值，first_sample_time为首帧采集时间），
+    // 返回本次完成的周波数；设备未启用波形前端时返回0
+    size_t ingestWaveform(DeviceIndex device, const double* samples, size_t frames,
+                          std::chrono::system_clock::time_point first_sample_time);
+    
+    // 因待处理样本队列已满而丢弃的样本数
+    uint64_t droppedSampleCount() const;
+    
+    // 更新系统状态（兼容接口，写入默认站点设备）
     void updateSystemStatus(const SystemStatus& status);
     
-    // 确认安全异常恢复
+    // 确认安全异常恢复（按异常键）
+    bool confirmSafetyAnomalyRecovery(AnomalyKey key);
+    
+    // 确认安全异常恢复（按异常描述或规则名称，如"氢浓度异常"）
     void confirmSafetyAnomalyRecovery(const std::string& anomaly_id);
     
     // 设置控制参数
@@ -79,36 +183,161 @@ public:
                              double max_hydrogen_pressure,
                              int anomaly_duration_threshold_ms);
     
+    // 设置恢复爬坡速率（额定功率百分比/分钟，默认5%/分钟）
+    void setRecoveryRampRate(double percent_per_minute);
+    
     // 功能使能控制
     void enableMonitoring(bool enabled);
     
     // 回调函数类型定义
-    using StatusCallback = std::function<void(const std::string& status)>;
-    using ControlCallback = std::function<void(const std::string& device, double power)>;
-    using SafetyCallback = std::function<void(const std::string& action)>;
+    using EventCallback = CallbackDispatcher::EventCallback;
+    using StatusCallback = CallbackDispatcher::StatusCallback;
+    using ControlCallback = CallbackDispatcher::ControlCallback;
+    using SafetyCallback = CallbackDispatcher::SafetyCallback;
+    using ControlBatchCallback = CallbackDispatcher::ControlBatchCallback;
+    using SubscriberId = CallbackDispatcher::SubscriberId;
     
-    // 注册回调函数
+    // 注册回调函数（回调由分发线程异步调用，不在异常数据锁内执行）。
+    // 事件回调收到定长事件记录；状态、控制与安全回调收到由事件生成的文本，仅在注册后生成
+    void setEventCallback(EventCallback callback);
     void setStatusCallback(StatusCallback callback);
     void setControlCallback(ControlCallback callback);
     void setSafetyCallback(SafetyCallback callback);
+    
+    // 批量控制回调：每轮扫描的处置动作与期间到期的爬坡设定值按控制目标合并后一次下发，
+    // 同一目标按安全异常 > 事故级 > 一般级的优先级只保留一条（同级取较低的设定）。
+    // 单条控制回调收到的也是合并后的设定
+    void setControlBatchCallback(ControlBatchCallback callback);
+    
+    // 增加/注销订阅者：同类可有多个，运行中注册与替换不影响监测（如部署时切换SCADA发布程序）
+    SubscriberId addEventSubscriber(EventCallback callback);
+    SubscriberId addStatusSubscriber(StatusCallback callback);
+    SubscriberId addControlSubscriber(ControlCallback callback);
+    SubscriberId addSafetySubscriber(SafetyCallback callback);
+    SubscriberId addControlBatchSubscriber(ControlBatchCallback callback);
+    bool removeSubscriber(SubscriberId id);
+    
+    // 按异常类型、等级、事件类别与设备过滤订阅：每个订阅者有自己的有界队列与投递线程，
+    // 慢速订阅者按其背压策略丢弃或等待，不影响其他订阅者，也不延迟功率设定与安全操作
+    SubscriberId subscribe(const EventSubscription& subscription, EventCallback callback);
+    std::vector<SubscriberMetrics> getSubscriberMetrics() const; // 各订阅者的丢弃数与积压
+    
+    // 等待已产生的回调全部投递完成（不可在回调中调用）
+    void flushCallbacks();
 
 private:
     // 内部方法
     void checkAnomalies();                          // 检查异常
-    void handleAnomaly(const AnomalyInfo& anomaly); // 处理异常
+    void compileRules();                            // 按当前控制参数编译规则
+    void createDerivedDetectors();                  // 按设备集合创建变化率、漂移检测器与趋势预测器
+    void checkDerivedSample(const TelemetrySample& sample); // 样本接入派生通道检测器并检测派生通道
+    void checkSampleValue(DeviceIndex device, TelemetryChannel channel, double value,
+                          std::chrono::system_clock::time_point time); // 样本接入统计流并按规则检测
+    void createStatisticStreams();                  // 为使用统计量的规则分配统计流
+    void handleVoltageEvent(const TimedVoltageEvent& event); // 处理电压暂降/暂升事件
+    void updateStatisticStreams();                  // 以快照中有写入的设备更新统计流
+    const double* ruleValues(const CompiledRule& rule) const; // 规则判定对象的整列取值
+    const uint64_t* ruleChanges(const CompiledRule& rule); // 规则判定对象本轮有变化的设备（位图）
+    double ruleValue(const CompiledRule& rule, DeviceIndex device) const; // 规则判定对象的单台设备取值
+    void updateDerivedChannels(); // 以快照中有写入的设备更新派生通道列
+    void rebuildWaveformInputs();                   // 按新的额定参数重建波形前端（持有waveform_mutex_）
+    int forecasterOfOutput(DeviceClass device_class, TelemetryChannel output) const; // 以派生通道查找预测器
+    void raiseAnomaly(const CompiledRule& rule, DeviceIndex device, int level, double value,
+                      std::chrono::system_clock::time_point time); // 构造越限异常并处理
+    void handleAnomaly(const AnomalyInfo& detected); // 处理异常
+    void activateAnomaly(AnomalyInfo& anomaly);     // 确认异常并执行处置动作
+    void executeAnomalyActions(AnomalyInfo& anomaly); // 按规则执行当前等级的处置动作
+    int64_t confirmPendingAnomalies();              // 确认已持续满窗口的异常，返回下次到期时间(ms)
+    int64_t timerNowMs() const;                     // 确认定时器时间(ms)
     void handleAnomalyRecovery(const AnomalyInfo& anomaly); // 处理异常恢复
-    AnomalyLevel determineAnomalyLevel(AnomalyType type, double value); // 确定异常等级
+    bool hasPowerAction(const AnomalyInfo& anomaly) const; // 是否执行过停机或降功率动作
+    double recoveryStartPower(DeviceIndex device);  // 恢复爬坡起点：最近下发的设定功率，无则取实测功率
     bool isAnomalyResolved(const AnomalyInfo& anomaly); // 检查异常是否已解决
+    bool isClearSustained(AnomalyInfo& anomaly, int64_t now_ms, int64_t& next_check_ms); // 恢复条件是否已持续满最短恢复时间
+    void registerDefaultDevices();                  // 注册默认站点设备
+    void notifyTelemetry();                         // 新数据到达，唤醒监测线程
+    void wakeMonitor();                             // 状态变化，唤醒监测线程
+    void recordDetection();                         // 记录检测时延
+    void onRampComplete(const RampState& ramp);     // 恢复爬坡完成
+    // 打开异常日志并恢复活动异常与历史（initialize()中）；replayed为日志中未结束异常的键（含待确认），
+    // pending为日志中待确认的异常，由检查点补充确认计时后恢复
+    bool restoreFromJournal(std::unordered_set<AnomalyKey>& replayed,
+                            std::unordered_map<AnomalyKey, AnomalyInfo>& pending);
+    void journalAnomaly(JournalEvent event, const AnomalyInfo& anomaly); // 记录异常生命周期事件（持有anomaly_mutex_）
+    void postAnomalyEvent(ControllerEventKind kind, const AnomalyInfo& anomaly,
+                          uint32_t actions = ACTION_NONE); // 产生异常相关的状态事件
+    void postSetpoint(const AnomalyInfo& anomaly, double power_kw); // 将处置动作的功率设定并入本轮批次
+    void mergeRampSteps(const std::vector<RampState>& steps); // 爬坡设定值并入本轮批次（爬坡调度线程）
+    void flushSetpoints();                          // 下发本轮合并后的功率设定
+    void postSetpointBatch(SetpointBatch& batch);   // 以同一批次号下发并清空批次
+    void postSafetyAction(SafetyAction action, const AnomalyInfo& anomaly); // 产生安全操作事件
+    void deferSafetyAction(SafetyAction action, const AnomalyInfo& anomaly); // 暂存处置动作的安全操作（持有anomaly_mutex_）
+    void flushSafetyActions();                      // 入队暂存的安全操作（监测线程，不持有anomaly_mutex_）
+    void postDeviceEvent(ControllerEventKind kind, DeviceIndex device, AnomalyKey key,
+                         double power_kw);          // 产生恢复爬坡的完成事件
+    ControllerEvent deviceEvent(ControllerEventKind kind, DeviceIndex device, AnomalyKey key,
+                                double power_kw) const; // 构造恢复爬坡的设定值与完成事件
+    void postEvent(ControllerEvent& event);         // 记录事件时间并入队
+    void describeAnomaly(AnomalyInfo& anomaly) const; // 按描述数值生成异常描述
+    void appendDescription(RuleId rule, const AnomalyDetail& detail, std::string& text) const; // 追加异常描述文本
+    void formatEvent(const ControllerEvent& event, std::string& text) const; // 生成字符串订阅者收到的文本（分发线程）
+    ControllerCheckpoint captureCheckpoint(bool clean_shutdown); // 采集状态检查点（监测线程）
+    void restoreCheckpoint(const std::unordered_set<AnomalyKey>& replayed,
+                           std::unordered_map<AnomalyKey, AnomalyInfo>& pending); // 读取状态检查点并恢复（initialize()中）
+    void discardJournalPending(const std::unordered_map<AnomalyKey, AnomalyInfo>& pending); // 丢弃无法恢复计时的待确认异常
     
     // 成员变量
     std::atomic<bool> enabled_;                     // 监测使能标志
     
-    SystemStatus current_status_;                   // 当前系统状态
-    std::mutex status_mutex_;                       // 状态数据互斥锁
+    DeviceRegistry registry_;                       // 设备注册表（初始化后只读）
+    TelemetryStore telemetry_;                      // 共享遥测存储（顺序锁，写者无阻塞）
+    TelemetryTable scan_table_;                     // 监测线程扫描用的遥测快照
+    DirtyChannelSet changed_rows_;                  // 本轮快照中有写入的设备（仅监测线程）
+    bool full_scan_;                                // 本轮按整列扫描全部规则（仅监测线程）
+    std::atomic<bool> rescan_requested_;            // 请求下一轮整列扫描（活动异常被外部移除后）
+    std::mutex status_mutex_;                       // 设备注册、规则修改互斥锁
+    
+    std::vector<TelemetrySample> pending_samples_;  // 待检测样本（生产者追加）
+    std::vector<TelemetrySample> draining_samples_; // 监测线程正在处理的样本
+    std::mutex sample_mutex_;                       // 待检测样本互斥锁（每批一次）
+    std::atomic<uint64_t> dropped_samples_;         // 丢弃样本计数
+    
+    // 波形前端（在生产者线程中估计，结果经批量样本接口进入检测）
+    struct WaveformFrontEnd {
+        PhasorEstimator estimator;
+        VoltageEventDetector event_detector;
+        std::vector<PhasorMeasurement> cycles;      // 本次完成的周波（复用容量）
+        std::vector<TelemetrySample> samples;       // 转换后的样本（复用容量）
+        std::vector<VoltageEvent> events;           // 本次检出的电压事件（复用容量）
+    };
+    std::unordered_map<DeviceIndex, std::unique_ptr<WaveformFrontEnd>> waveform_inputs_;
+    std::mutex waveform_mutex_;                     // 波形前端互斥锁（每个采样块一次）
+    std::vector<TimedVoltageEvent> pending_voltage_events_;  // 待处理电压事件（受sample_mutex_保护）
+    std::vector<TimedVoltageEvent> draining_voltage_events_; // 监测线程正在处理的电压事件
+    
+    // 兼容SystemStatus接口的默认设备索引
+    struct LegacyDevices {
+        DeviceIndex pv = INVALID_DEVICE_INDEX;
+        DeviceIndex wind = INVALID_DEVICE_INDEX;
+        DeviceIndex ess = INVALID_DEVICE_INDEX;
+        DeviceIndex electrolyzer = INVALID_DEVICE_INDEX;
+        DeviceIndex grid = INVALID_DEVICE_INDEX;
+        DeviceIndex hydrogen = INVALID_DEVICE_INDEX;
+    } legacy_devices_;
     
-    std::map<std::string, AnomalyInfo> active_anomalies_; // 活动异常映射表
-    std::deque<AnomalyInfo> anomaly_history_;       // 异常历史记录
-    std::mutex anomaly_mutex_;                      // 异常数据互斥锁
+    ActiveAnomalyTable active_anomalies_;           // 活动异常表（按异常键索引）
+    AnomalyHistory anomaly_history_;                // 异常历史记录（有界，受anomaly_mutex_保护）
+    AnomalyJournal journal_;                        // 异常日志（未启用时不记录）
+    std::string journal_path_;                      // 异常日志路径，空为未启用（受status_mutex_保护）
+    std::atomic<uint64_t> restored_anomalies_;      // 由异常日志与状态检查点恢复的活动异常数
+    CheckpointStore checkpoint_store_;              // 状态检查点文件（未启用时不保存）
+    std::string checkpoint_path_;                   // 状态检查点路径，空为未启用（受status_mutex_保护）
+    std::chrono::milliseconds checkpoint_interval_; // 定期保存间隔，0为仅停机时（受status_mutex_保护）
+    std::vector<RampState> restored_ramps_;         // 待续接的恢复爬坡（监测循环开始时提交）
+    std::atomic<int64_t> checkpoint_restore_us_;    // 恢复状态检查点的耗时(us)，-1为未恢复
+    mutable std::mutex anomaly_mutex_;              // 异常数据互斥锁
+    TimingWheel pending_timers_;                    // 待确认异常的确认定时器（1ms/tick，受anomaly_mutex_保护）
+    std::chrono::steady_clock::time_point timer_epoch_; // 确认定时器时间零点
     
     // 控制参数（原子操作保证线程安全）
     std::atomic<double> normal_voltage_;            // 正常电压值(V)
@@ -116,13 +345,71 @@ private:
     std::atomic<double> max_hydrogen_concentration_; // 最大氢浓度(%)
     std::atomic<double> max_hydrogen_pressure_;     // 最大氢罐压力(MPa)
     std::atomic<int> anomaly_duration_threshold_ms_; // 异常持续时间阈值(ms)
+    std::atomic<double> recovery_rate_percent_per_minute_; // 恢复爬坡速率(%/分钟)
     
-    std::mutex callback_mutex_;                     // 回调函数互斥锁
-    StatusCallback status_callback_;                // 状态回调函数
-    ControlCallback control_callback_;              // 控制回调函数
-    SafetyCallback safety_callback_;                // 安全回调函数
+    AnomalyRuleEngine rules_;                       // 检测规则及编译后的执行计划（仅监测线程重新编译）
+    std::atomic<bool> rules_dirty_;                 // 控制参数已变化，下一轮扫描前重新编译
+    std::vector<uint64_t> screen_mask_;             // 越限位图（仅监测线程）
+    std::vector<RateOfChangeDetector> rate_detectors_; // 变化率检测器（仅监测线程）
+    int8_t rate_detector_of_[DEVICE_CLASS_COUNT][TELEMETRY_CHANNEL_COUNT]; // 以源通道索引检测器下标，-1为无
+    std::vector<DriftDetector> drift_detectors_;    // 漂移检测器（仅监测线程）
+    int8_t drift_detector_of_[DEVICE_CLASS_COUNT][TELEMETRY_CHANNEL_COUNT]; // 以源通道索引检测器下标，-1为无
+    std::vector<TrendForecaster> forecasters_;      // 趋势预测器（仅监测线程）
+    int8_t forecaster_of_[DEVICE_CLASS_COUNT][TELEMETRY_CHANNEL_COUNT]; // 以源通道索引预测器下标，-1为无
+    int32_t forecast_horizon_ms_[TELEMETRY_CHANNEL_COUNT]; // 各源通道设置的预测时域，-1为内置值（受status_mutex_保护）
+    
+    // 通道统计流：同一（设备类别, 通道, 统计量, 窗口, 采样间隔）的规则共用一个流（仅监测线程）
+    struct StatisticStream {
+        DeviceClass device_class;
+        TelemetryChannel channel;
+        StreamStatistics stats;
+        std::vector<uint64_t> changed;              // 本轮统计量有变化的设备（位图）
+    };
+    std::vector<StatisticStream> statistic_streams_;
+    std::vector<uint32_t> streams_of_channel_[DEVICE_CLASS_COUNT][TELEMETRY_CHANNEL_COUNT]; // 以源通道索引统计流
+    std::vector<int32_t> rule_streams_;             // 以规则标识索引统计流下标，-1为原值
+    std::atomic<uint64_t> statistic_overflows_;     // 各统计流的溢出数之和（每轮扫描更新）
+    
+    CallbackDispatcher dispatcher_;                 // 异步回调分发器（检测路径只入队）
+    SetpointBatch scan_setpoints_;                  // 本轮的处置动作与爬坡设定值（受anomaly_mutex_保护）
+    std::vector<ControllerEvent> scan_safety_actions_; // 本轮处置动作的安全操作（受anomaly_mutex_保护）
+    std::vector<ControllerEvent> issuing_safety_actions_; // 正在入队的安全操作（仅监测线程）
+    std::mutex issue_mutex_;                        // 串行化批次下发，先交换的批次先入队（先于anomaly_mutex_获取）
+    SetpointBatch issuing_setpoints_;               // 正在下发的批次（受issue_mutex_保护）
+    std::unordered_map<std::string, double> commanded_kw_; // 各控制目标最近下发的设定功率（受anomaly_mutex_保护）
+    std::atomic<uint64_t> next_setpoint_batch_;     // 设定批次号
+    std::atomic<bool> setpoints_pending_;           // 爬坡设定值已并入本轮批次，待监测线程下发
     
     std::atomic<bool> running_;                     // 运行状态标志
+    std::atomic<bool> initialized_;                 // 设备集合已冻结、存储已分配
+    
+    // 事件驱动唤醒
+    std::mutex wake_mutex_;                         // 唤醒互斥锁
+    std::condition_variable wake_cv_;               // 唤醒条件变量
+    std::atomic<bool> wake_pending_;                // 有待处理的新数据
+    std::atomic<int64_t> pending_since_ns_;         // 本轮首个新数据到达时间(steady, ns)
+    std::atomic<int64_t> min_scan_period_us_;       // 最小扫描周期(us)
+    int64_t scan_trigger_ns_;                       // 当前扫描对应的数据到达时间（仅监测线程）
+    
+    // 运行指标
+    std::atomic<uint64_t> scan_count_;
+    std::atomic<uint64_t> event_wakeups_;
+    std::atomic<uint64_t> detection_count_;
+    std::atomic<uint64_t> confirmed_anomalies_;
+    std::atomic<uint64_t> transient_anomalies_;
+    std::atomic<uint64_t> pending_anomalies_;
+    std::atomic<uint64_t> suppressed_transitions_;
+    std::atomic<uint64_t> voltage_events_;
+    std::atomic<uint64_t> setpoint_batches_;
+    std::atomic<uint64_t> issued_setpoints_;
+    std::atomic<uint64_t> coalesced_setpoints_;
+    std::atomic<int64_t> last_latency_us_;
+    std::atomic<int64_t> max_latency_us_;
+    std::atomic<int64_t> total_latency_us_;
+    std::atomic<int64_t> last_scan_us_;
+    std::atomic<int64_t> max_scan_us_;
+    
+    RampScheduler ramp_scheduler_;                  // 恢复爬坡调度器（最后声明、最先析构：调度线程先于其回调使用的成员停止）
 };
 
 #endif // ANOMALY_MONITORING_CONTROLLER_H
\ No newline at end of file
@@ -0,0 +1,289 @@
+// anomaly_rules.cpp
+#include "anomaly_rules.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 基准倍数换算为绝对阈值（无穷表示不限制，保持不变）
+inline double scaleThreshold(double factor, double base) {
+    return std::isinf(factor) ? factor : factor * base;
+}
+
+const std::string kEmptyName;
+
+} // namespace
+
+AnomalyRuleEngine::AnomalyRuleEngine() {
+    std::fill(std::begin(group_offsets_), std::end(group_offsets_), 0u);
+}
+
+// 登记内置规则（越限阈值与原判定逻辑一致；恢复条件留有回差，
+// 并须持续满足1s才解除，避免取值在限值附近波动时反复告警与恢复）
+void AnomalyRuleEngine::loadBuiltinRules() {
+    const AnomalyRuleSpec kBuiltinRules[] = {
+        // 设备故障：故障标志置位即为事故级，设备停机
+        {RULE_PV_INVERTER_FAULT, "光伏逆变器故障", "", DeviceClass::PV_INVERTER,
+         TelemetryChannel::FAULT, AnomalyType::DEVICE_FAULT, ThresholdBase::ABSOLUTE,
+         {DISABLED_BAND, DISABLED_BAND, {-NO_LIMIT, 0.5}}, {-NO_LIMIT, 0.5},
+         {ACTION_NONE, ACTION_NONE, ACTION_SHUTDOWN}, false},
+        {RULE_WIND_CONTROLLER_FAULT, "风机控制器故障", "", DeviceClass::WIND_CONTROLLER,
+         TelemetryChannel::FAULT, AnomalyType::DEVICE_FAULT, ThresholdBase::ABSOLUTE,
+         {DISABLED_BAND, DISABLED_BAND, {-NO_LIMIT, 0.5}}, {-NO_LIMIT, 0.5},
+         {ACTION_NONE, ACTION_NONE, ACTION_SHUTDOWN}, false},
+        {RULE_ESS_PCS_FAULT, "储能PCS故障", "", DeviceClass::ESS_PCS,
+         TelemetryChannel::FAULT, AnomalyType::DEVICE_FAULT, ThresholdBase::ABSOLUTE,
+         {DISABLED_BAND, DISABLED_BAND, {-NO_LIMIT, 0.5}}, {-NO_LIMIT, 0.5},
+         {ACTION_NONE, ACTION_NONE, ACTION_SHUTDOWN}, false},
+        {RULE_ELECTROLYZER_FAULT, "电解槽故障", "", DeviceClass::ELECTROLYZER,
+         TelemetryChannel::FAULT, AnomalyType::DEVICE_FAULT, ThresholdBase::ABSOLUTE,
+         {DISABLED_BAND, DISABLED_BAND, {-NO_LIMIT, 0.5}}, {-NO_LIMIT, 0.5},
+         {ACTION_NONE, ACTION_NONE, ACTION_SHUTDOWN}, false},
+        // 电网电压：偏离±10%为一般级，±15%为事故级；回到±8%以内恢复
+        {RULE_GRID_VOLTAGE, "电网电压异常", "V", DeviceClass::GRID,
+         TelemetryChannel::GRID_VOLTAGE, AnomalyType::GRID_FAULT, ThresholdBase::NORMAL_VOLTAGE,
+         {DISABLED_BAND, {0.9, 1.1}, {0.85, 1.15}}, {0.92, 1.08},
+         {ACTION_NONE, ACTION_NONE, ACTION_SHUTDOWN | ACTION_PROTECT_CRITICAL_LOAD}, false,
+         DEFAULT_PERSISTENCE, 1000},
+        // 电网频率：偏离±1%(50Hz下±0.5Hz)为一般级，±2%为事故级；回到±0.8%以内恢复
+        {RULE_GRID_FREQUENCY, "电网频率异常", "Hz", DeviceClass::GRID,
+         TelemetryChannel::GRID_FREQUENCY, AnomalyType::GRID_FAULT, ThresholdBase::NORMAL_FREQUENCY,
+         {DISABLED_BAND, {0.99, 1.01}, {0.98, 1.02}}, {0.992, 1.008},
+         {ACTION_NONE, ACTION_NONE, ACTION_SHUTDOWN | ACTION_PROTECT_CRITICAL_LOAD}, false,
+         DEFAULT_PERSISTENCE, 1000},
+        // 氢浓度：达到上限为提示级，1.5倍为一般级，2倍为事故级；降到上限的90%以下恢复
+        {RULE_HYDROGEN_CONCENTRATION, "氢浓度异常", "%", DeviceClass::HYDROGEN_SYSTEM,
+         TelemetryChannel::HYDROGEN_CONCENTRATION, AnomalyType::SAFETY_FAULT,
+         ThresholdBase::MAX_HYDROGEN_CONCENTRATION,
+         {{-NO_LIMIT, 1.0}, {-NO_LIMIT, 1.5}, {-NO_LIMIT, 2.0}}, {-NO_LIMIT, 0.9},
+         {ACTION_NONE, ACTION_NONE,
+          ACTION_SHUTDOWN | ACTION_START_VENTILATION | ACTION_ENTER_SAFE_MODE}, true,
+         DEFAULT_PERSISTENCE, 1000},
+        // 氢罐压力：分级同氢浓度
+        {RULE_HYDROGEN_PRESSURE, "氢罐压力异常", "MPa", DeviceClass::HYDROGEN_SYSTEM,
+         TelemetryChannel::HYDROGEN_TANK_PRESSURE, AnomalyType::SAFETY_FAULT,
+         ThresholdBase::MAX_HYDROGEN_PRESSURE,
+         {{-NO_LIMIT, 1.0}, {-NO_LIMIT, 1.5}, {-NO_LIMIT, 2.0}}, {-NO_LIMIT, 0.9},
+         {ACTION_NONE, ACTION_NONE,
+          ACTION_SHUTDOWN | ACTION_START_PRESSURE_RELIEF | ACTION_ENTER_SAFE_MODE}, true,
+         DEFAULT_PERSISTENCE, 1000},
+        // 频率变化率(ROCOF)：超过0.5Hz/s为一般级，1Hz/s为事故级；在频率越限前提前发现孤网频率崩溃，
+        // 确认窗口200ms（变化率已经过窗口与滤波平滑）
+        {RULE_GRID_ROCOF, "电网频率变化率异常", "Hz/s", DeviceClass::GRID,
+         TelemetryChannel::GRID_ROCOF, AnomalyType::GRID_FAULT, ThresholdBase::ABSOLUTE,
+         {DISABLED_BAND, {-0.5, 0.5}, {-1.0, 1.0}}, {-0.2, 0.2},
+         {ACTION_NONE, ACTION_NONE, ACTION_SHUTDOWN | ACTION_PROTECT_CRITICAL_LOAD}, false,
+         200, 1000},
+        // 氢罐压力上升速率：每秒超过最大压力的2%为一般级，5%为事故级，确认窗口500ms
+        {RULE_HYDROGEN_PRESSURE_RATE, "氢罐压力上升过快", "MPa/s", DeviceClass::HYDROGEN_SYSTEM,
+         TelemetryChannel::HYDROGEN_PRESSURE_RATE, AnomalyType::SAFETY_FAULT,
+         ThresholdBase::MAX_HYDROGEN_PRESSURE,
+         {DISABLED_BAND, {-NO_LIMIT, 0.02}, {-NO_LIMIT, 0.05}}, {-NO_LIMIT, 0.01},
+         {ACTION_NONE, ACTION_NONE, ACTION_SHUTDOWN | ACTION_START_PRESSURE_RELIEF}, true,
+         500, 1000},
+        // 电压暂降/暂升：由波形前端的半周波事件检测器按IEC 61000-4-30判定起止，
+        // 残余电压低于70%（含中断）或暂升超过120%为事故级，其余为一般级
+        {RULE_VOLTAGE_DIP, "电压暂降", "V", DeviceClass::GRID,
+         TelemetryChannel::GRID_VOLTAGE, AnomalyType::GRID_FAULT, ThresholdBase::NORMAL_VOLTAGE,
+         {DISABLED_BAND, DISABLED_BAND, DISABLED_BAND}, DISABLED_BAND,
+         {ACTION_NONE, ACTION_NONE, ACTION_NONE}, false,
+         0, 0, ChannelStatistic::VALUE, 0, true},
+        {RULE_VOLTAGE_SWELL, "电压暂升", "V", DeviceClass::GRID,
+         TelemetryChannel::GRID_VOLTAGE, AnomalyType::GRID_FAULT, ThresholdBase::NORMAL_VOLTAGE,
+         {DISABLED_BAND, DISABLED_BAND, DISABLED_BAND}, DISABLED_BAND,
+         {ACTION_NONE, ACTION_NONE, ACTION_NONE}, false,
+         0, 0, ChannelStatistic::VALUE, 0, true},
+        // 氢浓度/氢罐压力漂移：派生通道为变点检测统计量与门限之比，达到门限为提示级，3倍为一般级，
+        // 在绝对值越限前提前发现缓慢泄漏；统计量已按时间累积，无需确认窗口，回落到0.2以下且维持1min恢复
+        {RULE_HYDROGEN_CONCENTRATION_DRIFT, "氢浓度缓慢上升", "", DeviceClass::HYDROGEN_SYSTEM,
+         TelemetryChannel::HYDROGEN_CONCENTRATION_DRIFT, AnomalyType::SAFETY_FAULT,
+         ThresholdBase::ABSOLUTE,
+         {{-NO_LIMIT, 1.0}, {-NO_LIMIT, 3.0}, DISABLED_BAND}, {-NO_LIMIT, 0.2},
+         {ACTION_NONE, ACTION_START_VENTILATION, ACTION_NONE}, false,
+         0, 60000},
+        {RULE_HYDROGEN_PRESSURE_DRIFT, "氢罐压力漂移", "", DeviceClass::HYDROGEN_SYSTEM,
+         TelemetryChannel::HYDROGEN_PRESSURE_DRIFT, AnomalyType::SAFETY_FAULT,
+         ThresholdBase::ABSOLUTE,
+         {{-1.0, 1.0}, {-3.0, 3.0}, DISABLED_BAND}, {-0.2, 0.2},
+         {ACTION_NONE, ACTION_NONE, ACTION_NONE}, false,
+         0, 60000},
+        // 氢浓度/氢罐压力预计越限：预测时域末的外推值达到上限为一般级，提前启动通风/泄压以抵消执行机构延迟；
+        // 外推已经过滤波与显著性检验，无需确认窗口，回落到上限的95%以下且维持5s恢复
+        {RULE_HYDROGEN_CONCENTRATION_FORECAST, "氢浓度预计越限", "%", DeviceClass::HYDROGEN_SYSTEM,
+         TelemetryChannel::HYDROGEN_CONCENTRATION_FORECAST, AnomalyType::SAFETY_FAULT,
+         ThresholdBase::MAX_HYDROGEN_CONCENTRATION,
+         {DISABLED_BAND, {-NO_LIMIT, 1.0}, DISABLED_BAND}, {-NO_LIMIT, 0.95},
+         {ACTION_NONE, ACTION_START_VENTILATION, ACTION_NONE}, false,
+         0, 5000},
+        {RULE_HYDROGEN_PRESSURE_FORECAST, "氢罐压力预计越限", "MPa", DeviceClass::HYDROGEN_SYSTEM,
+         TelemetryChannel::HYDROGEN_PRESSURE_FORECAST, AnomalyType::SAFETY_FAULT,
+         ThresholdBase::MAX_HYDROGEN_PRESSURE,
+         {DISABLED_BAND, {-NO_LIMIT, 1.0}, DISABLED_BAND}, {-NO_LIMIT, 0.95},
+         {ACTION_NONE, ACTION_START_PRESSURE_RELIEF, ACTION_NONE}, false,
+         0, 5000},
+    };
+    for (const AnomalyRuleSpec& spec : kBuiltinRules) {
+        addRule(spec);
+    }
+}
+
+// 登记规则
+bool AnomalyRuleEngine::addRule(const AnomalyRuleSpec& spec) {
+    if (spec.id == 0 || spec.device_class >= DeviceClass::COUNT ||
+        spec.channel >= TelemetryChannel::COUNT || spec.base >= ThresholdBase::COUNT ||
+        spec.statistic > ChannelStatistic::MAX ||
+        (spec.statistic != ChannelStatistic::VALUE && spec.statistic_window_ms <= 0) ||
+        spec.statistic_sample_ms < 0) {
+        return false;
+    }
+    if (spec.id >= spec_slots_.size()) {
+        spec_slots_.resize(static_cast<size_t>(spec.id) + 1, NO_RULE);
+    }
+    if (spec_slots_[spec.id] != NO_RULE) {
+        return false; // 规则标识重复
+    }
+    spec_slots_[spec.id] = static_cast<uint32_t>(specs_.size());
+    specs_.push_back(spec);
+    return true;
+}
+
+// 修改滞回参数
+bool AnomalyRuleEngine::setHysteresis(RuleId id, ThresholdBand clear, int32_t min_clear_ms) {
+    if (id >= spec_slots_.size() || spec_slots_[id] == NO_RULE) {
+        return false;
+    }
+    AnomalyRuleSpec& spec = specs_[spec_slots_[id]];
+    spec.clear = clear;
+    spec.min_clear_ms = std::max<int32_t>(0, min_clear_ms);
+    return true;
+}
+
+// 编译执行计划：按（设备类别, 通道）分组连续存放，阈值逐台设备换算成列
+void AnomalyRuleEngine::compile(const double* base_values, const DeviceRegistry& registry) {
+    plan_.clear();
+    plan_.reserve(specs_.size());
+    for (size_t i = 0; i < specs_.size(); ++i) {
+        const AnomalyRuleSpec& spec = specs_[i];
+        CompiledRule rule = {};
+        rule.level_mask = 0;
+        for (size_t level = 0; level < ANOMALY_LEVEL_COUNT; ++level) {
+            rule.actions[level] = spec.actions[level];
+            if (!std::isinf(spec.raise[level].low) || !std::isinf(spec.raise[level].high)) {
+                rule.level_mask |= static_cast<uint8_t>(1u << level);
+            }
+        }
+        rule.id = spec.id;
+        rule.device_class = spec.device_class;
+        rule.channel = spec.channel;
+        rule.type = spec.type;
+        rule.needs_manual_confirmation = spec.needs_manual_confirmation;
+        rule.persistence_ms = spec.persistence_ms;
+        rule.min_clear_ms = spec.min_clear_ms;
+        rule.statistic = spec.statistic;
+        rule.statistic_window_ms = spec.statistic_window_ms;
+        rule.statistic_sample_ms = spec.statistic_sample_ms;
+        rule.event_driven = spec.event_driven;
+        rule.spec_index = static_cast<uint32_t>(i);
+        rule.rows = static_cast<uint32_t>(registry.deviceCount(spec.device_class));
+        plan_.push_back(rule);
+    }
+    std::stable_sort(plan_.begin(), plan_.end(), [](const CompiledRule& a, const CompiledRule& b) {
+        return groupOf(a.device_class, a.channel) < groupOf(b.device_class, b.channel);
+    });
+
+    // 阈值列：依次为各等级、恢复条件、合并带的下限与上限；
+    // 只有按额定功率换算的规则逐台设备存放，其余规则只存一行
+    constexpr size_t COLUMNS = (ANOMALY_LEVEL_COUNT + 2) * 2;
+    constexpr size_t CLEAR_COLUMN = ANOMALY_LEVEL_COUNT * 2;
+    constexpr size_t SCREEN_COLUMN = CLEAR_COLUMN + 2;
+    thresholds_.resize(plan_.size());
+    for (size_t i = 0; i < plan_.size(); ++i) {
+        CompiledRule& rule = plan_[i];
+        const AnomalyRuleSpec& spec = specs_[rule.spec_index];
+        bool per_device = spec.base == ThresholdBase::RATED_POWER;
+        size_t rows = per_device ? rule.rows : 1;
+        rule.stride = per_device ? 1 : 0;
+        std::vector<double>& storage = thresholds_[i];
+        storage.assign(COLUMNS * rows, 0.0);
+        double* columns = storage.data();
+        for (size_t row = 0; row < rows; ++row) {
+            double base = base_values[static_cast<size_t>(spec.base)];
+            if (spec.base == ThresholdBase::ABSOLUTE) {
+                base = 1.0;
+            } else if (per_device) {
+                base = registry.info(makeDeviceIndex(spec.device_class, static_cast<uint32_t>(row))).rated_power_kw;
+            }
+            double screen_low = -NO_LIMIT;
+            double screen_high = NO_LIMIT;
+            for (size_t level = 0; level < ANOMALY_LEVEL_COUNT; ++level) {
+                double low = scaleThreshold(spec.raise[level].low, base);
+                double high = scaleThreshold(spec.raise[level].high, base);
+                columns[(level * 2) * rows + row] = low;
+                columns[(level * 2 + 1) * rows + row] = high;
+                screen_low = std::max(screen_low, low);
+                screen_high = std::min(screen_high, high);
+            }
+            columns[CLEAR_COLUMN * rows + row] = scaleThreshold(spec.clear.low, base);
+            columns[(CLEAR_COLUMN + 1) * rows + row] = scaleThreshold(spec.clear.high, base);
+            columns[SCREEN_COLUMN * rows + row] = screen_low;
+            columns[(SCREEN_COLUMN + 1) * rows + row] = screen_high;
+        }
+        for (size_t level = 0; level < ANOMALY_LEVEL_COUNT; ++level) {
+            rule.low[level] = columns + (level * 2) * rows;
+            rule.high[level] = columns + (level * 2 + 1) * rows;
+        }
+        rule.clear_low = columns + CLEAR_COLUMN * rows;
+        rule.clear_high = columns + (CLEAR_COLUMN + 1) * rows;
+        rule.screen_low = columns + SCREEN_COLUMN * rows;
+        rule.screen_high = columns + (SCREEN_COLUMN + 1) * rows;
+    }
+
+    std::fill(std::begin(group_offsets_), std::end(group_offsets_), 0u);
+    for (const CompiledRule& rule : plan_) {
+        ++group_offsets_[groupOf(rule.device_class, rule.channel) + 1];
+    }
+    for (size_t group = 0; group < GROUP_COUNT; ++group) {
+        group_offsets_[group + 1] += group_offsets_[group];
+    }
+
+    plan_slots_.assign(spec_slots_.size(), NO_RULE);
+    for (size_t i = 0; i < plan_.size(); ++i) {
+        plan_slots_[plan_[i].id] = static_cast<uint32_t>(i);
+    }
+}
+
+const CompiledRule* AnomalyRuleEngine::rulesBegin(DeviceClass device_class, TelemetryChannel channel) const {
+    return plan_.data() + group_offsets_[groupOf(device_class, channel)];
+}
+
+const CompiledRule* AnomalyRuleEngine::rulesEnd(DeviceClass device_class, TelemetryChannel channel) const {
+    return plan_.data() + group_offsets_[groupOf(device_class, channel) + 1];
+}
+
+const CompiledRule* AnomalyRuleEngine::compiled(RuleId id) const {
+    if (id >= plan_slots_.size() || plan_slots_[id] == NO_RULE) {
+        return nullptr;
+    }
+    return &plan_[plan_slots_[id]];
+}
+
+const AnomalyRuleSpec* AnomalyRuleEngine::spec(RuleId id) const {
+    if (id >= spec_slots_.size() || spec_slots_[id] == NO_RULE) {
+        return nullptr;
+    }
+    return &specs_[spec_slots_[id]];
+}
+
+RuleId AnomalyRuleEngine::findByName(const std::string& name) const {
+    for (const AnomalyRuleSpec& spec : specs_) {
+        if (spec.name == name) {
+            return spec.id;
+        }
+    }
+    return 0;
+}
+
+const std::string& AnomalyRuleEngine::ruleName(RuleId id) const {
+    const AnomalyRuleSpec* rule = spec(id);
+    return rule == nullptr ? kEmptyName : rule->name;
+}
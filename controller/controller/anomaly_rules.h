@@ -0,0 +1,257 @@
+// anomaly_rules.h
+#ifndef ANOMALY_RULES_H
+#define ANOMALY_RULES_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <vector>
+#include "anomaly_types.h"
+#include "device_registry.h"
+#include "stream_statistics.h"
+#include "threshold_kernel.h"
+
+// 内置检测规则
+enum BuiltinRule : RuleId {
+    RULE_PV_INVERTER_FAULT = 1,     // 光伏逆变器故障
+    RULE_WIND_CONTROLLER_FAULT,     // 风机控制器故障
+    RULE_ESS_PCS_FAULT,             // 储能PCS故障
+    RULE_ELECTROLYZER_FAULT,        // 电解槽故障
+    RULE_GRID_VOLTAGE,              // 电网电压异常
+    RULE_GRID_FREQUENCY,            // 电网频率异常
+    RULE_HYDROGEN_CONCENTRATION,    // 氢浓度异常
+    RULE_HYDROGEN_PRESSURE,         // 氢罐压力异常
+    RULE_GRID_ROCOF,                // 电网频率变化率异常
+    RULE_HYDROGEN_PRESSURE_RATE,    // 氢罐压力上升过快
+    RULE_VOLTAGE_DIP,               // 电压暂降（半周波事件）
+    RULE_VOLTAGE_SWELL,             // 电压暂升（半周波事件）
+    RULE_HYDROGEN_CONCENTRATION_DRIFT, // 氢浓度缓慢上升（变点检测）
+    RULE_HYDROGEN_PRESSURE_DRIFT,   // 氢罐压力漂移（变点检测）
+    RULE_HYDROGEN_CONCENTRATION_FORECAST, // 氢浓度预计越限（趋势预测）
+    RULE_HYDROGEN_PRESSURE_FORECAST // 氢罐压力预计越限（趋势预测）
+};
+
+constexpr size_t ANOMALY_LEVEL_COUNT = 3;
+constexpr int32_t DEFAULT_PERSISTENCE = -1; // 使用控制参数中的异常持续时间阈值
+
+// 阈值基准：规则阈值以基准参数的倍数给出，控制参数变化后重新编译
+enum class ThresholdBase : uint8_t {
+    ABSOLUTE,                       // 绝对值（倍数即阈值）
+    NORMAL_VOLTAGE,                 // 正常电压
+    NORMAL_FREQUENCY,               // 正常频率
+    MAX_HYDROGEN_CONCENTRATION,     // 最大氢浓度
+    MAX_HYDROGEN_PRESSURE,          // 最大氢罐压力
+    RATED_POWER,                    // 设备额定功率（逐台设备取值）
+    COUNT
+};
+
+constexpr size_t THRESHOLD_BASE_COUNT = static_cast<size_t>(ThresholdBase::COUNT);
+
+// 限值带：取值 <= low 或 >= high 即越限，不限制的一侧取±无穷
+struct ThresholdBand {
+    double low;
+    double high;
+};
+
+constexpr double NO_LIMIT = std::numeric_limits<double>::infinity();
+constexpr ThresholdBand DISABLED_BAND = {-NO_LIMIT, NO_LIMIT}; // 该等级不启用
+
+// 规则动作（按位组合，按等级配置）
+enum RuleAction : uint32_t {
+    ACTION_NONE = 0,
+    ACTION_DERATE_HALF = 1u << 0,           // 设备功率减半
+    ACTION_SHUTDOWN = 1u << 1,              // 设备停机
+    ACTION_PROTECT_CRITICAL_LOAD = 1u << 2, // 孤岛模式下保障重要负荷
+    ACTION_START_VENTILATION = 1u << 3,     // 启动通风系统
+    ACTION_START_PRESSURE_RELIEF = 1u << 4, // 启动泄压系统
+    ACTION_ENTER_SAFE_MODE = 1u << 5        // 转入保安全模式
+};
+
+// 规则定义（声明式）
+struct AnomalyRuleSpec {
+    RuleId id;                              // 规则标识（非0且唯一）
+    std::string name;                       // 规则名称，同时作为异常描述前缀
+    std::string unit;                       // 描述中测量值的单位，为空时不显示取值（标志量）
+    DeviceClass device_class;               // 适用设备类别
+    TelemetryChannel channel;               // 检测通道
+    AnomalyType type;                       // 异常类型
+    ThresholdBase base;                     // 阈值基准
+    ThresholdBand raise[ANOMALY_LEVEL_COUNT]; // 各等级越限带（按AnomalyLevel索引）
+    ThresholdBand clear;                    // 恢复条件：low < 取值 < high
+    uint32_t actions[ANOMALY_LEVEL_COUNT];  // 各等级动作
+    bool needs_manual_confirmation;         // 恢复是否需要人工确认
+    int32_t persistence_ms = DEFAULT_PERSISTENCE; // 确认窗口(ms)：条件持续满该时间才确认并执行动作
+    int32_t min_clear_ms = 0;               // 最短恢复时间(ms)：持续满足恢复条件满该时间才解除
+    ChannelStatistic statistic = ChannelStatistic::VALUE; // 判定对象：通道原值或其统计量
+    int32_t statistic_window_ms = 0;        // 统计窗口(ms)，statistic非VALUE时须大于0
+    bool event_driven = false;              // 由事件检测器触发与解除，不参与扫描与恢复判定
+    int32_t statistic_sample_ms = 0;        // 预期最短采样间隔(ms)，统计缓冲按窗口内样本数分配；0为监测周期
+};
+
+// 编译后的规则：阈值已换算为绝对值并按设备行存放成列，与遥测列逐行对应。
+// 阈值与设备无关的规则只存一行（行步长为0），比较时广播
+struct CompiledRule {
+    const double* low[ANOMALY_LEVEL_COUNT];  // 各等级下限列
+    const double* high[ANOMALY_LEVEL_COUNT]; // 各等级上限列
+    const double* clear_low;                 // 恢复条件下限列
+    const double* clear_high;                // 恢复条件上限列
+    const double* screen_low;                // 合并带下限（各等级下限取大）
+    const double* screen_high;               // 合并带上限（各等级上限取小）
+    uint32_t actions[ANOMALY_LEVEL_COUNT];
+    RuleId id;
+    DeviceClass device_class;
+    TelemetryChannel channel;
+    AnomalyType type;
+    bool needs_manual_confirmation;
+    int32_t persistence_ms;                 // 确认窗口(ms)，DEFAULT_PERSISTENCE见上
+    int32_t min_clear_ms;                   // 最短恢复时间(ms)
+    ChannelStatistic statistic;             // 判定对象
+    int32_t statistic_window_ms;            // 统计窗口(ms)
+    int32_t statistic_sample_ms;            // 预期最短采样间隔(ms)
+    bool event_driven;                      // 由事件检测器触发与解除
+    uint8_t level_mask;                     // 启用的等级（第i位对应AnomalyLevel i）
+    uint32_t spec_index;                    // 对应规则定义的下标
+    uint32_t rows;                          // 设备行数
+    uint32_t stride;                        // 阈值列行步长（0或1）
+};
+
+// 判定单台设备的越限等级：返回最高越限等级的下标，未越限（含NaN无数据）返回-1
+inline int classifyValue(const CompiledRule& rule, size_t row, double value) {
+    size_t r = row * rule.stride;
+    int level = -1;
+    for (int i = 0; i < static_cast<int>(ANOMALY_LEVEL_COUNT); ++i) {
+        level = (value <= rule.low[i][r] || value >= rule.high[i][r]) ? i : level;
+    }
+    return level;
+}
+
+// 判定单台设备是否满足恢复条件
+inline bool isValueCleared(const CompiledRule& rule, size_t row, double value) {
+    size_t r = row * rule.stride;
+    return value > rule.clear_low[r] && value < rule.clear_high[r];
+}
+
+// 按规则的一组限值列比较[first_row, first_row + rows)行
+inline void compareRuleBand(const CompiledRule& rule, const double* low, const double* high,
+                            const double* values, size_t first_row, size_t rows, uint64_t* masks) {
+    if (rule.stride == 0) {
+        compareBandUniform(values + first_row, low[0], high[0], rows, masks);
+    } else {
+        compareBand(values + first_row, low + first_row, high + first_row, rows, masks);
+    }
+}
+
+// 对一个64行块内的越限设备（violating位图）计算越限等级并调用on_violation(row, level)
+template <typename OnViolation>
+void classifyRuleBlock(const CompiledRule& rule, const double* values, size_t word, uint64_t violating,
+                       OnViolation& on_violation) {
+    size_t first = word * 64;
+    size_t count = std::min<size_t>(64, rule.rows - first);
+    uint64_t level_bits[ANOMALY_LEVEL_COUNT];
+    for (size_t level = 0; level < ANOMALY_LEVEL_COUNT; ++level) {
+        level_bits[level] = 0;
+        if (rule.level_mask & (1u << level)) {
+            compareRuleBand(rule, rule.low[level], rule.high[level], values, first, count, &level_bits[level]);
+        }
+    }
+    while (violating != 0) {
+        unsigned bit = lowestSetBit(violating);
+        violating &= violating - 1;
+        uint64_t flag = 1ull << bit;
+        int level = (level_bits[2] & flag) ? 2 : (level_bits[1] & flag) ? 1 : 0;
+        on_violation(first + bit, level);
+    }
+}
+
+// 扫描一条规则的整列取值：先以合并带一次筛出越限设备，只对含越限设备的64行块
+// 计算各等级位图，再对每台越限设备调用on_violation(row, level)。
+// screen须有maskWordCount(rule.rows)个字
+template <typename OnViolation>
+void scanRule(const CompiledRule& rule, const double* values, uint64_t* screen, OnViolation on_violation) {
+    compareRuleBand(rule, rule.screen_low, rule.screen_high, values, 0, rule.rows, screen);
+    size_t words = maskWordCount(rule.rows);
+    for (size_t w = 0; w < words; ++w) {
+        if (screen[w] != 0) {
+            classifyRuleBlock(rule, values, w, screen[w], on_violation);
+        }
+    }
+}
+
+// 增量扫描：只比较changed位图中有变更设备的64行块，只对其中变更且越限的设备调用on_violation。
+// 未变更的设备取值与上次扫描相同，判定结果不变，无需重复处理
+template <typename OnViolation>
+void scanRuleChanged(const CompiledRule& rule, const double* values, const uint64_t* changed,
+                     OnViolation on_violation) {
+    size_t words = maskWordCount(rule.rows);
+    for (size_t w = 0; w < words; ++w) {
+        if (changed[w] == 0) {
+            continue;
+        }
+        size_t first = w * 64;
+        uint64_t screen = 0;
+        compareRuleBand(rule, rule.screen_low, rule.screen_high, values, first,
+                        std::min<size_t>(64, rule.rows - first), &screen);
+        if ((screen &= changed[w]) != 0) {
+            classifyRuleBlock(rule, values, w, screen, on_violation);
+        }
+    }
+}
+
+// 规则引擎：规则表在初始化前登记，编译为按（设备类别, 通道）排序的连续执行计划
+class AnomalyRuleEngine {
+public:
+    AnomalyRuleEngine();
+
+    // 登记内置规则
+    void loadBuiltinRules();
+
+    // 登记规则，标识为0或重复、类别或通道无效时返回false
+    bool addRule(const AnomalyRuleSpec& spec);
+
+    // 修改规则的恢复条件与最短恢复时间（滞回），下次编译生效；规则不存在时返回false
+    bool setHysteresis(RuleId id, ThresholdBand clear, int32_t min_clear_ms);
+
+    // 按基准参数（以ThresholdBase索引）与设备集合编译执行计划
+    void compile(const double* base_values, const DeviceRegistry& registry);
+
+    // 执行计划（按设备类别、通道排序）
+    const std::vector<CompiledRule>& plan() const { return plan_; }
+
+    // 某类设备某通道上的规则区间 [first, last)
+    const CompiledRule* rulesBegin(DeviceClass device_class, TelemetryChannel channel) const;
+    const CompiledRule* rulesEnd(DeviceClass device_class, TelemetryChannel channel) const;
+
+    // 按标识查找，不存在返回nullptr
+    const CompiledRule* compiled(RuleId id) const;
+    const AnomalyRuleSpec* spec(RuleId id) const;
+
+    // 按名称查找规则标识，不存在返回0
+    RuleId findByName(const std::string& name) const;
+
+    // 规则名称，不存在返回空字符串
+    const std::string& ruleName(RuleId id) const;
+
+    size_t ruleCount() const { return specs_.size(); }
+
+    // 全部规则定义（登记顺序）
+    const std::vector<AnomalyRuleSpec>& specs() const { return specs_; }
+
+private:
+    static constexpr uint32_t NO_RULE = 0xFFFFFFFFu;
+    static constexpr size_t GROUP_COUNT = DEVICE_CLASS_COUNT * TELEMETRY_CHANNEL_COUNT;
+
+    static size_t groupOf(DeviceClass device_class, TelemetryChannel channel) {
+        return static_cast<size_t>(device_class) * TELEMETRY_CHANNEL_COUNT + static_cast<size_t>(channel);
+    }
+
+    std::vector<AnomalyRuleSpec> specs_;        // 规则定义（登记顺序）
+    std::vector<uint32_t> spec_slots_;          // 规则标识 -> 定义下标
+    std::vector<CompiledRule> plan_;            // 执行计划
+    std::vector<uint32_t> plan_slots_;          // 规则标识 -> 计划下标
+    std::vector<std::vector<double>> thresholds_; // 各计划项的阈值列存储
+    uint32_t group_offsets_[GROUP_COUNT + 1];   // （类别, 通道）分组在计划中的起始下标
+};
+
+#endif // ANOMALY_RULES_H
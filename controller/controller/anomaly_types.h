@@ -0,0 +1,80 @@
+// anomaly_types.h
+#ifndef ANOMALY_TYPES_H
+#define ANOMALY_TYPES_H
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include "device_registry.h"
+
+// 异常等级枚举
+enum class AnomalyLevel {
+    INFO,       // 提示级
+    WARNING,    // 一般级
+    CRITICAL    // 事故级
+};
+
+// 异常类型枚举
+enum class AnomalyType {
+    DEVICE_FAULT,   // 设备故障
+    GRID_FAULT,     // 电网异常
+    SAFETY_FAULT    // 安全异常
+};
+
+// 异常状态
+enum class AnomalyState : uint8_t {
+    PENDING,    // 待确认：条件已出现，持续时间未满确认窗口
+    ACTIVE      // 已确认：执行处置动作
+};
+
+// 检测规则标识
+using RuleId = uint16_t;
+
+// 异常键：高32位为规则标识，低32位为设备索引。
+// 同一规则在同一设备上只对应一个活动异常，与测量值无关
+using AnomalyKey = uint64_t;
+constexpr AnomalyKey INVALID_ANOMALY_KEY = ~0ull;
+
+inline AnomalyKey makeAnomalyKey(RuleId rule, DeviceIndex device) {
+    return (static_cast<uint64_t>(rule) << 32) | device;
+}
+inline RuleId ruleIdOf(AnomalyKey key) {
+    return static_cast<RuleId>(key >> 32);
+}
+inline DeviceIndex deviceIndexOf(AnomalyKey key) {
+    return static_cast<DeviceIndex>(key & 0xFFFFFFFFu);
+}
+
+// 异常描述所依据的数值：回调事件只携带这些数值，描述文本在投递端生成
+struct AnomalyDetail {
+    double value = 0.0;                             // 描述中的测量值
+    double forecast_s = std::numeric_limits<double>::quiet_NaN(); // 预测到达上限的时间(s)，NaN为无
+    double magnitude_pu = std::numeric_limits<double>::quiet_NaN(); // 电压事件残余/最高电压(标幺)，NaN为非电压事件
+    double duration_ms = 0.0;                       // 电压事件持续时间(ms)
+    uint32_t phase_mask = 0;                        // 电压事件涉及的相
+};
+
+// 异常信息结构体
+struct AnomalyInfo {
+    AnomalyKey key;                                 // 异常键（规则+设备）
+    RuleId rule_id;                                 // 检测规则
+    AnomalyType type;                               // 异常类型
+    AnomalyLevel level;                             // 异常等级
+    AnomalyState state;                             // 异常状态
+    uint32_t pending_timer;                         // 待确认期间的确认定时器
+    std::string device_id;                          // 设备标识
+    DeviceIndex device_index;                       // 设备索引
+    double value;                                   // 最近一次越限测量值
+    std::string description;                        // 异常描述（仅用于展示）
+    AnomalyDetail detail;                           // 描述所依据的数值
+    std::chrono::system_clock::time_point start_time; // 异常开始时间
+    std::chrono::system_clock::time_point end_time;   // 异常结束时间
+    bool is_handled;                                // 是否已处理
+    bool needs_manual_confirmation;                 // 是否需要人工确认
+    bool awaiting_confirmation;                     // 条件已消失，等待人工确认
+    bool hysteresis_hold;                           // 已离开越限带，尚未满足恢复条件（滞回保持）
+    int64_t clear_since_ms;                         // 满足恢复条件的起始时间(确认定时器时间, ms)，-1为未满足
+};
+
+#endif // ANOMALY_TYPES_H
@@ -0,0 +1,27 @@
+// bit_ops.h
+#ifndef BIT_OPS_H
+#define BIT_OPS_H
+
+#include <cstdint>
+
+// 最低置位的位置（value非0）
+inline unsigned lowestSetBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(value));
+#else
+    unsigned bit = 0;
+    while ((value & 1) == 0) {
+        value >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+// 循环右移
+inline uint64_t rotateRight(uint64_t value, unsigned shift) {
+    shift &= 63;
+    return shift == 0 ? value : (value >> shift) | (value << (64 - shift));
+}
+
+#endif // BIT_OPS_H
@@ -0,0 +1,471 @@
+// callback_dispatcher.cpp
+#include "callback_dispatcher.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+constexpr std::chrono::milliseconds IDLE_WAIT(100); // 空闲等待上限（唤醒通知的兜底）
+
+int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <typename T>
+void updateMax(std::atomic<T>& target, T value) {
+    T current = target.load(std::memory_order_relaxed);
+    while (value > current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+} // namespace
+
+CallbackDispatcher::CallbackDispatcher()
+    : safety_(SAFETY_CAPACITY),
+      control_(CONTROL_CAPACITY),
+      normal_(NORMAL_CAPACITY),
+      running_(false),
+      stopping_(false),
+      subscribers_(new SubscriberSet()),
+      publish_epoch_(0),
+      next_subscriber_id_(INVALID_SUBSCRIBER + 1),
+      retired_count_(0),
+      event_subscribed_(false) {
+    for (std::atomic<bool>& subscribed : subscribed_) {
+        subscribed.store(false, std::memory_order_relaxed);
+    }
+}
+
+CallbackDispatcher::~CallbackDispatcher() {
+    stop();
+    const SubscriberSet* set = subscribers_.load();
+    for (const std::shared_ptr<SubscriberQueue>& queue : set->queues) {
+        queue->close();
+    }
+    delete set;
+}
+
+void CallbackDispatcher::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    stopping_ = false;
+    safety_.worker = std::thread(&CallbackDispatcher::run, this, std::ref(safety_));
+    control_.worker = std::thread(&CallbackDispatcher::run, this, std::ref(control_));
+    normal_.worker = std::thread(&CallbackDispatcher::run, this, std::ref(normal_));
+}
+
+void CallbackDispatcher::stop() {
+    if (!running_.load()) {
+        return;
+    }
+    stopping_ = true;
+    for (Lane* lane : {&safety_, &control_, &normal_}) {
+        {
+            std::lock_guard<std::mutex> lock(lane->wake_mutex);
+        }
+        lane->wake_cv.notify_one();
+    }
+    safety_.worker.join();
+    control_.worker.join();
+    normal_.worker.join();
+    running_ = false;
+    control_.batches.clear(); // 停止时未到齐的批次不再投递
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    reclaim(); // 工作线程已退出，旧集合全部释放
+}
+
+void CallbackDispatcher::setFormatter(EventFormatter formatter) {
+    formatter_ = std::move(formatter);
+}
+
+// 复制当前集合，修改后以原子指针发布，旧集合记入待释放列表
+template <typename Edit>
+void CallbackDispatcher::update(Edit edit) {
+    std::unique_ptr<SubscriberSet> next(new SubscriberSet(*subscribers_.load(std::memory_order_relaxed)));
+    edit(*next);
+    subscribed_[static_cast<size_t>(CallbackKind::STATUS)].store(!next->status.empty());
+    subscribed_[static_cast<size_t>(CallbackKind::CONTROL)].store(!next->control.empty() ||
+                                                                  !next->control_batch.empty());
+    subscribed_[static_cast<size_t>(CallbackKind::SAFETY)].store(!next->safety.empty());
+    event_subscribed_.store(!next->events.empty() || !next->queues.empty());
+    const SubscriberSet* previous = subscribers_.exchange(next.release(), std::memory_order_seq_cst);
+    // 发布后代次加一：静止点看到新代次的工作线程此后只会加载新集合
+    uint64_t epoch = publish_epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+    retired_.push_back(RetiredSet{epoch, std::unique_ptr<const SubscriberSet>(previous)});
+    reclaim();
+}
+
+// 旧集合可释放的条件：每个工作线程或已下线（空闲），或在静止点看到的代次不早于该集合被替换时的代次
+void CallbackDispatcher::reclaim() {
+    uint64_t safe_epoch = READER_OFFLINE;
+    for (const Lane* lane : {&safety_, &control_, &normal_}) {
+        safe_epoch = std::min(safe_epoch, lane->reader_epoch.load(std::memory_order_seq_cst));
+    }
+    size_t kept = 0;
+    for (RetiredSet& retired : retired_) {
+        if (retired.epoch > safe_epoch) {
+            retired_[kept++] = std::move(retired);
+        }
+    }
+    retired_.resize(kept);
+    retired_count_.store(kept, std::memory_order_relaxed);
+}
+
+template <typename Callback>
+void CallbackDispatcher::replaceAll(std::vector<Subscriber<Callback>>& list, Callback& callback,
+                                    SubscriberId id) {
+    list.clear();
+    if (callback) {
+        list.push_back(Subscriber<Callback>{id, std::move(callback)});
+    }
+}
+
+CallbackDispatcher::SubscriberId CallbackDispatcher::addEventSubscriber(EventCallback callback) {
+    if (!callback) {
+        return INVALID_SUBSCRIBER;
+    }
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    SubscriberId id = next_subscriber_id_++;
+    update([&](SubscriberSet& set) { set.events.push_back({id, std::move(callback)}); });
+    return id;
+}
+
+CallbackDispatcher::SubscriberId CallbackDispatcher::addStatusSubscriber(StatusCallback callback) {
+    if (!callback) {
+        return INVALID_SUBSCRIBER;
+    }
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    SubscriberId id = next_subscriber_id_++;
+    update([&](SubscriberSet& set) { set.status.push_back({id, std::move(callback)}); });
+    return id;
+}
+
+CallbackDispatcher::SubscriberId CallbackDispatcher::addControlSubscriber(ControlCallback callback) {
+    if (!callback) {
+        return INVALID_SUBSCRIBER;
+    }
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    SubscriberId id = next_subscriber_id_++;
+    update([&](SubscriberSet& set) { set.control.push_back({id, std::move(callback)}); });
+    return id;
+}
+
+CallbackDispatcher::SubscriberId CallbackDispatcher::addSafetySubscriber(SafetyCallback callback) {
+    if (!callback) {
+        return INVALID_SUBSCRIBER;
+    }
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    SubscriberId id = next_subscriber_id_++;
+    update([&](SubscriberSet& set) { set.safety.push_back({id, std::move(callback)}); });
+    return id;
+}
+
+CallbackDispatcher::SubscriberId CallbackDispatcher::addControlBatchSubscriber(ControlBatchCallback callback) {
+    if (!callback) {
+        return INVALID_SUBSCRIBER;
+    }
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    SubscriberId id = next_subscriber_id_++;
+    update([&](SubscriberSet& set) { set.control_batch.push_back({id, std::move(callback)}); });
+    return id;
+}
+
+CallbackDispatcher::SubscriberId CallbackDispatcher::subscribe(const EventSubscription& subscription,
+                                                               EventCallback callback) {
+    if (!callback) {
+        return INVALID_SUBSCRIBER;
+    }
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    SubscriberId id = next_subscriber_id_++;
+    std::shared_ptr<SubscriberQueue> queue = SubscriberQueue::create(id, subscription, std::move(callback));
+    update([&](SubscriberSet& set) { set.queues.push_back(std::move(queue)); });
+    return id;
+}
+
+bool CallbackDispatcher::removeSubscriber(SubscriberId id) {
+    auto matches = [id](const auto& subscriber) { return subscriber.id == id; };
+    auto matches_queue = [id](const std::shared_ptr<SubscriberQueue>& queue) { return queue->id() == id; };
+    std::shared_ptr<SubscriberQueue> removed_queue;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        const SubscriberSet& current = *subscribers_.load(std::memory_order_relaxed);
+        auto queue = std::find_if(current.queues.begin(), current.queues.end(), matches_queue);
+        if (queue != current.queues.end()) {
+            removed_queue = *queue;
+        } else if (std::none_of(current.events.begin(), current.events.end(), matches) &&
+                   std::none_of(current.status.begin(), current.status.end(), matches) &&
+                   std::none_of(current.control.begin(), current.control.end(), matches) &&
+                   std::none_of(current.safety.begin(), current.safety.end(), matches) &&
+                   std::none_of(current.control_batch.begin(), current.control_batch.end(), matches)) {
+            return false;
+        }
+        update([&](SubscriberSet& set) {
+            set.events.erase(std::remove_if(set.events.begin(), set.events.end(), matches), set.events.end());
+            set.status.erase(std::remove_if(set.status.begin(), set.status.end(), matches), set.status.end());
+            set.control.erase(std::remove_if(set.control.begin(), set.control.end(), matches), set.control.end());
+            set.safety.erase(std::remove_if(set.safety.begin(), set.safety.end(), matches), set.safety.end());
+            set.control_batch.erase(std::remove_if(set.control_batch.begin(), set.control_batch.end(), matches),
+                                    set.control_batch.end());
+            set.queues.erase(std::remove_if(set.queues.begin(), set.queues.end(), matches_queue), set.queues.end());
+        });
+    }
+    if (removed_queue) {
+        removed_queue->close(); // 在注册锁之外等待投递线程：其回调可能再注册
+    }
+    return true;
+}
+
+void CallbackDispatcher::setEventCallback(EventCallback callback) {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    SubscriberId id = next_subscriber_id_++;
+    update([&](SubscriberSet& set) { replaceAll(set.events, callback, id); });
+}
+
+void CallbackDispatcher::setStatusCallback(StatusCallback callback) {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    SubscriberId id = next_subscriber_id_++;
+    update([&](SubscriberSet& set) { replaceAll(set.status, callback, id); });
+}
+
+void CallbackDispatcher::setControlCallback(ControlCallback callback) {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    SubscriberId id = next_subscriber_id_++;
+    update([&](SubscriberSet& set) { replaceAll(set.control, callback, id); });
+}
+
+void CallbackDispatcher::setSafetyCallback(SafetyCallback callback) {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    SubscriberId id = next_subscriber_id_++;
+    update([&](SubscriberSet& set) { replaceAll(set.safety, callback, id); });
+}
+
+void CallbackDispatcher::setControlBatchCallback(ControlBatchCallback callback) {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    SubscriberId id = next_subscriber_id_++;
+    update([&](SubscriberSet& set) { replaceAll(set.control_batch, callback, id); });
+}
+
+void CallbackDispatcher::post(ControllerEvent& event) {
+    switch (callbackKindOf(event.kind)) {
+        case CallbackKind::SAFETY:
+            enqueue(safety_, event, true);
+            break;
+        case CallbackKind::CONTROL:
+            enqueue(control_, event, true);
+            break;
+        case CallbackKind::STATUS:
+            enqueue(normal_, event, false);
+            break;
+    }
+}
+
+// 入队后若工作线程正在等待则唤醒：
+// 入队与检查sleeping、工作线程设置sleeping与检查队列之间各有一道全序栅栏，二者至少一方能看到对方
+void CallbackDispatcher::enqueue(Lane& lane, ControllerEvent& event, bool wait_when_full) {
+    event.enqueue_ns = steadyNowNs();
+    bool waited = false;
+    while (!lane.queue.tryPush(event)) {
+        if (!wait_when_full || !running_.load(std::memory_order_acquire) ||
+            stopping_.load(std::memory_order_acquire)) {
+            lane.dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (!waited) {
+            waited = true;
+            lane.blocked.fetch_add(1, std::memory_order_relaxed);
+        }
+        std::this_thread::yield(); // 安全与控制通道不丢弃：等待工作线程腾出位置
+    }
+    lane.accepted.fetch_add(1, std::memory_order_relaxed);
+    updateMax<uint64_t>(lane.max_depth, lane.queue.size());
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (lane.sleeping.load(std::memory_order_relaxed)) {
+        {
+            std::lock_guard<std::mutex> lock(lane.wake_mutex);
+        }
+        lane.wake_cv.notify_one();
+    }
+}
+
+// 工作线程在每次投递后经过静止点，空闲等待前下线，唤醒后重新上线
+void CallbackDispatcher::run(Lane& lane) {
+    ControllerEvent event{};
+    std::string text; // 复用的文本缓冲
+    lane.reader_epoch.store(publish_epoch_.load(), std::memory_order_seq_cst); // 上线
+    for (;;) {
+        if (lane.queue.tryPop(event)) {
+            int64_t latency_us = (steadyNowNs() - event.enqueue_ns) / 1000;
+            lane.last_latency_us.store(latency_us, std::memory_order_relaxed);
+            lane.total_latency_us.fetch_add(latency_us, std::memory_order_relaxed);
+            updateMax<int64_t>(lane.max_latency_us, latency_us);
+            deliver(lane, event, text);
+            quiesce(lane);
+            lane.delivered.fetch_add(1, std::memory_order_release);
+            continue;
+        }
+        lane.reader_epoch.store(READER_OFFLINE, std::memory_order_seq_cst); // 下线
+        if (retired_count_.load(std::memory_order_relaxed) != 0) {
+            std::lock_guard<std::mutex> lock(registry_mutex_);
+            reclaim(); // 注册者释放不了的旧集合由空闲的工作线程释放
+        }
+        {
+            std::unique_lock<std::mutex> lock(lane.wake_mutex);
+            lane.idle_cv.notify_all();
+            if (stopping_.load(std::memory_order_acquire)) {
+                if (lane.queue.size() == 0) {
+                    break; // 已入队的回调全部投递
+                }
+                // 有生产者已领取位置尚未发布
+            } else {
+                lane.sleeping.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!lane.queue.readable() && !stopping_.load(std::memory_order_acquire)) {
+                    lane.wake_cv.wait_for(lock, IDLE_WAIT);
+                }
+                lane.sleeping.store(false, std::memory_order_relaxed);
+            }
+        }
+        lane.reader_epoch.store(publish_epoch_.load(), std::memory_order_seq_cst); // 上线
+    }
+}
+
+void CallbackDispatcher::quiesce(Lane& lane) {
+    lane.reader_epoch.store(publish_epoch_.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+// 每次投递只加载一次订阅者集合
+void CallbackDispatcher::deliver(Lane& lane, const ControllerEvent& event, std::string& text) {
+    const SubscriberSet& set = *subscribers_.load(std::memory_order_acquire);
+    CallbackKind kind = callbackKindOf(event.kind);
+    for (const Subscriber<EventCallback>& subscriber : set.events) {
+        subscriber.callback(event);
+    }
+    for (const std::shared_ptr<SubscriberQueue>& queue : set.queues) {
+        if (queue->matches(event)) {
+            queue->push(event, kind == CallbackKind::STATUS); // 安全与控制通道从不等待订阅者
+        }
+    }
+    bool has_text_subscriber = kind == CallbackKind::STATUS ? !set.status.empty() :
+        kind == CallbackKind::CONTROL ? !set.control.empty() : !set.safety.empty();
+    // 成批的设定总是汇集（批量订阅者可能在批次中途注册），单条设定仅在有批量订阅者时生成
+    bool collect = kind == CallbackKind::CONTROL && (event.batch_size > 1 || !set.control_batch.empty());
+    if ((!has_text_subscriber && !collect) || !formatter_) {
+        return; // 无字符串订阅者：不生成文本
+    }
+    text.clear();
+    formatter_(event, text);
+    if (collect) {
+        collectSetpoint(lane, set, event, text);
+    }
+    switch (kind) {
+        case CallbackKind::STATUS:
+            for (const Subscriber<StatusCallback>& subscriber : set.status) {
+                subscriber.callback(text);
+            }
+            break;
+        case CallbackKind::CONTROL:
+            for (const Subscriber<ControlCallback>& subscriber : set.control) {
+                subscriber.callback(text, event.power_kw);
+            }
+            break;
+        case CallbackKind::SAFETY:
+            for (const Subscriber<SafetyCallback>& subscriber : set.safety) {
+                subscriber.callback(text);
+            }
+            break;
+    }
+}
+
+// 同一批次的设定由一个线程连续入队，但可能与其他线程的批次交错，按批次号分别汇集。
+// 未到齐的批次按开始顺序排列，超出上限时丢弃最早的
+void CallbackDispatcher::collectSetpoint(Lane& lane, const SubscriberSet& set, const ControllerEvent& event,
+                                         const std::string& target) {
+    std::vector<PendingBatch>& batches = lane.batches;
+    auto pending = batches.end();
+    if (event.batch != 0) {
+        pending = std::find_if(batches.begin(), batches.end(), [&event](const PendingBatch& batch) {
+            return batch.expected != 0 && batch.batch == event.batch;
+        });
+    }
+    if (pending == batches.end()) {
+        pending = std::find_if(batches.begin(), batches.end(),
+                               [](const PendingBatch& batch) { return batch.expected == 0; });
+        if (pending == batches.end()) {
+            if (batches.size() < MAX_PENDING_BATCHES) {
+                batches.emplace_back();
+                pending = batches.end() - 1;
+            } else {
+                pending = batches.begin(); // 丢弃最早的未完成批次
+                pending->commands.clear();
+            }
+        }
+        std::rotate(pending, pending + 1, batches.end()); // 移到末尾：新开始的批次
+        pending = batches.end() - 1;
+        pending->batch = event.batch;
+        pending->expected = std::max<uint32_t>(1, event.batch_size);
+    }
+    pending->commands.push_back(
+        ControlCommand{target, event.power_kw, event.device, event.key, event.type, event.level});
+    if (pending->commands.size() < pending->expected) {
+        return;
+    }
+    for (const Subscriber<ControlBatchCallback>& subscriber : set.control_batch) {
+        subscriber.callback(pending->commands);
+    }
+    pending->commands.clear();
+    pending->expected = 0;
+}
+
+void CallbackDispatcher::flush() {
+    if (!running_.load(std::memory_order_acquire)) {
+        return;
+    }
+    for (Lane* lane : {&safety_, &control_, &normal_}) {
+        uint64_t target = lane->accepted.load(std::memory_order_relaxed);
+        std::unique_lock<std::mutex> lock(lane->wake_mutex);
+        while (lane->delivered.load(std::memory_order_acquire) < target && !stopping_.load()) {
+            lane->idle_cv.wait_for(lock, IDLE_WAIT);
+        }
+    }
+    std::vector<std::shared_ptr<SubscriberQueue>> queues;
+    {
+        std::lock_guard<std::mutex> lock(registry_mutex_);
+        queues = subscribers_.load(std::memory_order_relaxed)->queues;
+    }
+    for (const std::shared_ptr<SubscriberQueue>& queue : queues) {
+        queue->flush();
+    }
+}
+
+DispatchLaneMetrics CallbackDispatcher::laneMetrics(const Lane& lane) {
+    DispatchLaneMetrics metrics;
+    metrics.delivered = lane.delivered.load(std::memory_order_relaxed);
+    metrics.dropped = lane.dropped.load(std::memory_order_relaxed);
+    metrics.blocked = lane.blocked.load(std::memory_order_relaxed);
+    metrics.queue_depth = lane.queue.size();
+    metrics.max_queue_depth = lane.max_depth.load(std::memory_order_relaxed);
+    metrics.last_latency_us = lane.last_latency_us.load(std::memory_order_relaxed);
+    metrics.max_latency_us = lane.max_latency_us.load(std::memory_order_relaxed);
+    metrics.mean_latency_us = metrics.delivered == 0 ? 0 :
+        lane.total_latency_us.load(std::memory_order_relaxed) / static_cast<int64_t>(metrics.delivered);
+    return metrics;
+}
+
+DispatchMetrics CallbackDispatcher::metrics() const {
+    DispatchMetrics metrics;
+    metrics.safety = laneMetrics(safety_);
+    metrics.control = laneMetrics(control_);
+    metrics.normal = laneMetrics(normal_);
+    return metrics;
+}
+
+std::vector<SubscriberMetrics> CallbackDispatcher::subscriberMetrics() const {
+    std::vector<SubscriberMetrics> metrics;
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    for (const std::shared_ptr<SubscriberQueue>& queue : subscribers_.load(std::memory_order_relaxed)->queues) {
+        metrics.push_back(queue->metrics());
+    }
+    return metrics;
+}
@@ -0,0 +1,210 @@
+// callback_dispatcher.h
+#ifndef CALLBACK_DISPATCHER_H
+#define CALLBACK_DISPATCHER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "controller_event.h"
+#include "event_bus.h"
+#include "mpsc_queue.h"
+
+// 批量控制接口中的一条功率设定
+struct ControlCommand {
+    std::string target;         // 控制目标
+    double power_kw;            // 设定功率(kW)
+    DeviceIndex device;         // 触发设定的设备
+    AnomalyKey key;             // 触发设定的异常
+    AnomalyType type;
+    AnomalyLevel level;
+};
+
+// 单个通道的投递指标
+struct DispatchLaneMetrics {
+    uint64_t delivered;         // 已投递数
+    uint64_t dropped;           // 队列满而丢弃数（安全与控制通道仅在分发器未运行时丢弃）
+    uint64_t blocked;           // 队列满而等待的入队次数（仅安全与控制通道）
+    uint64_t queue_depth;       // 当前排队数
+    uint64_t max_queue_depth;   // 最大排队数
+    int64_t last_latency_us;    // 最近一次投递时延(us)：入队 -> 回调开始
+    int64_t max_latency_us;     // 最大投递时延(us)
+    int64_t mean_latency_us;    // 平均投递时延(us)
+};
+
+struct DispatchMetrics {
+    DispatchLaneMetrics safety;     // 安全通道（安全操作）
+    DispatchLaneMetrics control;    // 控制通道（功率设定）
+    DispatchLaneMetrics normal;     // 普通通道（状态通知）
+};
+
+// 异步回调分发器：检测路径只把定长事件记录入队（有界无锁MPSC队列，不加锁、不分配内存、不等待订阅者），
+// 由工作线程在异常数据锁之外调用订阅者。分三条通道，各有一个工作线程，通道内保持入队顺序：
+// 安全通道承载安全操作，控制通道承载功率设定与爬坡设定值，二者队列满时入队方等待而不丢弃
+// （入队方不得持有异常数据锁）；普通通道承载状态通知，队列满时丢弃并计数。
+// 成批的功率设定与慢速的状态订阅者都不会延迟安全操作。
+// 事件订阅者直接收到事件记录；字符串订阅者收到的文本由格式化函数在工作线程中生成，无字符串订阅者时不生成。
+// 带过滤条件的订阅者各有一个有界队列与投递线程，分发线程只把匹配的事件放入其队列。
+// 订阅者集合按RCU方式发布：集合不可变，注册/注销时复制出新集合并以原子指针替换，
+// 工作线程每次投递只做一次原子加载、不加锁；被替换的集合在全部工作线程都越过静止点后释放
+class CallbackDispatcher {
+public:
+    using EventCallback = std::function<void(const ControllerEvent& event)>;
+    using StatusCallback = std::function<void(const std::string& status)>;
+    using ControlCallback = std::function<void(const std::string& device, double power)>;
+    using SafetyCallback = std::function<void(const std::string& action)>;
+    // 批量控制：每个周期合并后的全部功率设定一次调用（同一控制目标只有一条）
+    using ControlBatchCallback = std::function<void(const std::vector<ControlCommand>& batch)>;
+    // 生成字符串订阅者收到的文本：状态文本、控制目标或安全操作
+    using EventFormatter = std::function<void(const ControllerEvent& event, std::string& text)>;
+    // 订阅者标识（全局唯一，0为无效）
+    using SubscriberId = uint64_t;
+    static constexpr SubscriberId INVALID_SUBSCRIBER = 0;
+
+    static constexpr size_t SAFETY_CAPACITY = 1024;
+    static constexpr size_t CONTROL_CAPACITY = 4096;
+    static constexpr size_t NORMAL_CAPACITY = 16384;
+
+    CallbackDispatcher();
+    ~CallbackDispatcher();
+    CallbackDispatcher(const CallbackDispatcher&) = delete;
+    CallbackDispatcher& operator=(const CallbackDispatcher&) = delete;
+
+    // 启动工作线程（启动前入队的回调在启动后投递）
+    void start();
+    // 投递完已入队的回调后停止工作线程
+    void stop();
+
+    // 设置文本格式化函数（start()之前）
+    void setFormatter(EventFormatter formatter);
+
+    // 增加订阅者（线程安全，运行中生效，同类可有多个，按注册顺序调用），回调为空时返回INVALID_SUBSCRIBER。
+    // 事件订阅者由各通道的工作线程调用，不同通道的事件可能并发到达
+    SubscriberId addEventSubscriber(EventCallback callback);
+    SubscriberId addStatusSubscriber(StatusCallback callback);
+    SubscriberId addControlSubscriber(ControlCallback callback);
+    SubscriberId addSafetySubscriber(SafetyCallback callback);
+    SubscriberId addControlBatchSubscriber(ControlBatchCallback callback);
+
+    // 按过滤条件订阅，事件经订阅者自己的有界队列与投递线程投递，队列满时按订阅的策略处理。
+    // 普通通道（状态事件）可因BLOCK策略等待；功率设定与安全操作事件从不等待，不会被慢速订阅者延迟
+    SubscriberId subscribe(const EventSubscription& subscription, EventCallback callback);
+
+    // 注销订阅者，不存在时返回false。返回时正在进行的一次调用可能尚未结束，
+    // 需要确认不再被调用时随后调用flush()
+    bool removeSubscriber(SubscriberId id);
+
+    // 以单个订阅者替换该类全部订阅者（回调为空时清空），替换是原子的，不会漏投或重复投递
+    void setEventCallback(EventCallback callback);
+    void setStatusCallback(StatusCallback callback);
+    void setControlCallback(ControlCallback callback);
+    void setSafetyCallback(SafetyCallback callback);
+    void setControlBatchCallback(ControlBatchCallback callback);
+
+    // 是否有该类事件的订阅者：入队方据此跳过无人接收的事件
+    bool hasSubscriber(CallbackKind kind) const {
+        return event_subscribed_.load(std::memory_order_acquire) ||
+               subscribed_[static_cast<size_t>(kind)].load(std::memory_order_acquire);
+    }
+
+    // 入队（按事件类别选择通道），可多线程并发调用；安全与控制通道满时等待，调用方不得持有异常数据锁
+    void post(ControllerEvent& event);
+
+    // 等待此前入队的回调全部投递完成，含订阅者队列中的（工作线程未启动时立即返回），不可在回调中调用
+    void flush();
+
+    DispatchMetrics metrics() const;
+    std::vector<SubscriberMetrics> subscriberMetrics() const; // 按过滤条件订阅者的投递指标
+
+private:
+    // 正在汇集的设定批次：同一批次的SETPOINT事件到齐后一次投递给批量控制订阅者
+    struct PendingBatch {
+        uint64_t batch = 0;
+        uint32_t expected = 0;                  // 0为空闲
+        std::vector<ControlCommand> commands;   // 复用容量
+    };
+    static constexpr size_t MAX_PENDING_BATCHES = 8; // 超出时丢弃最早的未完成批次（停止期间的残缺批次）
+
+    struct Lane {
+        explicit Lane(size_t capacity) : queue(capacity) {}
+        MpscQueue<ControllerEvent> queue;
+        std::thread worker;
+        std::atomic<uint64_t> reader_epoch{READER_OFFLINE}; // 最近一次静止点看到的发布代次
+        std::vector<PendingBatch> batches;      // 正在汇集的设定批次（仅本通道工作线程）
+        std::atomic<bool> sleeping{false};      // 工作线程即将或正在等待
+        std::mutex wake_mutex;
+        std::condition_variable wake_cv;        // 新回调入队
+        std::condition_variable idle_cv;        // 队列已空
+        std::atomic<uint64_t> accepted{0};
+        std::atomic<uint64_t> delivered{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> blocked{0};
+        std::atomic<uint64_t> max_depth{0};
+        std::atomic<int64_t> last_latency_us{0};
+        std::atomic<int64_t> max_latency_us{0};
+        std::atomic<int64_t> total_latency_us{0};
+    };
+
+    template <typename Callback>
+    struct Subscriber {
+        SubscriberId id;
+        Callback callback;
+    };
+
+    // 不可变的订阅者集合，发布后只读
+    struct SubscriberSet {
+        std::vector<Subscriber<EventCallback>> events;
+        std::vector<Subscriber<StatusCallback>> status;
+        std::vector<Subscriber<ControlCallback>> control;
+        std::vector<Subscriber<SafetyCallback>> safety;
+        std::vector<Subscriber<ControlBatchCallback>> control_batch;
+        std::vector<std::shared_ptr<SubscriberQueue>> queues;
+    };
+
+    // 被替换的集合及其替换时的发布代次
+    struct RetiredSet {
+        uint64_t epoch;
+        std::unique_ptr<const SubscriberSet> set;
+    };
+
+    static constexpr uint64_t READER_OFFLINE = ~0ull; // 工作线程空闲，不持有订阅者集合
+
+    template <typename Callback>
+    static void replaceAll(std::vector<Subscriber<Callback>>& list, Callback& callback, SubscriberId id);
+    template <typename Edit>
+    void update(Edit edit);                             // 复制当前集合、修改后发布（持有registry_mutex_）
+    void reclaim();                                     // 释放所有工作线程都已越过的旧集合（持有registry_mutex_）
+    void quiesce(Lane& lane);                           // 静止点：不再持有此前加载的集合
+
+    void enqueue(Lane& lane, ControllerEvent& event, bool wait_when_full);
+    void run(Lane& lane);
+    void deliver(Lane& lane, const ControllerEvent& event, std::string& text);
+    void collectSetpoint(Lane& lane, const SubscriberSet& set, const ControllerEvent& event,
+                         const std::string& target); // 汇集设定批次，到齐后投递给批量控制订阅者
+    static DispatchLaneMetrics laneMetrics(const Lane& lane);
+
+    Lane safety_;
+    Lane control_;
+    Lane normal_;
+    std::atomic<bool> running_;
+    std::atomic<bool> stopping_;
+
+    EventFormatter formatter_;
+
+    std::atomic<const SubscriberSet*> subscribers_;     // 当前发布的订阅者集合
+    std::atomic<uint64_t> publish_epoch_;               // 发布代次，每次替换集合后加一
+    mutable std::mutex registry_mutex_;                 // 串行化注册者，保护以下成员
+    SubscriberId next_subscriber_id_;
+    std::vector<RetiredSet> retired_;
+    std::atomic<size_t> retired_count_;
+    std::atomic<bool> subscribed_[3];                   // 入队方判断用，随集合一起更新
+    std::atomic<bool> event_subscribed_;
+};
+
+#endif // CALLBACK_DISPATCHER_H
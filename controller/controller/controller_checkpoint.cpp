@@ -0,0 +1,382 @@
+// controller_checkpoint.cpp
+#include "controller_checkpoint.h"
+#include <cstring>
+#include <fstream>
+#include "file_io.h"
+#include "timing_wheel.h"
+
+namespace {
+
+// 文件格式：
+//   文件头（24字节）：magic(4) version(2) flags(2) created_us(8) payload_bytes(4) crc(4)
+//   payload：设备指纹、控制参数、预测时域、规则滞回、活动异常、恢复爬坡，依次顺序存放；
+//   数组以u32个数开头，字符串以u32长度开头。crc为payload的CRC-32C
+constexpr uint32_t MAGIC = 0x50434D41;          // "AMCP"
+constexpr uint16_t VERSION = 1;
+constexpr size_t HEADER_SIZE = 24;
+constexpr uint16_t FLAG_CLEAN_SHUTDOWN = 1u << 0;
+
+enum AnomalyFlag : uint8_t {
+    FLAG_HANDLED = 1u << 0,
+    FLAG_NEEDS_CONFIRMATION = 1u << 1,
+    FLAG_AWAITING_CONFIRMATION = 1u << 2,
+    FLAG_HYSTERESIS_HOLD = 1u << 3
+};
+
+int64_t toMicros(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+}
+
+std::chrono::system_clock::time_point fromMicros(int64_t us) {
+    return std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::microseconds(us)));
+}
+
+// 顺序写入
+class Writer {
+public:
+    explicit Writer(std::vector<char>& out) : out_(out) {}
+
+    template <typename T>
+    void put(T value) {
+        size_t offset = out_.size();
+        out_.resize(offset + sizeof(T));
+        std::memcpy(out_.data() + offset, &value, sizeof(T));
+    }
+
+    void putString(const std::string& text) {
+        put<uint32_t>(static_cast<uint32_t>(text.size()));
+        out_.insert(out_.end(), text.begin(), text.end());
+    }
+
+private:
+    std::vector<char>& out_;
+};
+
+// 顺序读取：越界后所有读取返回0，由ok()统一判断
+class Reader {
+public:
+    Reader(const char* data, size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    T get() {
+        T value{};
+        if (size_ - offset_ < sizeof(T)) {
+            offset_ = size_;
+            ok_ = false;
+            return value;
+        }
+        std::memcpy(&value, data_ + offset_, sizeof(T));
+        offset_ += sizeof(T);
+        return value;
+    }
+
+    std::string getString() {
+        uint32_t length = get<uint32_t>();
+        if (size_ - offset_ < length) {
+            offset_ = size_;
+            ok_ = false;
+            return std::string();
+        }
+        std::string text(data_ + offset_, length);
+        offset_ += length;
+        return text;
+    }
+
+    // 数组个数：每个元素至少min_bytes字节，超出剩余长度即为损坏
+    uint32_t getCount(size_t min_bytes) {
+        uint32_t count = get<uint32_t>();
+        if (count > (size_ - offset_) / min_bytes) {
+            ok_ = false;
+            return 0;
+        }
+        return count;
+    }
+
+    bool ok() const { return ok_ && offset_ == size_; }
+
+private:
+    const char* data_;
+    size_t size_;
+    size_t offset_ = 0;
+    bool ok_ = true;
+};
+
+} // namespace
+
+uint64_t deviceFingerprint(const DeviceRegistry& registry) {
+    uint64_t hash = 14695981039346656037ull; // FNV-1a
+    auto mix = [&hash](const char* data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ static_cast<uint8_t>(data[i])) * 1099511628211ull;
+        }
+    };
+    for (size_t c = 0; c < DEVICE_CLASS_COUNT; ++c) {
+        DeviceClass device_class = static_cast<DeviceClass>(c);
+        for (size_t i = 0; i < registry.deviceCount(device_class); ++i) {
+            const std::string& name = registry.info(makeDeviceIndex(device_class, static_cast<uint32_t>(i))).name;
+            char tag = static_cast<char>(c);
+            mix(&tag, 1);
+            mix(name.c_str(), name.size() + 1);
+        }
+    }
+    return hash;
+}
+
+void encodeCheckpoint(const ControllerCheckpoint& checkpoint, std::vector<char>& out) {
+    out.assign(HEADER_SIZE, 0);
+    Writer writer(out);
+    writer.put<uint64_t>(checkpoint.device_fingerprint);
+    writer.put<double>(checkpoint.normal_voltage);
+    writer.put<double>(checkpoint.normal_frequency);
+    writer.put<double>(checkpoint.max_hydrogen_concentration);
+    writer.put<double>(checkpoint.max_hydrogen_pressure);
+    writer.put<int32_t>(checkpoint.anomaly_duration_threshold_ms);
+    writer.put<double>(checkpoint.recovery_rate_percent_per_minute);
+    writer.put<uint32_t>(static_cast<uint32_t>(TELEMETRY_CHANNEL_COUNT));
+    for (int32_t horizon : checkpoint.forecast_horizon_ms) {
+        writer.put<int32_t>(horizon);
+    }
+    writer.put<uint32_t>(static_cast<uint32_t>(checkpoint.hysteresis.size()));
+    for (const CheckpointHysteresis& item : checkpoint.hysteresis) {
+        writer.put<uint16_t>(item.rule);
+        writer.put<double>(item.clear.low);
+        writer.put<double>(item.clear.high);
+        writer.put<int32_t>(item.min_clear_ms);
+    }
+    writer.put<uint32_t>(static_cast<uint32_t>(checkpoint.anomalies.size()));
+    for (const CheckpointAnomaly& item : checkpoint.anomalies) {
+        const AnomalyInfo& anomaly = item.info;
+        writer.put<uint64_t>(anomaly.key);
+        writer.put<uint16_t>(anomaly.rule_id);
+        writer.put<uint8_t>(static_cast<uint8_t>(anomaly.type));
+        writer.put<uint8_t>(static_cast<uint8_t>(anomaly.level));
+        writer.put<uint8_t>(static_cast<uint8_t>(anomaly.state));
+        writer.put<uint8_t>(static_cast<uint8_t>((anomaly.is_handled ? FLAG_HANDLED : 0) |
+                                                 (anomaly.needs_manual_confirmation ? FLAG_NEEDS_CONFIRMATION : 0) |
+                                                 (anomaly.awaiting_confirmation ? FLAG_AWAITING_CONFIRMATION : 0) |
+                                                 (anomaly.hysteresis_hold ? FLAG_HYSTERESIS_HOLD : 0)));
+        writer.put<uint32_t>(anomaly.device_index);
+        writer.put<double>(anomaly.value);
+        writer.put<int64_t>(toMicros(anomaly.start_time));
+        writer.put<int64_t>(toMicros(anomaly.end_time));
+        writer.put<int64_t>(item.confirm_remaining_ms);
+        writer.put<int64_t>(item.clear_elapsed_ms);
+        writer.putString(anomaly.device_id);
+        writer.putString(anomaly.description);
+    }
+    writer.put<uint32_t>(static_cast<uint32_t>(checkpoint.ramps.size()));
+    for (const RampState& ramp : checkpoint.ramps) {
+        writer.put<uint32_t>(ramp.device);
+        writer.put<uint64_t>(ramp.tag);
+        writer.put<double>(ramp.current_kw);
+        writer.put<double>(ramp.target_kw);
+        writer.put<double>(ramp.step_kw);
+        writer.put<int64_t>(ramp.step_interval.count());
+    }
+
+    uint32_t payload_bytes = static_cast<uint32_t>(out.size() - HEADER_SIZE);
+    uint16_t flags = checkpoint.clean_shutdown ? FLAG_CLEAN_SHUTDOWN : 0;
+    int64_t created_us = toMicros(checkpoint.created);
+    uint32_t crc = crc32c(out.data() + HEADER_SIZE, payload_bytes);
+    std::memcpy(out.data(), &MAGIC, 4);
+    std::memcpy(out.data() + 4, &VERSION, 2);
+    std::memcpy(out.data() + 6, &flags, 2);
+    std::memcpy(out.data() + 8, &created_us, 8);
+    std::memcpy(out.data() + 16, &payload_bytes, 4);
+    std::memcpy(out.data() + 20, &crc, 4);
+}
+
+bool decodeCheckpoint(const char* data, size_t size, ControllerCheckpoint& checkpoint) {
+    if (size < HEADER_SIZE) {
+        return false;
+    }
+    Reader header(data, HEADER_SIZE);
+    uint32_t magic = header.get<uint32_t>();
+    uint16_t version = header.get<uint16_t>();
+    uint16_t flags = header.get<uint16_t>();
+    int64_t created_us = header.get<int64_t>();
+    uint32_t payload_bytes = header.get<uint32_t>();
+    uint32_t crc = header.get<uint32_t>();
+    if (magic != MAGIC || version != VERSION || payload_bytes != size - HEADER_SIZE ||
+        crc32c(data + HEADER_SIZE, payload_bytes) != crc) {
+        return false;
+    }
+
+    ControllerCheckpoint result;
+    result.created = fromMicros(created_us);
+    result.clean_shutdown = (flags & FLAG_CLEAN_SHUTDOWN) != 0;
+    Reader reader(data + HEADER_SIZE, payload_bytes);
+    result.device_fingerprint = reader.get<uint64_t>();
+    result.normal_voltage = reader.get<double>();
+    result.normal_frequency = reader.get<double>();
+    result.max_hydrogen_concentration = reader.get<double>();
+    result.max_hydrogen_pressure = reader.get<double>();
+    result.anomaly_duration_threshold_ms = reader.get<int32_t>();
+    result.recovery_rate_percent_per_minute = reader.get<double>();
+    uint32_t channels = reader.getCount(sizeof(int32_t));
+    for (uint32_t i = 0; i < channels; ++i) {
+        int32_t horizon = reader.get<int32_t>();
+        if (i < TELEMETRY_CHANNEL_COUNT) {
+            result.forecast_horizon_ms[i] = horizon; // 版本间新增的通道取默认值
+        }
+    }
+    if (channels < TELEMETRY_CHANNEL_COUNT) {
+        std::fill(result.forecast_horizon_ms + channels, result.forecast_horizon_ms + TELEMETRY_CHANNEL_COUNT, -1);
+    }
+    uint32_t hysteresis = reader.getCount(22);
+    result.hysteresis.resize(hysteresis);
+    for (CheckpointHysteresis& item : result.hysteresis) {
+        item.rule = reader.get<uint16_t>();
+        item.clear.low = reader.get<double>();
+        item.clear.high = reader.get<double>();
+        item.min_clear_ms = reader.get<int32_t>();
+    }
+    uint32_t anomalies = reader.getCount(66);
+    result.anomalies.resize(anomalies);
+    for (CheckpointAnomaly& item : result.anomalies) {
+        AnomalyInfo& anomaly = item.info;
+        anomaly.key = reader.get<uint64_t>();
+        anomaly.rule_id = reader.get<uint16_t>();
+        anomaly.type = static_cast<AnomalyType>(reader.get<uint8_t>());
+        anomaly.level = static_cast<AnomalyLevel>(reader.get<uint8_t>());
+        anomaly.state = static_cast<AnomalyState>(reader.get<uint8_t>());
+        uint8_t anomaly_flags = reader.get<uint8_t>();
+        anomaly.is_handled = (anomaly_flags & FLAG_HANDLED) != 0;
+        anomaly.needs_manual_confirmation = (anomaly_flags & FLAG_NEEDS_CONFIRMATION) != 0;
+        anomaly.awaiting_confirmation = (anomaly_flags & FLAG_AWAITING_CONFIRMATION) != 0;
+        anomaly.hysteresis_hold = (anomaly_flags & FLAG_HYSTERESIS_HOLD) != 0;
+        anomaly.device_index = reader.get<uint32_t>();
+        anomaly.value = reader.get<double>();
+        anomaly.start_time = fromMicros(reader.get<int64_t>());
+        anomaly.end_time = fromMicros(reader.get<int64_t>());
+        item.confirm_remaining_ms = reader.get<int64_t>();
+        item.clear_elapsed_ms = reader.get<int64_t>();
+        anomaly.device_id = reader.getString();
+        anomaly.description = reader.getString();
+        anomaly.pending_timer = TimingWheel::INVALID_TIMER;
+        anomaly.clear_since_ms = -1;
+    }
+    uint32_t ramps = reader.getCount(44);
+    result.ramps.resize(ramps);
+    for (RampState& ramp : result.ramps) {
+        ramp.device = reader.get<uint32_t>();
+        ramp.tag = reader.get<uint64_t>();
+        ramp.current_kw = reader.get<double>();
+        ramp.target_kw = reader.get<double>();
+        ramp.step_kw = reader.get<double>();
+        ramp.step_interval = std::chrono::milliseconds(reader.get<int64_t>());
+    }
+    if (!reader.ok()) {
+        return false;
+    }
+    checkpoint = std::move(result);
+    return true;
+}
+
+CheckpointStore::~CheckpointStore() {
+    close();
+}
+
+void CheckpointStore::open(const std::string& path) {
+    close();
+    path_ = path;
+    stopping_ = false;
+    writer_ = std::thread(&CheckpointStore::writerLoop, this);
+}
+
+void CheckpointStore::close() {
+    if (!writer_.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_one();
+    writer_.join();
+}
+
+bool CheckpointStore::load(ControllerCheckpoint& checkpoint) const {
+    std::ifstream file(path_, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    std::streamoff size = file.tellg();
+    if (size <= 0) {
+        return false;
+    }
+    std::vector<char> bytes(static_cast<size_t>(size));
+    file.seekg(0);
+    if (!file.read(bytes.data(), size)) {
+        return false;
+    }
+    return decodeCheckpoint(bytes.data(), bytes.size(), checkpoint);
+}
+
+void CheckpointStore::saveAsync(const ControllerCheckpoint& checkpoint) {
+    std::vector<char> bytes;
+    encodeCheckpoint(checkpoint, bytes);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.swap(bytes);
+        pending_generation_ = ++generation_;
+        has_pending_ = true;
+    }
+    cv_.notify_one();
+}
+
+bool CheckpointStore::save(const ControllerCheckpoint& checkpoint) {
+    std::vector<char> bytes;
+    encodeCheckpoint(checkpoint, bytes);
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        generation = ++generation_;
+        has_pending_ = false; // 同步保存的内容更新，放弃尚未写出的定期检查点
+    }
+    std::lock_guard<std::mutex> io_lock(io_mutex_);
+    return write(bytes, generation);
+}
+
+bool CheckpointStore::write(const std::vector<char>& bytes, uint64_t generation) {
+    if (generation <= written_generation_) {
+        return true; // 已有更新的检查点落盘
+    }
+    bool written = writeFileAtomically(path_, bytes.data(), bytes.size());
+    if (written) {
+        written_generation_ = generation;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++(written ? saved_ : failed_);
+    return written;
+}
+
+uint64_t CheckpointStore::savedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return saved_;
+}
+
+uint64_t CheckpointStore::failedCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return failed_;
+}
+
+void CheckpointStore::writerLoop() {
+    std::vector<char> bytes;
+    for (;;) {
+        uint64_t generation = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stopping_ || has_pending_; });
+            if (!has_pending_) {
+                break;
+            }
+            bytes.swap(pending_);
+            generation = pending_generation_;
+            has_pending_ = false;
+        }
+        std::lock_guard<std::mutex> io_lock(io_mutex_);
+        write(bytes, generation);
+    }
+}
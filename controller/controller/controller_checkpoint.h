@@ -0,0 +1,109 @@
+// controller_checkpoint.h
+#ifndef CONTROLLER_CHECKPOINT_H
+#define CONTROLLER_CHECKPOINT_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "anomaly_rules.h"
+#include "anomaly_types.h"
+#include "device_registry.h"
+#include "ramp_scheduler.h"
+
+// 活动异常及其计时状态（时间以距检查点生成时刻的时长保存，与进程时钟零点无关）
+struct CheckpointAnomaly {
+    AnomalyInfo info;
+    int64_t confirm_remaining_ms;   // 待确认异常距确认的剩余时间，-1为无确认定时器
+    int64_t clear_elapsed_ms;       // 已持续满足恢复条件的时长，-1为未满足
+};
+
+// 运行中修改过的规则滞回
+struct CheckpointHysteresis {
+    RuleId rule;
+    ThresholdBand clear;
+    int32_t min_clear_ms;
+};
+
+// 控制器状态检查点
+struct ControllerCheckpoint {
+    std::chrono::system_clock::time_point created; // 生成时间
+    bool clean_shutdown = false;                    // 停机时生成（之后无状态变化）
+    uint64_t device_fingerprint = 0;                // 设备集合指纹，不符时不恢复异常与爬坡
+
+    // 控制参数
+    double normal_voltage = 0.0;
+    double normal_frequency = 0.0;
+    double max_hydrogen_concentration = 0.0;
+    double max_hydrogen_pressure = 0.0;
+    int32_t anomaly_duration_threshold_ms = 0;
+    double recovery_rate_percent_per_minute = 0.0;
+    int32_t forecast_horizon_ms[TELEMETRY_CHANNEL_COUNT] = {};
+    std::vector<CheckpointHysteresis> hysteresis;
+
+    std::vector<CheckpointAnomaly> anomalies;       // 活动异常（含待确认）
+    std::vector<RampState> ramps;                   // 进行中的恢复爬坡
+};
+
+// 设备集合指纹：按注册顺序的类别与名称
+uint64_t deviceFingerprint(const DeviceRegistry& registry);
+
+// 编码为紧凑二进制（文件头含长度与CRC-32C校验），可直接写入文件
+void encodeCheckpoint(const ControllerCheckpoint& checkpoint, std::vector<char>& out);
+
+// 解码并校验，格式不符、版本不符或校验失败时返回false
+bool decodeCheckpoint(const char* data, size_t size, ControllerCheckpoint& checkpoint);
+
+// 检查点文件：读取在初始化时同步进行；保存由后台线程执行（先写临时文件再原子替换），
+// 定期保存时只保留最新一份待写内容，不阻塞监测线程
+class CheckpointStore {
+public:
+    CheckpointStore() = default;
+    ~CheckpointStore();
+    CheckpointStore(const CheckpointStore&) = delete;
+    CheckpointStore& operator=(const CheckpointStore&) = delete;
+
+    // 设置文件路径并启动后台线程
+    void open(const std::string& path);
+
+    // 停止后台线程（先写完待写内容）
+    void close();
+
+    bool isOpen() const { return writer_.joinable(); }
+    const std::string& path() const { return path_; }
+
+    // 读取检查点，文件不存在或无效时返回false
+    bool load(ControllerCheckpoint& checkpoint) const;
+
+    // 交给后台线程保存（替换尚未写出的上一份）
+    void saveAsync(const ControllerCheckpoint& checkpoint);
+
+    // 同步保存（停机时），成功返回true
+    bool save(const ControllerCheckpoint& checkpoint);
+
+    uint64_t savedCount() const;
+    uint64_t failedCount() const;
+
+private:
+    void writerLoop();
+    bool write(const std::vector<char>& bytes, uint64_t generation); // 持有io_mutex_，跳过比已写出的旧的内容
+
+    std::string path_;
+    std::thread writer_;
+    mutable std::mutex mutex_;                      // 保护待写内容与计数
+    std::condition_variable cv_;
+    std::vector<char> pending_;                     // 待写的最新检查点
+    uint64_t pending_generation_ = 0;
+    uint64_t generation_ = 0;                       // 最近一次编码的代次
+    bool has_pending_ = false;
+    bool stopping_ = false;
+    uint64_t saved_ = 0;
+    uint64_t failed_ = 0;
+    std::mutex io_mutex_;                           // 串行化文件写入
+    uint64_t written_generation_ = 0;               // 已写出的代次（受io_mutex_保护）
+};
+
+#endif // CONTROLLER_CHECKPOINT_H
@@ -0,0 +1,82 @@
+// controller_event.h
+#ifndef CONTROLLER_EVENT_H
+#define CONTROLLER_EVENT_H
+
+#include <cstdint>
+#include "anomaly_types.h"
+
+// 回调类别（决定投递通道与字符串订阅者）
+enum class CallbackKind : uint8_t {
+    STATUS,     // 状态通知
+    CONTROL,    // 功率设定（处置动作、恢复爬坡）
+    SAFETY      // 安全操作
+};
+
+// 控制器事件类别
+enum class ControllerEventKind : uint8_t {
+    ANOMALY_ACTIVATED,          // 异常已确认（或等级升高）并执行处置动作
+    ANOMALY_CLEARED,            // 异常已解除
+    CONFIRMATION_REQUIRED,      // 安全异常恢复需要人工确认
+    RECOVERY_CONFIRMED,         // 安全异常恢复已人工确认
+    RECOVERY_STARTED,           // 开始恢复出力
+    RECOVERY_CANCELLED,         // 异常再次确认，恢复爬坡已取消
+    RAMP_COMPLETED,             // 恢复爬坡完成
+    GRID_RECONNECTED,           // 电网恢复完成并已并网
+    CRITICAL_LOAD_PROTECTED,    // 孤岛模式下保障重要负荷
+    SETPOINT,                   // 功率设定
+    SAFETY_ACTION               // 安全操作
+};
+
+// 安全操作
+enum class SafetyAction : uint8_t {
+    NONE,
+    START_VENTILATION,          // 启动通风系统
+    START_PRESSURE_RELIEF,      // 启动泄压系统
+    ENTER_SAFE_MODE,            // 转入保安全模式
+    CLOSE_GRID_SWITCH           // 闭合并网开关
+};
+
+// 控制器事件记录：定长POD，产生、入队与投递均不分配内存。
+// 恢复爬坡的设定值与完成事件以触发恢复的异常键关联，等级为提示级
+struct ControllerEvent {
+    ControllerEventKind kind;
+    AnomalyType type;               // 异常类型
+    AnomalyLevel level;             // 异常等级
+    SafetyAction action;            // 安全操作（SAFETY_ACTION）
+    RuleId rule;                    // 检测规则
+    AnomalyKey key;                 // 相关异常
+    DeviceIndex device;             // 相关设备
+    uint32_t actions;               // 本次执行的处置动作（ANOMALY_ACTIVATED）
+    double power_kw;                // 设定功率(kW)（SETPOINT）
+    uint64_t batch;                 // 所属设定批次（SETPOINT），0为不成批
+    uint32_t batch_size;            // 批次内的设定数
+    AnomalyDetail detail;           // 异常描述所依据的数值
+    int64_t anomaly_start_us;       // 异常开始时间(system_clock, us)
+    int64_t timestamp_us;           // 事件产生时间(system_clock, us)
+    int64_t enqueue_ns;             // 入队时间(steady, ns)，用于投递时延
+};
+
+// 事件对应的回调类别
+inline CallbackKind callbackKindOf(ControllerEventKind kind) {
+    switch (kind) {
+        case ControllerEventKind::SETPOINT:
+            return CallbackKind::CONTROL;
+        case ControllerEventKind::SAFETY_ACTION:
+            return CallbackKind::SAFETY;
+        default:
+            return CallbackKind::STATUS;
+    }
+}
+
+// 安全操作的文本（字符串订阅者收到的内容）
+inline const char* safetyActionText(SafetyAction action) {
+    switch (action) {
+        case SafetyAction::START_VENTILATION: return "启动通风系统";
+        case SafetyAction::START_PRESSURE_RELIEF: return "启动泄压系统";
+        case SafetyAction::ENTER_SAFE_MODE: return "转入保安全模式";
+        case SafetyAction::CLOSE_GRID_SWITCH: return "闭合并网开关";
+        default: return "";
+    }
+}
+
+#endif // CONTROLLER_EVENT_H
@@ -0,0 +1,108 @@
+// device_registry.cpp
+#include "device_registry.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+// 注册设备
+DeviceIndex DeviceRegistry::registerDevice(DeviceClass device_class,
+                                           const std::string& name,
+                                           double rated_power_kw,
+                                           const std::string& control_target) {
+    if (frozen_ || device_class >= DeviceClass::COUNT) {
+        return INVALID_DEVICE_INDEX; // 冻结后不允许注册
+    }
+    auto& devices = devices_[static_cast<size_t>(device_class)];
+    if (devices.size() >= MAX_DEVICES_PER_CLASS || name_index_.count(name) != 0) {
+        return INVALID_DEVICE_INDEX; // 超出容量或名称重复
+    }
+
+    DeviceIndex index = makeDeviceIndex(device_class, static_cast<uint32_t>(devices.size()));
+    DeviceInfo info;
+    info.device_class = device_class;
+    info.name = name;
+    info.control_target = control_target.empty() ? name : control_target;
+    info.rated_power_kw = rated_power_kw;
+    devices.push_back(info);
+    name_index_[name] = index;
+    return index;
+}
+
+bool DeviceRegistry::isValid(DeviceIndex index) const {
+    if (index == INVALID_DEVICE_INDEX || deviceClassOf(index) >= DeviceClass::COUNT) {
+        return false;
+    }
+    return localIndexOf(index) < devices_[static_cast<size_t>(deviceClassOf(index))].size();
+}
+
+const DeviceInfo& DeviceRegistry::info(DeviceIndex index) const {
+    if (!isValid(index)) {
+        throw std::out_of_range("无效的设备索引");
+    }
+    return devices_[static_cast<size_t>(deviceClassOf(index))][localIndexOf(index)];
+}
+
+DeviceIndex DeviceRegistry::find(const std::string& name) const {
+    auto it = name_index_.find(name);
+    return it != name_index_.end() ? it->second : INVALID_DEVICE_INDEX;
+}
+
+size_t DeviceRegistry::deviceCount(DeviceClass device_class) const {
+    return devices_[static_cast<size_t>(device_class)].size();
+}
+
+size_t DeviceRegistry::totalDeviceCount() const {
+    size_t total = 0;
+    for (const auto& devices : devices_) {
+        total += devices.size();
+    }
+    return total;
+}
+
+size_t DeviceRegistry::memoryUsage() const {
+    size_t bytes = sizeof(*this);
+    for (const auto& devices : devices_) {
+        bytes += devices.capacity() * sizeof(DeviceInfo);
+        for (const auto& device : devices) {
+            bytes += device.name.capacity() + device.control_target.capacity();
+        }
+    }
+    bytes += name_index_.size() * (sizeof(std::string) + sizeof(DeviceIndex) + 2 * sizeof(void*));
+    return bytes;
+}
+
+// 按设备数量分配遥测列，初始值为NaN（尚未上报数据，任何阈值比较均不成立）
+void TelemetryTable::allocate(const DeviceRegistry& registry) {
+    for (size_t c = 0; c < DEVICE_CLASS_COUNT; ++c) {
+        rows_[c] = registry.deviceCount(static_cast<DeviceClass>(c));
+        for (auto& column : columns_[c]) {
+            column.assign(rows_[c], std::numeric_limits<double>::quiet_NaN());
+        }
+        times_[c].assign(rows_[c], NO_SAMPLE_TIME);
+    }
+}
+
+void TelemetryTable::copyFrom(const TelemetryTable& other) {
+    for (size_t c = 0; c < DEVICE_CLASS_COUNT; ++c) {
+        rows_[c] = other.rows_[c];
+        for (size_t ch = 0; ch < TELEMETRY_CHANNEL_COUNT; ++ch) {
+            columns_[c][ch].resize(rows_[c]);
+            std::copy(other.columns_[c][ch].begin(), other.columns_[c][ch].end(),
+                      columns_[c][ch].begin());
+        }
+        times_[c] = other.times_[c];
+    }
+}
+
+size_t TelemetryTable::memoryUsage() const {
+    size_t bytes = sizeof(*this);
+    for (const auto& columns : columns_) {
+        for (const auto& column : columns) {
+            bytes += column.capacity() * sizeof(double);
+        }
+    }
+    for (const auto& times : times_) {
+        bytes += times.capacity() * sizeof(int64_t);
+    }
+    return bytes;
+}
@@ -0,0 +1,147 @@
+// device_registry.h
+#ifndef DEVICE_REGISTRY_H
+#define DEVICE_REGISTRY_H
+
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// 设备类别枚举
+enum class DeviceClass : uint8_t {
+    PV_INVERTER,        // 光伏逆变器
+    WIND_CONTROLLER,    // 风机控制器
+    ESS_PCS,            // 储能PCS
+    ELECTROLYZER,       // 电解槽
+    GRID,               // 并网点
+    HYDROGEN_SYSTEM,    // 储氢系统
+    COUNT
+};
+
+// 遥测通道枚举（每个通道在遥测表中占一列）
+enum class TelemetryChannel : uint8_t {
+    POWER,                  // 有功功率(kW)
+    GRID_VOLTAGE,           // 电网电压(V)
+    GRID_FREQUENCY,         // 电网频率(Hz)
+    HYDROGEN_CONCENTRATION, // 氢浓度(%)
+    HYDROGEN_TANK_PRESSURE, // 氢罐压力(MPa)
+    FAULT,                  // 故障标志(0/1)
+    ISLAND_MODE,            // 孤岛模式标志(0/1)
+    GRID_ROCOF,             // 频率变化率(Hz/s)，派生通道
+    HYDROGEN_PRESSURE_RATE, // 氢罐压力变化率(MPa/s)，派生通道
+    HYDROGEN_CONCENTRATION_DRIFT, // 氢浓度漂移检测统计量（>=1达到门限），派生通道
+    HYDROGEN_PRESSURE_DRIFT,      // 氢罐压力漂移检测统计量（正负表示方向），派生通道
+    HYDROGEN_CONCENTRATION_FORECAST, // 氢浓度预测时域末的外推值(%)，派生通道
+    HYDROGEN_PRESSURE_FORECAST,      // 氢罐压力预测时域末的外推值(MPa)，派生通道
+    COUNT
+};
+
+constexpr size_t DEVICE_CLASS_COUNT = static_cast<size_t>(DeviceClass::COUNT);
+constexpr size_t TELEMETRY_CHANNEL_COUNT = static_cast<size_t>(TelemetryChannel::COUNT);
+
+// 派生通道由监测线程根据其他通道计算，不接受外部写入
+inline bool isDerivedChannel(TelemetryChannel channel) {
+    return channel >= TelemetryChannel::GRID_ROCOF && channel < TelemetryChannel::COUNT;
+}
+
+// 设备索引：高8位为设备类别，低24位为类别内序号，
+// 同类设备在遥测表中连续存放，便于按列一次扫描
+using DeviceIndex = uint32_t;
+constexpr DeviceIndex INVALID_DEVICE_INDEX = 0xFFFFFFFFu;
+constexpr uint32_t MAX_DEVICES_PER_CLASS = 1u << 24;
+
+inline DeviceIndex makeDeviceIndex(DeviceClass cls, uint32_t local_index) {
+    return (static_cast<uint32_t>(cls) << 24) | (local_index & (MAX_DEVICES_PER_CLASS - 1));
+}
+inline DeviceClass deviceClassOf(DeviceIndex index) {
+    return static_cast<DeviceClass>(index >> 24);
+}
+inline uint32_t localIndexOf(DeviceIndex index) {
+    return index & (MAX_DEVICES_PER_CLASS - 1);
+}
+
+// 设备描述信息
+struct DeviceInfo {
+    DeviceClass device_class;       // 设备类别
+    std::string name;               // 设备标识（异常信息中的device_id）
+    std::string control_target;     // 控制回调使用的目标名称
+    double rated_power_kw;          // 额定功率(kW)
+};
+
+// 设备注册表：启动阶段注册设备，冻结后设备集合不再变化
+class DeviceRegistry {
+public:
+    // 注册设备，成功返回设备索引，冻结后或名称重复时返回INVALID_DEVICE_INDEX
+    DeviceIndex registerDevice(DeviceClass device_class,
+                               const std::string& name,
+                               double rated_power_kw,
+                               const std::string& control_target);
+
+    // 冻结注册表（初始化时调用）
+    void freeze() { frozen_ = true; }
+    bool isFrozen() const { return frozen_; }
+
+    // 查询接口
+    bool isValid(DeviceIndex index) const;
+    const DeviceInfo& info(DeviceIndex index) const;
+    DeviceIndex find(const std::string& name) const;
+    size_t deviceCount(DeviceClass device_class) const;
+    size_t totalDeviceCount() const;
+
+    // 内存占用估算(字节)
+    size_t memoryUsage() const;
+
+private:
+    std::vector<DeviceInfo> devices_[DEVICE_CLASS_COUNT];     // 按类别分组的设备信息
+    std::unordered_map<std::string, DeviceIndex> name_index_; // 名称索引
+    bool frozen_ = false;
+};
+
+constexpr int64_t NO_SAMPLE_TIME = std::numeric_limits<int64_t>::min(); // 尚无数据
+
+// 遥测表：结构数组(SoA)布局，每个设备类别一块，每个通道一列
+class TelemetryTable {
+public:
+    // 按注册表中各类设备数量分配列
+    void allocate(const DeviceRegistry& registry);
+
+    size_t rowCount(DeviceClass device_class) const {
+        return rows_[static_cast<size_t>(device_class)];
+    }
+
+    double* column(DeviceClass device_class, TelemetryChannel channel) {
+        return columns_[static_cast<size_t>(device_class)][static_cast<size_t>(channel)].data();
+    }
+    const double* column(DeviceClass device_class, TelemetryChannel channel) const {
+        return columns_[static_cast<size_t>(device_class)][static_cast<size_t>(channel)].data();
+    }
+
+    // 各设备最近一次写入的采集时间(system_clock, us)，尚无数据为NO_SAMPLE_TIME
+    int64_t* sampleTimes(DeviceClass device_class) {
+        return times_[static_cast<size_t>(device_class)].data();
+    }
+    const int64_t* sampleTimes(DeviceClass device_class) const {
+        return times_[static_cast<size_t>(device_class)].data();
+    }
+
+    double value(DeviceIndex device, TelemetryChannel channel) const {
+        return column(deviceClassOf(device), channel)[localIndexOf(device)];
+    }
+    void setValue(DeviceIndex device, TelemetryChannel channel, double value) {
+        column(deviceClassOf(device), channel)[localIndexOf(device)] = value;
+    }
+
+    // 整表复制（复用已分配内存，稳态下不分配）
+    void copyFrom(const TelemetryTable& other);
+
+    size_t memoryUsage() const;
+
+private:
+    size_t rows_[DEVICE_CLASS_COUNT] = {};
+    std::vector<double> columns_[DEVICE_CLASS_COUNT][TELEMETRY_CHANNEL_COUNT];
+    std::vector<int64_t> times_[DEVICE_CLASS_COUNT];
+};
+
+#endif // DEVICE_REGISTRY_H
@@ -0,0 +1,123 @@
+// drift_detector.cpp
+#include "drift_detector.h"
+#include "bit_ops.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr int64_t NO_TIME = std::numeric_limits<int64_t>::min();
+constexpr double NOISE_ALPHA = 0.02;        // 噪声估计的平滑系数（每个变化样本）
+constexpr double MAX_STEP_S = 10.0;         // 单个样本的最大积分时长，数据中断后不致突增
+constexpr double FREEZE_LEVEL = 0.1;        // CUSUM统计量达到门限的该比例后冻结基线
+constexpr double SATURATION = 10.0;         // 统计量上限（门限的倍数），偏差消失后在有限时间内回落
+
+} // namespace
+
+std::vector<DriftDetectorSpec> builtinDriftDetectors() {
+    return {
+        // 氢浓度：泄漏表现为缓慢上升，基线时间常数1h；偏差超出0.5σ的部分累积满300σ·s达到门限
+        {DeviceClass::HYDROGEN_SYSTEM, TelemetryChannel::HYDROGEN_CONCENTRATION,
+         TelemetryChannel::HYDROGEN_CONCENTRATION_DRIFT, DriftMethod::CUSUM, true, false,
+         0.5, 300.0, 3600000, 60000, 0.005},
+        // 氢罐压力：泄漏表现为缓慢下降，充装异常表现为上升，双向检测；
+        // 充放氢改变压力水平，参考值按10min遗忘，新水平稳定后统计量回落
+        {DeviceClass::HYDROGEN_SYSTEM, TelemetryChannel::HYDROGEN_TANK_PRESSURE,
+         TelemetryChannel::HYDROGEN_PRESSURE_DRIFT, DriftMethod::PAGE_HINKLEY, true, true,
+         0.5, 300.0, 600000, 60000, 0.002},
+    };
+}
+
+DriftDetector::DriftDetector(const DriftDetectorSpec& spec)
+    : spec_(spec),
+      baseline_us_(static_cast<double>(std::max<int32_t>(1, spec.baseline_ms)) * 1000.0),
+      warmup_us_(static_cast<int64_t>(std::max<int32_t>(0, spec.warmup_ms)) * 1000) {
+    spec_.threshold_sigma_s = std::max(spec.threshold_sigma_s, std::numeric_limits<double>::min());
+}
+
+void DriftDetector::allocate(size_t rows) {
+    states_.assign(rows, RowState{});
+    for (RowState& state : states_) {
+        reset(state);
+    }
+}
+
+void DriftDetector::reset(RowState& state) {
+    state = RowState{};
+    state.first_time_us = NO_TIME;
+    state.last_time_us = NO_TIME;
+    state.last_value = std::numeric_limits<double>::quiet_NaN();
+}
+
+double DriftDetector::update(size_t row, int64_t time_us, double value) {
+    RowState& state = states_[row];
+    if (std::isnan(value) || time_us <= state.last_time_us) {
+        return state.output; // 无数据或乱序
+    }
+    if (state.first_time_us == NO_TIME) {
+        state.first_time_us = time_us;
+        state.last_time_us = time_us;
+        state.last_value = value;
+        state.reference = value;
+        return state.output;
+    }
+    double dt_us = static_cast<double>(time_us - state.last_time_us);
+    double dt_s = std::min(MAX_STEP_S, dt_us * 1e-6);
+
+    // 噪声：白噪声相邻差分的方差为2σ²；只用变化的样本，补点的重复值不拉低估计
+    double diff = value - state.last_value;
+    if (diff != 0.0) {
+        state.diff_square = state.diff_square == 0.0 ? diff * diff :
+            state.diff_square + NOISE_ALPHA * (diff * diff - state.diff_square);
+    }
+    double sigma = std::max(spec_.min_sigma, std::sqrt(state.diff_square * 0.5));
+    double elapsed_us = static_cast<double>(time_us - state.first_time_us);
+    bool warming = time_us - state.first_time_us < warmup_us_;
+    double cap = SATURATION * spec_.threshold_sigma_s;
+
+    double z = (value - state.reference) / sigma;
+    if (spec_.method == DriftMethod::CUSUM) {
+        if (!warming) {
+            state.up = std::min(cap, std::max(0.0, state.up + (z - spec_.allowance_sigma) * dt_s));
+            state.down = std::min(cap, std::max(0.0, state.down + (-z - spec_.allowance_sigma) * dt_s));
+        }
+    } else if (!warming) {
+        state.up += (z - spec_.allowance_sigma) * dt_s;
+        state.down += (-z - spec_.allowance_sigma) * dt_s;
+        state.up_extreme = std::max(std::min(state.up_extreme, state.up), state.up - cap);
+        state.down_extreme = std::max(std::min(state.down_extreme, state.down), state.down - cap);
+    }
+    double up = spec_.method == DriftMethod::CUSUM ? state.up : state.up - state.up_extreme;
+    double down = spec_.method == DriftMethod::CUSUM ? state.down : state.down - state.down_extreme;
+
+    // 参考值按基线时间常数遗忘，起始阶段按起始以来的均值收敛（慢速基线来不及跟上首个样本的噪声）。
+    // CUSUM在漂移累积期间冻结基线，避免基线跟随漂移而掩盖它；
+    // PH不冻结：水平改变（如充放氢）后参考值重新收敛，偏差回到容差以内时统计量回落、告警解除，
+    // 持续漂移使参考值保持约“速率×时间常数”的滞后，仍会累积到门限
+    if (spec_.method == DriftMethod::PAGE_HINKLEY || std::max(up, down) < FREEZE_LEVEL * spec_.threshold_sigma_s) {
+        double alpha = std::max(1.0 - std::exp(-dt_us / baseline_us_), dt_us / elapsed_us);
+        state.reference += (value - state.reference) * alpha;
+    }
+    up = spec_.upward ? up / spec_.threshold_sigma_s : 0.0;
+    down = spec_.downward ? down / spec_.threshold_sigma_s : 0.0;
+    state.output = up >= down ? up : -down;
+    state.last_time_us = time_us;
+    state.last_value = value;
+    return state.output;
+}
+
+void DriftDetector::updateColumn(const double* values, const int64_t* times, const uint64_t* changed,
+                                 double* outputs, uint64_t* output_changed, size_t rows) {
+    for (size_t w = 0; w < (rows + 63) / 64; ++w) {
+        for (uint64_t bits = changed[w]; bits != 0; bits &= bits - 1) {
+            unsigned bit = lowestSetBit(bits);
+            size_t row = w * 64 + bit;
+            double output = update(row, times[row], values[row]);
+            if (output != outputs[row] && !(std::isnan(output) && std::isnan(outputs[row]))) {
+                outputs[row] = output;
+                output_changed[w] |= 1ull << bit;
+            }
+        }
+    }
+}
@@ -0,0 +1,78 @@
+// drift_detector.h
+#ifndef DRIFT_DETECTOR_H
+#define DRIFT_DETECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "device_registry.h"
+
+// 变点检测方法
+enum class DriftMethod : uint8_t {
+    CUSUM,          // 累积和：相对慢速基线（漂移期间冻结）累积超出容差的偏差
+    PAGE_HINKLEY    // Page-Hinkley：相对慢速遗忘均值累积偏差，取累积量与其历史极值之差
+};
+
+// 漂移检测器定义：由源通道计算派生通道（检测统计量/门限，>=1即达到门限，正负表示方向）
+struct DriftDetectorSpec {
+    DeviceClass device_class;       // 适用设备类别
+    TelemetryChannel source;        // 源通道
+    TelemetryChannel output;        // 派生通道
+    DriftMethod method;
+    bool upward;                    // 检测上升漂移
+    bool downward;                  // 检测下降漂移
+    double allowance_sigma;         // 容差k（噪声标准差的倍数），小于该偏差不累积
+    double threshold_sigma_s;       // 门限h（标准差·秒）：偏差按时间积分，与采样率无关
+    int32_t baseline_ms;            // 基线（参考值）时间常数(ms)：更早的数据按指数遗忘
+    int32_t warmup_ms;              // 预热时间(ms)：估计基线与噪声期间输出0
+    double min_sigma;               // 噪声标准差下限（源通道单位），避免量化平坦信号过于敏感
+};
+
+// 内置漂移检测器：氢浓度缓慢上升（CUSUM）、氢罐压力漂移（双向Page-Hinkley）
+std::vector<DriftDetectorSpec> builtinDriftDetectors();
+
+// 流式漂移检测：每台设备固定大小的状态，每个样本O(1)。
+// 噪声标准差由相邻样本差分估计（慢速漂移不会抬高噪声估计）。
+// 统计量以门限的10倍为上限，偏差消失后在有限时间内回落，由规则的恢复条件判定解除。
+// 非线程安全，仅监测线程使用。
+class DriftDetector {
+public:
+    explicit DriftDetector(const DriftDetectorSpec& spec);
+
+    // 按设备行数分配状态
+    void allocate(size_t rows);
+
+    // 接入单个样本（时间戳us），返回归一化检测统计量；乱序样本被忽略
+    double update(size_t row, int64_t time_us, double value);
+
+    // 接入整列快照：仅本轮有写入的设备（changed位图）按其采集时间接入，结果写入outputs对应行，
+    // 结果有变化的设备在output_changed位图中置位；已由带时间戳样本接入的同一时刻不会重复接入
+    void updateColumn(const double* values, const int64_t* times, const uint64_t* changed,
+                      double* outputs, uint64_t* output_changed, size_t rows);
+
+    double output(size_t row) const { return states_[row].output; }
+    const DriftDetectorSpec& spec() const { return spec_; }
+
+private:
+    struct RowState {
+        int64_t first_time_us;          // 首个样本时间
+        int64_t last_time_us;           // 最近样本时间
+        double last_value;              // 最近样本值
+        double reference;               // 参考值（慢速遗忘的时间加权均值）
+        double diff_square;             // 相邻差分平方的滑动平均（噪声方差的2倍）
+        double up;                      // 上升累积量（CUSUM为S+，PH为m+）
+        double down;                    // 下降累积量
+        double up_extreme;              // PH：m+历史最小值
+        double down_extreme;            // PH：m-历史最小值
+        double output;
+    };
+
+    void reset(RowState& state);
+
+    DriftDetectorSpec spec_;
+    double baseline_us_;
+    int64_t warmup_us_;
+    std::vector<RowState> states_;
+};
+
+#endif // DRIFT_DETECTOR_H
@@ -0,0 +1,133 @@
+// event_bus.cpp
+#include "event_bus.h"
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+int64_t steadyNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+bool EventFilter::matches(const ControllerEvent& event) const {
+    if (!(types & anomalyTypeBit(event.type)) || !(levels & anomalyLevelBit(event.level)) ||
+        !(kinds & eventKindBit(event.kind))) {
+        return false;
+    }
+    return devices.empty() || std::binary_search(devices.begin(), devices.end(), event.device);
+}
+
+SubscriberQueue::SubscriberQueue(uint64_t id, const EventSubscription& subscription, EventCallback callback)
+    : id_(id),
+      name_(subscription.name),
+      filter_(subscription.filter),
+      policy_(subscription.policy),
+      callback_(std::move(callback)),
+      ring_(std::max<size_t>(1, subscription.capacity)) {
+    std::sort(filter_.devices.begin(), filter_.devices.end());
+}
+
+std::shared_ptr<SubscriberQueue> SubscriberQueue::create(uint64_t id, const EventSubscription& subscription,
+                                                         EventCallback callback) {
+    std::shared_ptr<SubscriberQueue> queue(new SubscriberQueue(id, subscription, std::move(callback)));
+    queue->worker_ = std::thread([self = queue] { self->run(); });
+    return queue;
+}
+
+SubscriberQueue::~SubscriberQueue() {
+    close();
+}
+
+void SubscriberQueue::push(const ControllerEvent& event, bool may_block) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (count_ == ring_.size() && !closing_) {
+        if (policy_ == BackpressurePolicy::BLOCK && may_block) {
+            ++blocked_;
+            not_full_.wait(lock, [this] { return count_ < ring_.size() || closing_; });
+        } else if (policy_ == BackpressurePolicy::DROP_NEWEST) {
+            ++dropped_;
+            return;
+        } else {
+            head_ = (head_ + 1) % ring_.size(); // 挤出最旧的事件
+            --count_;
+            ++dropped_;
+            ++finished_;
+        }
+    }
+    if (closing_) {
+        ++dropped_; // 已注销
+        return;
+    }
+    ring_[(head_ + count_) % ring_.size()] = event;
+    ++count_;
+    ++accepted_;
+    max_lag_ = std::max<uint64_t>(max_lag_, count_);
+    lock.unlock();
+    not_empty_.notify_one();
+}
+
+void SubscriberQueue::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        not_empty_.wait(lock, [this] { return count_ > 0 || closing_; });
+        if (count_ == 0) {
+            break; // 已关闭且已投递完
+        }
+        ControllerEvent event = ring_[head_];
+        head_ = (head_ + 1) % ring_.size();
+        --count_;
+        int64_t latency_us = (steadyNowNs() - event.enqueue_ns) / 1000;
+        last_latency_us_ = latency_us;
+        max_latency_us_ = std::max(max_latency_us_, latency_us);
+        lock.unlock();
+        not_full_.notify_one();
+        callback_(event);
+        lock.lock();
+        ++delivered_;
+        ++finished_;
+        drained_.notify_all();
+    }
+    stopped_ = true;
+    drained_.notify_all();
+}
+
+void SubscriberQueue::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t target = accepted_;
+    drained_.wait(lock, [this, target] { return finished_ >= target || stopped_; });
+}
+
+void SubscriberQueue::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (closing_) {
+            return;
+        }
+        closing_ = true;
+    }
+    not_empty_.notify_one();
+    not_full_.notify_all();
+    if (std::this_thread::get_id() == worker_.get_id()) {
+        worker_.detach(); // 在自己的回调中注销：投递线程随后自行退出
+    } else {
+        worker_.join();
+    }
+}
+
+SubscriberMetrics SubscriberQueue::metrics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    SubscriberMetrics metrics;
+    metrics.id = id_;
+    metrics.name = name_;
+    metrics.delivered = delivered_;
+    metrics.dropped = dropped_;
+    metrics.blocked = blocked_;
+    metrics.lag = count_;
+    metrics.max_lag = max_lag_;
+    metrics.last_latency_us = last_latency_us_;
+    metrics.max_latency_us = max_latency_us_;
+    return metrics;
+}
@@ -0,0 +1,124 @@
+// event_bus.h
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "controller_event.h"
+
+constexpr uint32_t ALL_EVENTS = ~0u; // 过滤掩码：不限
+
+inline uint32_t anomalyTypeBit(AnomalyType type) {
+    return 1u << static_cast<uint32_t>(type);
+}
+inline uint32_t anomalyLevelBit(AnomalyLevel level) {
+    return 1u << static_cast<uint32_t>(level);
+}
+inline uint32_t eventKindBit(ControllerEventKind kind) {
+    return 1u << static_cast<uint32_t>(kind);
+}
+
+// 订阅过滤条件：按异常类型、异常等级、事件类别（位掩码）与设备
+struct EventFilter {
+    uint32_t types = ALL_EVENTS;
+    uint32_t levels = ALL_EVENTS;
+    uint32_t kinds = ALL_EVENTS;
+    std::vector<DeviceIndex> devices;   // 为空时不限设备
+
+    bool matches(const ControllerEvent& event) const;
+};
+
+// 订阅者队列满时的处理
+enum class BackpressurePolicy : uint8_t {
+    DROP_OLDEST,    // 丢弃最旧的事件
+    DROP_NEWEST,    // 丢弃新到的事件
+    BLOCK           // 普通通道等待订阅者腾出位置；安全与控制通道从不等待，按丢弃最旧处理
+};
+
+// 订阅参数
+struct EventSubscription {
+    std::string name;                   // 订阅者名称（指标中显示）
+    EventFilter filter;
+    BackpressurePolicy policy = BackpressurePolicy::DROP_OLDEST;
+    size_t capacity = 1024;             // 队列容量（事件数）
+};
+
+// 单个订阅者的投递指标
+struct SubscriberMetrics {
+    uint64_t id;
+    std::string name;
+    uint64_t delivered;                 // 已投递数
+    uint64_t dropped;                   // 队列满而丢弃数
+    uint64_t blocked;                   // 队列满而等待的次数（BLOCK）
+    uint64_t lag;                       // 当前积压的事件数
+    uint64_t max_lag;                   // 最大积压
+    int64_t last_latency_us;            // 最近一次投递时延(us)：事件入队 -> 订阅者回调开始
+    int64_t max_latency_us;             // 最大投递时延(us)
+};
+
+// 订阅者专用的有界队列与投递线程：慢速订阅者只积压自己的队列，不影响其他订阅者与分发通道。
+// 投递线程持有队列的引用，在自己的回调中注销也是安全的
+class SubscriberQueue {
+public:
+    using EventCallback = std::function<void(const ControllerEvent& event)>;
+
+    // 创建队列并启动投递线程
+    static std::shared_ptr<SubscriberQueue> create(uint64_t id, const EventSubscription& subscription,
+                                                   EventCallback callback);
+    ~SubscriberQueue();
+    SubscriberQueue(const SubscriberQueue&) = delete;
+    SubscriberQueue& operator=(const SubscriberQueue&) = delete;
+
+    uint64_t id() const { return id_; }
+    bool matches(const ControllerEvent& event) const { return filter_.matches(event); }
+
+    // 入队（由分发线程调用），may_block为false时从不等待
+    void push(const ControllerEvent& event, bool may_block);
+
+    // 等待此前入队的事件处理完毕（投递或丢弃），不可在本订阅者的回调中调用
+    void flush();
+
+    // 投递完已入队的事件后停止投递线程（在本订阅者的回调中调用时不等待）
+    void close();
+
+    SubscriberMetrics metrics() const;
+
+private:
+    SubscriberQueue(uint64_t id, const EventSubscription& subscription, EventCallback callback);
+    void run();
+
+    uint64_t id_;
+    std::string name_;
+    EventFilter filter_;
+    BackpressurePolicy policy_;
+    EventCallback callback_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::condition_variable drained_;
+    std::vector<ControllerEvent> ring_;
+    size_t head_ = 0;                   // 队首下标
+    size_t count_ = 0;                  // 积压数
+    bool closing_ = false;
+    bool stopped_ = false;              // 投递线程已退出
+    uint64_t accepted_ = 0;             // 已入队数
+    uint64_t finished_ = 0;             // 已投递或被挤出的数
+    uint64_t delivered_ = 0;
+    uint64_t dropped_ = 0;
+    uint64_t blocked_ = 0;
+    uint64_t max_lag_ = 0;
+    int64_t last_latency_us_ = 0;
+    int64_t max_latency_us_ = 0;
+    std::thread worker_;
+};
+
+#endif // EVENT_BUS_H
@@ -0,0 +1,227 @@
+// file_io.cpp
+#include "file_io.h"
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// CRC-32C查表
+struct Crc32cTable {
+    uint32_t entries[256];
+    Crc32cTable() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ ((crc & 1u) ? 0x82F63B78u : 0u);
+            }
+            entries[i] = crc;
+        }
+    }
+};
+
+#ifdef _WIN32
+HANDLE toHandle(FileHandle file) {
+    return reinterpret_cast<HANDLE>(file);
+}
+#endif
+
+} // namespace
+
+uint32_t crc32c(const char* data, size_t size, uint32_t crc) {
+    static const Crc32cTable table;
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table.entries[(crc ^ static_cast<uint8_t>(data[i])) & 0xFFu] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+bool writeFileAtomically(const std::string& path, const char* data, size_t size) {
+    std::string temporary = path + ".tmp";
+    FileHandle file = openFile(temporary, true);
+    if (file == INVALID_FILE) {
+        return false;
+    }
+    bool written = writeAll(file, data, size) && syncFile(file);
+    closeFile(file);
+    return written && replaceFile(temporary, path);
+}
+
+#ifdef _WIN32
+
+FileHandle openFile(const std::string& path, bool truncate) {
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                                truncate ? CREATE_ALWAYS : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    return handle == INVALID_HANDLE_VALUE ? INVALID_FILE : reinterpret_cast<FileHandle>(handle);
+}
+
+void closeFile(FileHandle file) {
+    CloseHandle(toHandle(file));
+}
+
+bool fileSize(FileHandle file, uint64_t& size) {
+    LARGE_INTEGER value;
+    if (!GetFileSizeEx(toHandle(file), &value)) {
+        return false;
+    }
+    size = static_cast<uint64_t>(value.QuadPart);
+    return true;
+}
+
+bool truncateFile(FileHandle file, uint64_t size) {
+    LARGE_INTEGER position;
+    position.QuadPart = static_cast<LONGLONG>(size);
+    return SetFilePointerEx(toHandle(file), position, nullptr, FILE_BEGIN) && SetEndOfFile(toHandle(file));
+}
+
+bool writeAll(FileHandle file, const char* data, size_t size) {
+    while (size > 0) {
+        DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 1u << 30));
+        DWORD written = 0;
+        if (!WriteFile(toHandle(file), data, chunk, &written, nullptr)) {
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+bool syncFile(FileHandle file) {
+    return FlushFileBuffers(toHandle(file)) != 0;
+}
+
+bool replaceFile(const std::string& from, const std::string& to) {
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
+bool mapFile(FileHandle file, uint64_t size, MappedFile& view) {
+    view = MappedFile();
+    if (size == 0) {
+        return true;
+    }
+    HANDLE mapping = CreateFileMappingA(toHandle(file), nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        return false;
+    }
+    view.data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (view.data == nullptr) {
+        CloseHandle(mapping);
+        return false;
+    }
+    view.size = size;
+    view.mapping = mapping;
+    return true;
+}
+
+void unmapFile(MappedFile& view) {
+    if (view.data != nullptr) {
+        UnmapViewOfFile(view.data);
+    }
+    if (view.mapping != nullptr) {
+        CloseHandle(static_cast<HANDLE>(view.mapping));
+    }
+    view = MappedFile();
+}
+
+#else
+
+FileHandle openFile(const std::string& path, bool truncate) {
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : 0), 0644);
+    return fd < 0 ? INVALID_FILE : static_cast<FileHandle>(fd);
+}
+
+void closeFile(FileHandle file) {
+    ::close(static_cast<int>(file));
+}
+
+bool fileSize(FileHandle file, uint64_t& size) {
+    struct stat info;
+    if (::fstat(static_cast<int>(file), &info) != 0) {
+        return false;
+    }
+    size = static_cast<uint64_t>(info.st_size);
+    return true;
+}
+
+bool truncateFile(FileHandle file, uint64_t size) {
+    return ::ftruncate(static_cast<int>(file), static_cast<off_t>(size)) == 0 &&
+        ::lseek(static_cast<int>(file), 0, SEEK_END) >= 0;
+}
+
+bool writeAll(FileHandle file, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(static_cast<int>(file), data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool syncFile(FileHandle file) {
+#if defined(__APPLE__)
+    return ::fsync(static_cast<int>(file)) == 0;
+#else
+    return ::fdatasync(static_cast<int>(file)) == 0;
+#endif
+}
+
+// rename为原子替换；随后同步所在目录，保证替换本身落盘
+bool replaceFile(const std::string& from, const std::string& to) {
+    if (::rename(from.c_str(), to.c_str()) != 0) {
+        return false;
+    }
+    size_t slash = to.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : to.substr(0, slash);
+    int fd = ::open(directory.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+    return true;
+}
+
+bool mapFile(FileHandle file, uint64_t size, MappedFile& view) {
+    view = MappedFile();
+    if (size == 0) {
+        return true;
+    }
+    void* address = ::mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_PRIVATE, static_cast<int>(file), 0);
+    if (address == MAP_FAILED) {
+        return false;
+    }
+    ::madvise(address, static_cast<size_t>(size), MADV_SEQUENTIAL); // 顺序遍历，提前预读
+    view.data = static_cast<const char*>(address);
+    view.size = size;
+    return true;
+}
+
+void unmapFile(MappedFile& view) {
+    if (view.data != nullptr) {
+        ::munmap(const_cast<char*>(view.data), static_cast<size_t>(view.size));
+    }
+    view = MappedFile();
+}
+
+#endif
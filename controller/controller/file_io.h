@@ -0,0 +1,49 @@
+// file_io.h
+#ifndef FILE_IO_H
+#define FILE_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 落盘文件的平台操作（POSIX与Windows接口一致），供异常日志与状态检查点使用
+
+// 平台文件句柄（POSIX为fd，Windows为HANDLE）
+using FileHandle = intptr_t;
+constexpr FileHandle INVALID_FILE = -1;
+
+// 以读写方式打开（不存在则创建），truncate为true时清空
+FileHandle openFile(const std::string& path, bool truncate);
+void closeFile(FileHandle file);
+bool fileSize(FileHandle file, uint64_t& size);
+
+// 截断到size并把写位置移到末尾
+bool truncateFile(FileHandle file, uint64_t size);
+
+// 在写位置写入全部数据
+bool writeAll(FileHandle file, const char* data, size_t size);
+
+// 数据刷到存储设备
+bool syncFile(FileHandle file);
+
+// 原子替换（目标已存在时覆盖）并使替换本身落盘；Windows下调用前须关闭两个文件的句柄
+bool replaceFile(const std::string& from, const std::string& to);
+
+// 先写临时文件并刷盘，再原子替换path：崩溃时path保持旧内容或新内容之一
+bool writeFileAtomically(const std::string& path, const char* data, size_t size);
+
+// 只读内存映射
+struct MappedFile {
+    const char* data = nullptr;
+    uint64_t size = 0;
+    void* mapping = nullptr;    // Windows映射对象句柄
+};
+
+// 映射整个文件（size为0时不映射，返回true）
+bool mapFile(FileHandle file, uint64_t size, MappedFile& view);
+void unmapFile(MappedFile& view);
+
+// CRC-32C（Castagnoli），crc为前一段的结果，可分段计算
+uint32_t crc32c(const char* data, size_t size, uint32_t crc = 0);
+
+#endif // FILE_IO_H
@@ -147,8 +147,8 @@ int main() {
         if (i == 105) {
             // 第105秒：模拟人工确认安全异常恢复
             std::cout << currentTimeString() << "模拟人工确认安全异常恢复" << std::endl;
-            controller.confirmSafetyAnomalyRecovery("氢浓度异常: 1.2%");
-            controller.confirmSafetyAnomalyRecovery("氢罐压力异常: 2.0MPa");
+            controller.confirmSafetyAnomalyRecovery("氢浓度异常");
+            controller.confirmSafetyAnomalyRecovery("氢罐压力异常");
         }
 
         // 更新系统状态
@@ -166,12 +166,35 @@ int main() {
     // 停止系统
     std::cout << currentTimeString() << "停止监测系统..." << std::endl;
     controller.enableMonitoring(false);
+    controller.shutdown();
     
     // 等待监测线程结束
     if (monitoringThread.joinable()) {
         monitoringThread.join();
     }
     
+    controller.flushCallbacks(); // 等待回调输出完成
+    
+    MonitoringMetrics metrics = controller.getMetrics();
+    std::cout << currentTimeString() << "扫描轮数: " << metrics.scan_count
+              << ", 检出异常: " << metrics.detection_count
+              << ", 确认异常: " << metrics.confirmed_anomalies
+              << ", 瞬态异常: " << metrics.transient_anomalies
+              << ", 滞回抑制: " << metrics.suppressed_transitions
+              << ", 电压事件: " << metrics.voltage_events
+              << ", 历史记录: " << metrics.history_records
+              << ", 平均检测时延: " << metrics.mean_detection_latency_us << " us"
+              << ", 最大检测时延: " << metrics.max_detection_latency_us << " us" << std::endl;
+    std::cout << currentTimeString() << "回调投递: 安全 " << metrics.callback_dispatch.safety.delivered
+              << " (最大时延 " << metrics.callback_dispatch.safety.max_latency_us << " us)"
+              << ", 控制 " << metrics.callback_dispatch.control.delivered
+              << " (最大时延 " << metrics.callback_dispatch.control.max_latency_us << " us)"
+              << ", 普通 " << metrics.callback_dispatch.normal.delivered
+              << " (最大时延 " << metrics.callback_dispatch.normal.max_latency_us << " us"
+              << ", 丢弃 " << metrics.callback_dispatch.normal.dropped << ")" << std::endl;
+    std::cout << currentTimeString() << "功率设定: " << metrics.setpoint_batches << " 批, 下发 "
+              << metrics.issued_setpoints << " 条, 合并 " << metrics.coalesced_setpoints << " 条" << std::endl;
+    
     std::cout << currentTimeString() << "测试完成" << std::endl;
     return 0;
 }
\ No newline at end of file
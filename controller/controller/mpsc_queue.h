@@ -0,0 +1,93 @@
+// mpsc_queue.h
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// 有界无锁多生产者单消费者队列（Vyukov环形队列）
+// 每个槽带序号：序号等于入队位置时可写，等于位置+1时可读，读出后加上容量供下一轮写入。
+// 生产者以CAS领取入队位置后写槽并发布序号，互不等待；消费者只读自己的出队位置，无需CAS。
+// 队列满时入队失败，由调用方决定丢弃或重试。容量取不小于给定值的2的幂
+template <typename T>
+class MpscQueue {
+public:
+    explicit MpscQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        cells_.reset(new Cell[size]);
+        mask_ = size - 1;
+        for (size_t i = 0; i < size; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    // 入队（成功时移走value），队列满返回false；可多线程并发调用
+    bool tryPush(T& value) {
+        size_t position = tail_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[position & mask_];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (diff == 0) {
+                if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // 该槽尚未被消费：队列满
+            } else {
+                position = tail_.load(std::memory_order_relaxed); // 被其他生产者抢先
+            }
+        }
+    }
+
+    // 出队，队首尚未发布时返回false；仅消费者线程调用
+    bool tryPop(T& value) {
+        size_t position = head_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[position & mask_];
+        if (cell.sequence.load(std::memory_order_acquire) != position + 1) {
+            return false;
+        }
+        value = std::move(cell.value);
+        cell.sequence.store(position + mask_ + 1, std::memory_order_release);
+        head_.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 队首是否已有可读元素；仅消费者线程调用
+    bool readable() const {
+        size_t position = head_.load(std::memory_order_relaxed);
+        return cells_[position & mask_].sequence.load(std::memory_order_acquire) == position + 1;
+    }
+
+    // 当前元素数（含已领取位置、尚未发布的元素），并发下为近似值
+    size_t size() const {
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_ = 0;
+    alignas(64) std::atomic<size_t> tail_{0};   // 入队位置（生产者竞争）
+    alignas(64) std::atomic<size_t> head_{0};   // 出队位置（仅消费者写）
+};
+
+#endif // MPSC_QUEUE_H
@@ -0,0 +1,109 @@
+// phasor_estimator.cpp
+#include "phasor_estimator.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+constexpr double SQRT2 = 1.41421356237309504880;
+
+} // namespace
+
+PhasorEstimator::PhasorEstimator(double sample_rate_hz, double nominal_frequency_hz, uint32_t phases)
+    : sample_rate_hz_(sample_rate_hz), phases_(phases) {
+    if (!(nominal_frequency_hz > 0.0) || !(sample_rate_hz >= 8.0 * nominal_frequency_hz) ||
+        phases == 0 || phases > MAX_PHASES) {
+        return; // 参数无效，isValid()为false
+    }
+    window_ = static_cast<uint32_t>(std::lround(sample_rate_hz / nominal_frequency_hz));
+    cos_.resize(window_);
+    sin_.resize(window_);
+    for (uint32_t i = 0; i < window_; ++i) {
+        double theta = 2.0 * PI * i / window_;
+        cos_[i] = std::cos(theta);
+        sin_[i] = std::sin(theta);
+    }
+    for (uint32_t p = 0; p < phases_; ++p) {
+        buffer_[p].assign(window_, 0.0);
+    }
+}
+
+size_t PhasorEstimator::process(const double* samples, size_t frames, std::vector<PhasorMeasurement>& out) {
+    if (!isValid() || samples == nullptr) {
+        return 0;
+    }
+    size_t produced = 0;
+    for (size_t frame = 0; frame < frames; ++frame) {
+        const double* x = samples + frame * phases_;
+        uint32_t i = position_;
+        for (uint32_t p = 0; p < phases_; ++p) {
+            double old = buffer_[p][i];
+            double diff = x[p] - old;
+            buffer_[p][i] = x[p];
+            re_[p] += diff * cos_[i];
+            im_[p] -= diff * sin_[i];
+            square_sum_[p] += x[p] * x[p] - old * old;
+        }
+        ++filled_;
+        if (++position_ < window_) {
+            continue;
+        }
+        position_ = 0;
+        if (filled_ < window_) {
+            continue; // 首个周波未满
+        }
+        // 周波结束：窗口恰好对齐旋转因子表
+        if (++cycles_since_resync_ >= RESYNC_CYCLES) {
+            resync();
+        }
+
+        PhasorMeasurement m;
+        m.frame = frame;
+        for (uint32_t p = 0; p < MAX_PHASES; ++p) {
+            m.rms[p] = p < phases_ ? std::sqrt(std::max(0.0, square_sum_[p]) / window_) :
+                std::numeric_limits<double>::quiet_NaN();
+        }
+        // 正序相量 V1 = (Va + a·Vb + a²·Vc) / 3，a = e^(j2π/3)
+        double re = re_[0];
+        double im = im_[0];
+        if (phases_ == 3) {
+            const double c = -0.5;
+            const double s = std::sqrt(3.0) / 2.0;
+            re = (re_[0] + (c * re_[1] - s * im_[1]) + (c * re_[2] + s * im_[2])) / 3.0;
+            im = (im_[0] + (c * im_[1] + s * re_[1]) + (c * im_[2] - s * re_[2])) / 3.0;
+        }
+        m.fundamental_rms = std::hypot(re, im) * SQRT2 / window_;
+        m.angle_rad = std::atan2(im, re);
+        m.frequency_hz = std::numeric_limits<double>::quiet_NaN();
+        if (has_last_angle_) {
+            double delta = m.angle_rad - last_angle_;
+            delta -= 2.0 * PI * std::floor((delta + PI) / (2.0 * PI)); // 归一到[-π, π)
+            m.frequency_hz = (sample_rate_hz_ + delta * sample_rate_hz_ / (2.0 * PI)) / window_;
+        }
+        last_angle_ = m.angle_rad;
+        has_last_angle_ = true;
+        out.push_back(m);
+        ++produced;
+    }
+    return produced;
+}
+
+void PhasorEstimator::resync() {
+    cycles_since_resync_ = 0;
+    for (uint32_t p = 0; p < phases_; ++p) {
+        const double* x = buffer_[p].data();
+        double re = 0.0;
+        double im = 0.0;
+        double square = 0.0;
+        for (uint32_t i = 0; i < window_; ++i) {
+            re += x[i] * cos_[i];
+            im -= x[i] * sin_[i];
+            square += x[i] * x[i];
+        }
+        re_[p] = re;
+        im_[p] = im;
+        square_sum_[p] = square;
+    }
+}
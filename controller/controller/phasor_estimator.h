@@ -0,0 +1,59 @@
+// phasor_estimator.h
+#ifndef PHASOR_ESTIMATOR_H
+#define PHASOR_ESTIMATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 逐周波相量测量结果
+struct PhasorMeasurement {
+    size_t frame;                   // 周波结束时的帧序号（本次输入块内，从0计）
+    double rms[3];                  // 各相电压真有效值（一个周波）
+    double fundamental_rms;         // 正序基波有效值
+    double angle_rad;               // 正序基波相角（相对窗口起点）
+    double frequency_hz;            // 基波频率，首个周波为NaN
+};
+
+// 相量估计：按原始电压采样逐周波估计有效值、基波相量与频率。
+// 每相以一个周波长度的递推DFT（滑动DFT）跟踪基波分量：新样本与移出样本之差乘固定旋转因子表，
+// 每样本每相两次乘加；每隔若干周波按缓冲区重新求和，消除累积舍入误差。
+// 三相时取正序相量（抑制偏离额定频率时单相窗口泄漏引起的相角波动），
+// 频率由相邻周波的相角增量得到：f = fs/N + Δθ·fs/(2πN)。非线程安全。
+class PhasorEstimator {
+public:
+    static constexpr uint32_t MAX_PHASES = 3;
+
+    // sample_rate_hz须不低于额定频率的8倍，phases为1~3
+    PhasorEstimator(double sample_rate_hz, double nominal_frequency_hz, uint32_t phases);
+
+    bool isValid() const { return window_ > 0; }
+    uint32_t phases() const { return phases_; }
+    uint32_t window() const { return window_; }         // 每周波采样数N
+    double sampleRate() const { return sample_rate_hz_; }
+
+    // 接入交错存放的采样（每帧phases个值），每完成一个周波向out追加一条结果，返回追加条数
+    size_t process(const double* samples, size_t frames, std::vector<PhasorMeasurement>& out);
+
+private:
+    static constexpr uint32_t RESYNC_CYCLES = 64;       // 重新求和的周波间隔
+
+    void resync();                                      // 按缓冲区重新求和
+
+    double sample_rate_hz_;
+    uint32_t phases_;
+    uint32_t window_ = 0;
+    std::vector<double> cos_;                           // 旋转因子表
+    std::vector<double> sin_;
+    std::vector<double> buffer_[MAX_PHASES];            // 最近一个周波的采样
+    double re_[MAX_PHASES] = {};                        // 基波DFT实部
+    double im_[MAX_PHASES] = {};                        // 基波DFT虚部
+    double square_sum_[MAX_PHASES] = {};                // 平方和
+    uint32_t position_ = 0;                             // 窗口内位置
+    uint64_t filled_ = 0;                               // 已接入帧数（判断首个周波是否已满）
+    uint32_t cycles_since_resync_ = 0;
+    double last_angle_ = 0.0;
+    bool has_last_angle_ = false;
+};
+
+#endif // PHASOR_ESTIMATOR_H
@@ -0,0 +1,180 @@
+// power_quality.cpp
+#include "power_quality.h"
+#include <algorithm>
+#include <cmath>
+
+VoltageEventDetector::VoltageEventDetector(double sample_rate_hz, double nominal_frequency_hz, uint32_t phases,
+                                           double declared_voltage, const VoltageEventThresholds& thresholds)
+    : phases_(phases), thresholds_(thresholds) {
+    if (!(nominal_frequency_hz > 0.0) || !(sample_rate_hz >= 8.0 * nominal_frequency_hz) ||
+        !(declared_voltage > 0.0) || phases == 0 || phases > MAX_PHASES) {
+        return; // 参数无效，isValid()为false
+    }
+    window_ = static_cast<uint32_t>(std::lround(sample_rate_hz / nominal_frequency_hz));
+    half_window_ = window_ / 2;
+    inverse_declared_square_ = 1.0 / (declared_voltage * declared_voltage * window_);
+    for (uint32_t p = 0; p < phases_; ++p) {
+        buffer_[p].assign(window_, 0.0);
+        last_rms_pu_[p] = 1.0;
+    }
+}
+
+size_t VoltageEventDetector::process(const double* samples, size_t frames, std::vector<VoltageEvent>& out) {
+    if (!isValid() || samples == nullptr) {
+        return 0;
+    }
+    size_t before = out.size();
+    for (size_t frame = 0; frame < frames; ++frame) {
+        const double* x = samples + frame * phases_;
+        uint32_t i = position_;
+        for (uint32_t p = 0; p < phases_; ++p) {
+            double old = buffer_[p][i];
+            buffer_[p][i] = x[p];
+            square_sum_[p] += x[p] * x[p] - old * old;
+        }
+        position_ = position_ + 1 == window_ ? 0 : position_ + 1;
+        ++frames_;
+        if (++since_refresh_ < half_window_) {
+            continue;
+        }
+        since_refresh_ = 0;
+        if (frames_ < window_) {
+            continue; // 首个周波未满
+        }
+        // 定期按缓冲区重新求和，消除累积舍入误差
+        if (++refreshes_since_resync_ >= 2 * RESYNC_CYCLES) {
+            refreshes_since_resync_ = 0;
+            for (uint32_t p = 0; p < phases_; ++p) {
+                double square = 0.0;
+                for (double v : buffer_[p]) {
+                    square += v * v;
+                }
+                square_sum_[p] = square;
+            }
+        }
+        for (uint32_t p = 0; p < phases_; ++p) {
+            last_rms_pu_[p] = std::sqrt(std::max(0.0, square_sum_[p]) * inverse_declared_square_);
+        }
+        evaluate(frame, out);
+    }
+    return out.size() - before;
+}
+
+size_t VoltageEventDetector::finish(std::vector<VoltageEvent>& out) {
+    size_t before = out.size();
+    if (dip_.active) {
+        out.push_back(VoltageEvent{VoltageEventType::DIP, VoltageEventPhase::END, 0,
+                                   frames_ - dip_.start_frame, dip_.magnitude_pu, dip_.phase_mask});
+        dip_.active = false;
+    }
+    if (swell_.active) {
+        out.push_back(VoltageEvent{VoltageEventType::SWELL, VoltageEventPhase::END, 0,
+                                   frames_ - swell_.start_frame, swell_.magnitude_pu, swell_.phase_mask});
+        swell_.active = false;
+    }
+    return out.size() - before;
+}
+
+// 多相合并判定（每半周波一次）
+void VoltageEventDetector::evaluate(size_t frame, std::vector<VoltageEvent>& out) {
+    double low = last_rms_pu_[0];
+    double high = last_rms_pu_[0];
+    uint8_t below = 0;
+    uint8_t above = 0;
+    for (uint32_t p = 0; p < phases_; ++p) {
+        low = std::min(low, last_rms_pu_[p]);
+        high = std::max(high, last_rms_pu_[p]);
+        below |= static_cast<uint8_t>((last_rms_pu_[p] <= thresholds_.dip ? 1u : 0u) << p);
+        above |= static_cast<uint8_t>((last_rms_pu_[p] >= thresholds_.swell ? 1u : 0u) << p);
+    }
+
+    // 暂降：任一相低于门限开始，全部相高于门限加回差结束
+    if (!dip_.active) {
+        if (below != 0) {
+            dip_ = ActiveEvent{true, frames_, low, below, dipSeverity(low)};
+            out.push_back(VoltageEvent{VoltageEventType::DIP, VoltageEventPhase::START, frame, 0, low, below});
+        }
+    } else if (low >= thresholds_.dip + thresholds_.hysteresis) {
+        out.push_back(VoltageEvent{VoltageEventType::DIP, VoltageEventPhase::END, frame,
+                                   frames_ - dip_.start_frame, dip_.magnitude_pu, dip_.phase_mask});
+        dip_.active = false;
+    } else {
+        dip_.magnitude_pu = std::min(dip_.magnitude_pu, low);
+        dip_.phase_mask |= below;
+        int severity = dipSeverity(dip_.magnitude_pu);
+        if (severity > dip_.severity) {
+            dip_.severity = severity;
+            out.push_back(VoltageEvent{VoltageEventType::DIP, VoltageEventPhase::DEEPEN, frame, 0,
+                                       dip_.magnitude_pu, dip_.phase_mask});
+        }
+    }
+
+    // 暂升：任一相高于门限开始，全部相低于门限减回差结束
+    if (!swell_.active) {
+        if (above != 0) {
+            swell_ = ActiveEvent{true, frames_, high, above, swellSeverity(high)};
+            out.push_back(VoltageEvent{VoltageEventType::SWELL, VoltageEventPhase::START, frame, 0, high, above});
+        }
+    } else if (high <= thresholds_.swell - thresholds_.hysteresis) {
+        out.push_back(VoltageEvent{VoltageEventType::SWELL, VoltageEventPhase::END, frame,
+                                   frames_ - swell_.start_frame, swell_.magnitude_pu, swell_.phase_mask});
+        swell_.active = false;
+    } else {
+        swell_.magnitude_pu = std::max(swell_.magnitude_pu, high);
+        swell_.phase_mask |= above;
+        int severity = swellSeverity(swell_.magnitude_pu);
+        if (severity > swell_.severity) {
+            swell_.severity = severity;
+            out.push_back(VoltageEvent{VoltageEventType::SWELL, VoltageEventPhase::DEEPEN, frame, 0,
+                                       swell_.magnitude_pu, swell_.phase_mask});
+        }
+    }
+}
+
+// 幅值等级：1为一般级，2为事故级（残余电压低于70%或中断）
+int VoltageEventDetector::dipSeverity(double residual_pu) const {
+    return residual_pu < thresholds_.interruption ? 3 : residual_pu < 0.7 ? 2 : 1;
+}
+
+int VoltageEventDetector::swellSeverity(double magnitude_pu) const {
+    return magnitude_pu >= 1.2 ? 2 : 1;
+}
+
+const char* dipDepthClass(double residual_pu) {
+    if (residual_pu >= 0.8) {
+        return "90%~80%";
+    }
+    if (residual_pu >= 0.7) {
+        return "80%~70%";
+    }
+    if (residual_pu >= 0.4) {
+        return "70%~40%";
+    }
+    if (residual_pu >= 0.05) {
+        return "40%~5%";
+    }
+    return "<5%(中断)";
+}
+
+const char* swellMagnitudeClass(double magnitude_pu) {
+    return magnitude_pu >= 1.2 ? ">=120%" : "110%~120%";
+}
+
+const char* eventDurationClass(double duration_ms) {
+    if (duration_ms <= 200) {
+        return "10~200ms";
+    }
+    if (duration_ms <= 500) {
+        return "200~500ms";
+    }
+    if (duration_ms <= 1000) {
+        return "0.5~1s";
+    }
+    if (duration_ms <= 5000) {
+        return "1~5s";
+    }
+    if (duration_ms <= 60000) {
+        return "5~60s";
+    }
+    return ">60s";
+}
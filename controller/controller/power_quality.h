@@ -0,0 +1,100 @@
+// power_quality.h
+#ifndef POWER_QUALITY_H
+#define POWER_QUALITY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 电压事件类型
+enum class VoltageEventType : uint8_t {
+    DIP,        // 电压暂降（残余电压低于中断门限时为短时中断）
+    SWELL       // 电压暂升
+};
+
+// 电压事件进展
+enum class VoltageEventPhase : uint8_t {
+    START,      // 事件开始
+    DEEPEN,     // 幅值进入更严重的等级
+    END         // 事件结束
+};
+
+// 电压事件记录（幅值均为相对声明电压的标幺值）
+struct VoltageEvent {
+    VoltageEventType type;
+    VoltageEventPhase phase;
+    size_t frame;               // 本次输入块内的帧序号（START/DEEPEN为越限半周波结束处，END为恢复处）
+    uint64_t duration_frames;   // 持续帧数（END有效）
+    double magnitude_pu;        // 暂降为最低残余电压，暂升为最高电压
+    uint8_t phase_mask;         // 越限过的相（第i位对应第i相）
+};
+
+// 电压事件门限（IEC 61000-4-30默认值）
+struct VoltageEventThresholds {
+    double dip = 0.90;          // 暂降开始门限
+    double swell = 1.10;        // 暂升开始门限
+    double interruption = 0.05; // 短时中断门限
+    double hysteresis = 0.02;   // 结束回差
+};
+
+// 半周波电压事件检测：按IEC 61000-4-30的Urms(1/2)（一个周波窗口、每半个周波刷新）
+// 逐相计算有效值，多相合并判定：任一相越限即开始，全部相回到门限加回差以内才结束，
+// 起止时刻精确到半个周波。每样本每相一次乘加，每半周波每相一次开方。非线程安全。
+class VoltageEventDetector {
+public:
+    static constexpr uint32_t MAX_PHASES = 3;
+
+    // 参数要求与PhasorEstimator相同；declared_voltage为声明电压（相电压有效值）
+    VoltageEventDetector(double sample_rate_hz, double nominal_frequency_hz, uint32_t phases,
+                         double declared_voltage, const VoltageEventThresholds& thresholds = {});
+
+    bool isValid() const { return half_window_ > 0; }
+
+    // 接入交错存放的采样（每帧phases个值），事件追加到out，返回追加条数
+    size_t process(const double* samples, size_t frames, std::vector<VoltageEvent>& out);
+
+    // 结束进行中的事件（检测器被替换前调用）：END的frame为0，持续时间截至已接入的帧，返回追加条数
+    size_t finish(std::vector<VoltageEvent>& out);
+
+    // 最近一次Urms(1/2)（标幺值）
+    double halfCycleRms(uint32_t phase) const { return last_rms_pu_[phase]; }
+
+private:
+    static constexpr uint32_t RESYNC_CYCLES = 64;
+
+    struct ActiveEvent {
+        bool active = false;
+        uint64_t start_frame = 0;
+        double magnitude_pu = 0.0;
+        uint8_t phase_mask = 0;
+        int severity = 0;       // 当前幅值等级，加深时上报DEEPEN
+    };
+
+    void evaluate(size_t frame, std::vector<VoltageEvent>& out);
+    int dipSeverity(double residual_pu) const;
+    int swellSeverity(double magnitude_pu) const;
+
+    uint32_t phases_;
+    uint32_t window_ = 0;                       // 每周波采样数
+    uint32_t half_window_ = 0;
+    double inverse_declared_square_ = 0.0;      // 1/(Udin²·N)，平方和直接换算为标幺值平方
+    VoltageEventThresholds thresholds_;
+    std::vector<double> buffer_[MAX_PHASES];
+    double square_sum_[MAX_PHASES] = {};
+    double last_rms_pu_[MAX_PHASES] = {};
+    uint32_t position_ = 0;
+    uint32_t since_refresh_ = 0;
+    uint32_t refreshes_since_resync_ = 0;
+    uint64_t frames_ = 0;                       // 已接入帧数
+    ActiveEvent dip_;
+    ActiveEvent swell_;
+};
+
+// 电压暂降按残余电压分档（EN 50160表格行）
+const char* dipDepthClass(double residual_pu);
+// 电压暂升按幅值分档
+const char* swellMagnitudeClass(double magnitude_pu);
+// 事件按持续时间分档（EN 50160表格列）
+const char* eventDurationClass(double duration_ms);
+
+#endif // POWER_QUALITY_H
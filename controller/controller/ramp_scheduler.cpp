@@ -0,0 +1,153 @@
+// ramp_scheduler.cpp
+#include "ramp_scheduler.h"
+#include <algorithm>
+
+RampScheduler::RampScheduler() = default;
+
+RampScheduler::~RampScheduler() {
+    stop();
+}
+
+// 启动定时线程
+void RampScheduler::start(SetpointCallback on_setpoint, CompletionCallback on_complete) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    on_setpoint_ = std::move(on_setpoint);
+    on_complete_ = std::move(on_complete);
+    running_ = true;
+    worker_ = std::thread(&RampScheduler::run, this);
+}
+
+// 停止定时线程
+void RampScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    cv_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+// 开始爬坡
+void RampScheduler::startRamp(DeviceIndex device, uint64_t tag, double from_kw, double target_kw,
+                              double step_kw, std::chrono::milliseconds step_interval) {
+    RampState state;
+    state.device = device;
+    state.tag = tag;
+    state.current_kw = std::min(from_kw, target_kw);
+    state.target_kw = target_kw;
+    state.step_kw = std::max(step_kw, 1e-9);
+    state.step_interval = std::max(step_interval, std::chrono::milliseconds(1));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t generation = next_generation_++;
+        state.generation = generation;
+        ramps_[device] = Entry{state, generation};
+        deadlines_.push(Deadline{std::chrono::steady_clock::now(), device, generation});
+    }
+    cv_.notify_one();
+}
+
+// 取消爬坡：仅删除状态，堆中的过期截止项在出堆时丢弃
+bool RampScheduler::cancel(DeviceIndex device) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ramps_.erase(device) != 0;
+}
+
+bool RampScheduler::isCurrent(DeviceIndex device, uint64_t generation) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = ramps_.find(device);
+    return it != ramps_.end() && it->second.generation == generation;
+}
+
+bool RampScheduler::isRamping(DeviceIndex device) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ramps_.count(device) != 0;
+}
+
+size_t RampScheduler::activeCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ramps_.size();
+}
+
+std::vector<RampState> RampScheduler::snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<RampState> states;
+    states.reserve(ramps_.size());
+    for (const auto& item : ramps_) {
+        states.push_back(item.second.state);
+    }
+    return states;
+}
+
+// 定时线程：取出全部到期步骤，释放锁后再执行回调。
+// 完成的爬坡在设定值投递后才移除，投递期间仍可被取消（取消后不再通知完成）
+void RampScheduler::run() {
+    std::vector<RampState> steps;      // 本轮下发的设定值
+    std::vector<RampState> completed;  // 本轮完成的爬坡
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        if (deadlines_.empty()) {
+            cv_.wait(lock, [this]() { return !running_ || !deadlines_.empty(); });
+            continue;
+        }
+        auto next = deadlines_.top().when;
+        if (std::chrono::steady_clock::now() < next) {
+            cv_.wait_until(lock, next);
+            continue; // 重新检查：可能有更早的截止项或停止请求
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        while (!deadlines_.empty() && deadlines_.top().when <= now) {
+            Deadline due = deadlines_.top();
+            deadlines_.pop();
+            auto it = ramps_.find(due.device);
+            if (it == ramps_.end() || it->second.generation != due.generation) {
+                continue; // 已取消或已被新的爬坡替换
+            }
+            RampState& state = it->second.state;
+            state.current_kw = std::min(state.current_kw + state.step_kw, state.target_kw);
+            steps.push_back(state);
+            if (state.current_kw >= state.target_kw) {
+                completed.push_back(state); // 目标值已随本步下发
+                continue;
+            }
+            deadlines_.push(Deadline{due.when + state.step_interval, due.device, due.generation});
+        }
+
+        lock.unlock();
+        if (on_setpoint_ && !steps.empty()) {
+            on_setpoint_(steps);
+        }
+        steps.clear();
+        lock.lock();
+        if (completed.empty()) {
+            continue;
+        }
+        size_t kept = 0;
+        for (const RampState& ramp : completed) {
+            auto it = ramps_.find(ramp.device);
+            if (it != ramps_.end() && it->second.generation == ramp.generation) {
+                ramps_.erase(it);
+                completed[kept++] = ramp;
+            }
+        }
+        completed.resize(kept);
+        lock.unlock();
+        for (const RampState& ramp : completed) {
+            if (on_complete_) {
+                on_complete_(ramp);
+            }
+        }
+        completed.clear();
+        lock.lock();
+    }
+}
@@ -0,0 +1,89 @@
+// ramp_scheduler.h
+#ifndef RAMP_SCHEDULER_H
+#define RAMP_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "device_registry.h"
+
+// 功率爬坡状态
+struct RampState {
+    DeviceIndex device;         // 设备索引
+    uint64_t tag;               // 调用方附带的标识（如触发恢复的异常键）
+    uint64_t generation;        // 调度器分配的爬坡代次（取消或替换后失效）
+    double current_kw;          // 最近下发的设定功率(kW)
+    double target_kw;           // 目标功率(kW)
+    double step_kw;             // 每步增量(kW)
+    std::chrono::milliseconds step_interval; // 步长间隔
+};
+
+// 异步爬坡调度器：单个定时线程按截止时间驱动任意数量的并发爬坡，
+// 回调在调度器锁之外执行，不占用监测线程，也不持有异常数据锁。
+class RampScheduler {
+public:
+    // 每轮到期的全部设定值一次下发，step.current_kw为本次设定值
+    using SetpointCallback = std::function<void(const std::vector<RampState>& steps)>;
+    using CompletionCallback = std::function<void(const RampState& ramp)>;
+
+    RampScheduler();
+    ~RampScheduler();
+    RampScheduler(const RampScheduler&) = delete;
+    RampScheduler& operator=(const RampScheduler&) = delete;
+
+    // 启动定时线程
+    void start(SetpointCallback on_setpoint, CompletionCallback on_complete);
+    // 停止定时线程（未完成的爬坡保持原状）
+    void stop();
+
+    // 开始爬坡，同一设备已有爬坡时替换。from_kw视为已下发的设定，首步（from_kw加一步）立即下发，
+    // 每个设定值只下发一次，到达目标值的一步即为完成
+    void startRamp(DeviceIndex device, uint64_t tag, double from_kw, double target_kw,
+                   double step_kw, std::chrono::milliseconds step_interval);
+
+    // 取消爬坡（异常重现时调用），存在并已取消返回true
+    bool cancel(DeviceIndex device);
+
+    // 爬坡是否仍有效（未取消、未被替换）：回调方在与cancel()相同的锁内检查，丢弃投递途中被取消的设定值
+    bool isCurrent(DeviceIndex device, uint64_t generation) const;
+
+    bool isRamping(DeviceIndex device) const;
+    size_t activeCount() const;
+
+    // 当前全部爬坡状态（用于状态导出）
+    std::vector<RampState> snapshot() const;
+
+private:
+    struct Deadline {
+        std::chrono::steady_clock::time_point when;
+        DeviceIndex device;
+        uint64_t generation;    // 与爬坡代次不符即为已取消/替换的过期项
+        bool operator>(const Deadline& other) const { return when > other.when; }
+    };
+    struct Entry {
+        RampState state;
+        uint64_t generation;
+    };
+
+    void run();
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::unordered_map<DeviceIndex, Entry> ramps_;
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> deadlines_;
+    uint64_t next_generation_ = 1;
+    bool running_ = false;
+    std::thread worker_;
+
+    SetpointCallback on_setpoint_;
+    CompletionCallback on_complete_;
+};
+
+#endif // RAMP_SCHEDULER_H
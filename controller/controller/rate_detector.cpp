@@ -0,0 +1,110 @@
+// rate_detector.cpp
+#include "rate_detector.h"
+#include "bit_ops.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr double NO_RATE = std::numeric_limits<double>::quiet_NaN();
+
+} // namespace
+
+std::vector<RateDetectorSpec> builtinRateDetectors() {
+    return {
+        // 频率变化率：200ms窗口，100ms滤波（与常用ROCOF保护的测量窗口相当）
+        {DeviceClass::GRID, TelemetryChannel::GRID_FREQUENCY, TelemetryChannel::GRID_ROCOF, 200, 100},
+        // 氢罐压力变化率：压力变化较慢且测量噪声大，2s窗口，1s滤波
+        {DeviceClass::HYDROGEN_SYSTEM, TelemetryChannel::HYDROGEN_TANK_PRESSURE,
+         TelemetryChannel::HYDROGEN_PRESSURE_RATE, 2000, 1000},
+    };
+}
+
+RateOfChangeDetector::RateOfChangeDetector(const RateDetectorSpec& spec)
+    : spec_(spec),
+      window_us_(std::max<int64_t>(1, spec.window_ms) * 1000),
+      spacing_us_(std::max<int64_t>(1, window_us_ / 4)),
+      filter_us_(std::max<int64_t>(0, spec.filter_ms) * 1000) {}
+
+void RateOfChangeDetector::allocate(size_t rows) {
+    states_.assign(rows, RowState{});
+    for (RowState& state : states_) {
+        reset(state);
+    }
+}
+
+void RateOfChangeDetector::reset(RowState& state) {
+    state.head = 0;
+    state.count = 0;
+    state.last_time_us = std::numeric_limits<int64_t>::min();
+    state.last_value = NO_RATE;
+    state.rate = NO_RATE;
+}
+
+double RateOfChangeDetector::update(size_t row, int64_t time_us, double value) {
+    RowState& state = states_[row];
+    if (std::isnan(value) || time_us <= state.last_time_us) {
+        return state.rate; // 无数据或乱序
+    }
+    if (state.count > 0 && time_us - state.last_time_us > 2 * window_us_) {
+        reset(state); // 数据中断，重新累积
+    }
+
+    // 丢弃过旧的锚点，保留距今不少于一个窗口的最近锚点作为差分起点
+    while (state.count >= 2 &&
+           time_us - state.anchors[(state.head + 1) % ANCHOR_COUNT].time_us >= window_us_) {
+        state.head = (state.head + 1) % ANCHOR_COUNT;
+        --state.count;
+    }
+
+    double raw = NO_RATE;
+    if (state.count > 0) {
+        const Anchor& origin = state.anchors[state.head];
+        int64_t span_us = time_us - origin.time_us;
+        if (span_us >= window_us_ / 2) {
+            raw = (value - origin.value) * 1e6 / static_cast<double>(span_us);
+        }
+    }
+
+    // 按1/4窗口间隔追加锚点
+    const Anchor* newest = state.count > 0 ?
+        &state.anchors[(state.head + state.count - 1) % ANCHOR_COUNT] : nullptr;
+    if (newest == nullptr || time_us - newest->time_us >= spacing_us_) {
+        if (state.count == ANCHOR_COUNT) {
+            state.head = (state.head + 1) % ANCHOR_COUNT;
+            --state.count;
+        }
+        state.anchors[(state.head + state.count) % ANCHOR_COUNT] = Anchor{time_us, value};
+        ++state.count;
+    }
+
+    // 一阶低通滤波：系数按实际样本间隔计算，采样不均匀时时间常数不变
+    if (!std::isnan(raw)) {
+        if (std::isnan(state.rate) || filter_us_ == 0) {
+            state.rate = raw;
+        } else {
+            double dt = static_cast<double>(time_us - state.last_time_us);
+            state.rate += dt / (static_cast<double>(filter_us_) + dt) * (raw - state.rate);
+        }
+    }
+    state.last_time_us = time_us;
+    state.last_value = value;
+    return state.rate;
+}
+
+void RateOfChangeDetector::updateColumn(const double* values, const int64_t* times, const uint64_t* changed,
+                                        double* rates, uint64_t* output_changed, size_t rows) {
+    // 只接入真实采集时间的样本：以扫描时刻补点会与采集时间混用，低采样率下产生虚假斜率
+    for (size_t w = 0; w < (rows + 63) / 64; ++w) {
+        for (uint64_t bits = changed[w]; bits != 0; bits &= bits - 1) {
+            unsigned bit = lowestSetBit(bits);
+            size_t row = w * 64 + bit;
+            double rate = update(row, times[row], values[row]);
+            if (rate != rates[row] && !(std::isnan(rate) && std::isnan(rates[row]))) {
+                rates[row] = rate;
+                output_changed[w] |= 1ull << bit;
+            }
+        }
+    }
+}
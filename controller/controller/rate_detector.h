@@ -0,0 +1,70 @@
+// rate_detector.h
+#ifndef RATE_DETECTOR_H
+#define RATE_DETECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "device_registry.h"
+
+// 变化率检测器定义：由源通道计算派生通道
+struct RateDetectorSpec {
+    DeviceClass device_class;       // 适用设备类别
+    TelemetryChannel source;        // 源通道
+    TelemetryChannel output;        // 派生通道（单位：源通道单位/秒）
+    int32_t window_ms;              // 差分窗口(ms)：取约一个窗口之前的点求斜率
+    int32_t filter_ms;              // 一阶低通滤波时间常数(ms)，0为不滤波
+};
+
+// 内置变化率检测器：频率变化率(ROCOF)、氢罐压力变化率
+std::vector<RateDetectorSpec> builtinRateDetectors();
+
+// 流式变化率估计：每台设备保存按1/4窗口间隔抽取的少量锚点，
+// 新样本与约一个窗口之前的锚点求斜率后经一阶低通滤波输出。
+// 每个样本O(1)，内存与采样率无关；数据不足半个窗口或中断超过两个窗口时输出NaN（不越限）。
+// 非线程安全，仅监测线程使用。
+class RateOfChangeDetector {
+public:
+    explicit RateOfChangeDetector(const RateDetectorSpec& spec);
+
+    // 按设备行数分配状态
+    void allocate(size_t rows);
+
+    // 接入单个样本（时间戳us），返回滤波后的变化率；早于上一样本的乱序样本被忽略
+    double update(size_t row, int64_t time_us, double value);
+
+    // 接入整列快照：仅本轮有写入的设备（changed位图）按其采集时间接入，结果写入rates对应行，
+    // 结果有变化的设备在output_changed位图中置位；已由带时间戳样本接入的同一时刻不会重复接入
+    void updateColumn(const double* values, const int64_t* times, const uint64_t* changed,
+                      double* rates, uint64_t* output_changed, size_t rows);
+
+    double rate(size_t row) const { return states_[row].rate; }
+    const RateDetectorSpec& spec() const { return spec_; }
+
+private:
+    static constexpr uint32_t ANCHOR_COUNT = 8;
+
+    struct Anchor {
+        int64_t time_us;
+        double value;
+    };
+
+    struct RowState {
+        Anchor anchors[ANCHOR_COUNT];   // 锚点环形缓冲
+        uint32_t head;                  // 最早锚点位置
+        uint32_t count;                 // 锚点数
+        int64_t last_time_us;           // 最近样本时间
+        double last_value;              // 最近样本值
+        double rate;                    // 滤波后的变化率
+    };
+
+    void reset(RowState& state);
+
+    RateDetectorSpec spec_;
+    int64_t window_us_;
+    int64_t spacing_us_;                // 锚点最小间隔（1/4窗口）
+    int64_t filter_us_;
+    std::vector<RowState> states_;
+};
+
+#endif // RATE_DETECTOR_H
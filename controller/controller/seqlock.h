@@ -0,0 +1,109 @@
+// seqlock.h
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+// 自旋若干次后让出CPU，避免写者被抢占时读者空转整个时间片
+constexpr uint32_t SEQLOCK_SPIN_LIMIT = 64;
+
+inline void seqBackoff(uint32_t& spins) {
+    if (++spins >= SEQLOCK_SPIN_LIMIT) {
+        spins = 0;
+        std::this_thread::yield();
+    }
+}
+
+// 顺序锁(seqlock)基础操作
+// 写者：序号由偶数改为奇数 -> 写数据 -> 序号加一恢复偶数，从不等待读者；
+// 读者：读取前后序号一致且为偶数即得到一致快照，否则重试，从不阻塞写者。
+// 多个写者写同一对象时通过CAS互斥（仅写者之间短暂自旋）。
+// 被保护数据须以relaxed原子方式读写，以满足C++内存模型。
+
+// 开始写：返回写入前的序号（偶数）
+inline uint32_t seqWriteBegin(std::atomic<uint32_t>& seq) {
+    uint32_t s = seq.load(std::memory_order_relaxed);
+    uint32_t spins = 0;
+    for (;;) {
+        if ((s & 1u) == 0 &&
+            seq.compare_exchange_weak(s, s + 1, std::memory_order_relaxed)) {
+            break;
+        }
+        seqBackoff(spins); // 其他写者正在写，重试
+        s = seq.load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release); // 序号先于数据可见
+    return s;
+}
+
+// 结束写：发布新的偶数序号
+inline void seqWriteEnd(std::atomic<uint32_t>& seq, uint32_t begin_value) {
+    seq.store(begin_value + 2, std::memory_order_release);
+}
+
+// 开始读：返回当前序号，奇数表示写入进行中
+inline uint32_t seqReadBegin(const std::atomic<uint32_t>& seq) {
+    return seq.load(std::memory_order_acquire);
+}
+
+// 结束读：快照一致返回true
+inline bool seqReadValidate(const std::atomic<uint32_t>& seq, uint32_t begin_value) {
+    std::atomic_thread_fence(std::memory_order_acquire); // 数据读取先于序号复查
+    return (begin_value & 1u) == 0 && seq.load(std::memory_order_relaxed) == begin_value;
+}
+
+// 单对象顺序锁：适用于可平凡复制的状态结构体
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock要求可平凡复制的类型");
+
+public:
+    SeqLock() : seq_(0) {
+        for (auto& w : words_) {
+            w.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // 发布新值（等待自由，单写者时无自旋）
+    void store(const T& value) {
+        uint64_t buffer[WORD_COUNT] = {};
+        std::memcpy(buffer, &value, sizeof(T));
+        uint32_t s = seqWriteBegin(seq_);
+        for (size_t i = 0; i < WORD_COUNT; ++i) {
+            words_[i].store(buffer[i], std::memory_order_relaxed);
+        }
+        seqWriteEnd(seq_, s);
+    }
+
+    // 读取一致快照，返回重试次数
+    uint32_t load(T& out) const {
+        uint64_t buffer[WORD_COUNT];
+        uint32_t retries = 0;
+        uint32_t spins = 0;
+        for (;;) {
+            uint32_t s = seqReadBegin(seq_);
+            for (size_t i = 0; i < WORD_COUNT; ++i) {
+                buffer[i] = words_[i].load(std::memory_order_relaxed);
+            }
+            if (seqReadValidate(seq_, s)) {
+                break;
+            }
+            ++retries;
+            seqBackoff(spins);
+        }
+        std::memcpy(&out, buffer, sizeof(T));
+        return retries;
+    }
+
+private:
+    static constexpr size_t WORD_COUNT = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    alignas(64) std::atomic<uint32_t> seq_;
+    std::atomic<uint64_t> words_[WORD_COUNT];
+};
+
+#endif // SEQLOCK_H
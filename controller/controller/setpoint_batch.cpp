@@ -0,0 +1,29 @@
+// setpoint_batch.cpp
+#include "setpoint_batch.h"
+
+int SetpointBatch::precedence(const ControllerEvent& setpoint) {
+    if (setpoint.type == AnomalyType::SAFETY_FAULT && setpoint.level != AnomalyLevel::INFO) {
+        return 3; // 安全异常处置（恢复爬坡为提示级，不占安全优先级）
+    }
+    switch (setpoint.level) {
+        case AnomalyLevel::CRITICAL: return 2;
+        case AnomalyLevel::WARNING: return 1;
+        default: return 0;
+    }
+}
+
+bool SetpointBatch::add(const ControllerEvent& setpoint, const std::string& target) {
+    int rank = precedence(setpoint);
+    auto inserted = index_.emplace(std::string_view(target), static_cast<uint32_t>(entries_.size()));
+    if (inserted.second) {
+        entries_.push_back(Entry{&target, rank, setpoint});
+        return false;
+    }
+    Entry& entry = entries_[inserted.first->second];
+    if (rank > entry.precedence ||
+        (rank == entry.precedence && setpoint.power_kw < entry.event.power_kw)) {
+        entry.precedence = rank;
+        entry.event = setpoint;
+    }
+    return true;
+}
@@ -0,0 +1,48 @@
+// setpoint_batch.h
+#ifndef SETPOINT_BATCH_H
+#define SETPOINT_BATCH_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "controller_event.h"
+
+// 一个周期（一轮扫描或一次爬坡调度）内的功率设定批次：同一控制目标只保留一条。
+// 合并优先级：安全异常 > 事故级 > 一般级 > 提示级（含恢复爬坡），同优先级取较低的设定功率。
+// 按控制目标索引条目，加入一条为O(1)，整批设备同时爬坡时构建批次为线性代价
+class SetpointBatch {
+public:
+    static int precedence(const ControllerEvent& setpoint);
+
+    // 加入一条SETPOINT事件，target为设备的控制目标（须在批次存续期间有效）；
+    // 与同一目标的已有设定合并时返回true
+    bool add(const ControllerEvent& setpoint, const std::string& target);
+
+    bool empty() const { return entries_.empty(); }
+    size_t size() const { return entries_.size(); }
+    const ControllerEvent& at(size_t i) const { return entries_[i].event; }
+    const std::string& target(size_t i) const { return *entries_[i].target; }
+
+    void clear() { // 保留容量
+        entries_.clear();
+        index_.clear();
+    }
+    void swap(SetpointBatch& other) {
+        entries_.swap(other.entries_);
+        index_.swap(other.index_);
+    }
+
+private:
+    struct Entry {
+        const std::string* target;
+        int precedence;
+        ControllerEvent event;
+    };
+    std::vector<Entry> entries_;
+    // 控制目标 -> 条目下标；多台设备可共用同一目标名称（各自的字符串对象），按内容而非地址索引
+    std::unordered_map<std::string_view, uint32_t> index_;
+};
+
+#endif // SETPOINT_BATCH_H
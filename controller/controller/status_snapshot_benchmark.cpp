@@ -0,0 +1,191 @@
+// status_snapshot_benchmark.cpp
+// 状态快照基准测试：比较互斥锁复制与顺序锁快照在读写竞争下的吞吐量
+// 用法: status_snapshot_benchmark [写线程数=2] [每项持续毫秒=1000] [设备数=10000]
+#include "anomaly_monitoring_controller.h"
+#include "seqlock.h"
+#include "telemetry_store.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct BenchResult {
+    double writer_ops_per_sec;  // 写者总吞吐(次/秒)
+    double reader_ops_per_sec;  // 读者吞吐(次/秒)
+    uint64_t reader_retries;    // 读者重试次数
+};
+
+// 通用驱动：writers个线程循环执行write(id, i)，一个读线程循环执行read()
+template <typename WriteFn, typename ReadFn>
+BenchResult runContention(int writers, int duration_ms, WriteFn write, ReadFn read) {
+    std::atomic<bool> start(false);
+    std::atomic<bool> stop(false);
+    std::vector<uint64_t> writer_counts(writers, 0);
+    uint64_t reader_count = 0;
+    uint64_t retries = 0;
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < writers; ++w) {
+        threads.emplace_back([&, w]() {
+            while (!start.load(std::memory_order_acquire)) {}
+            uint64_t n = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                write(w, n);
+                ++n;
+            }
+            writer_counts[w] = n;
+        });
+    }
+    threads.emplace_back([&]() {
+        while (!start.load(std::memory_order_acquire)) {}
+        uint64_t n = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            retries += read();
+            ++n;
+        }
+        reader_count = n;
+    });
+
+    auto t0 = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& t : threads) {
+        t.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    uint64_t writes = 0;
+    for (uint64_t c : writer_counts) {
+        writes += c;
+    }
+    return BenchResult{writes / seconds, reader_count / seconds, retries};
+}
+
+SystemStatus makeStatus(uint64_t n) {
+    SystemStatus s{};
+    s.pv_power = 80.0 + (n & 7);
+    s.wind_power = 60.0;
+    s.ess_power = 40.0;
+    s.hydrogen_power = 20.0;
+    s.grid_voltage = 220.0;
+    s.grid_frequency = 50.0;
+    s.hydrogen_concentration = 0.5;
+    s.hydrogen_tank_pressure = 1.0;
+    return s;
+}
+
+void printResult(const char* name, const BenchResult& r) {
+    std::cout << std::left << std::setw(36) << name
+              << " 写入: " << std::setw(14) << std::fixed << std::setprecision(0) << r.writer_ops_per_sec
+              << " 次/秒  读取: " << std::setw(12) << r.reader_ops_per_sec
+              << " 次/秒  读重试: " << r.reader_retries << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int writers = argc > 1 ? std::atoi(argv[1]) : 2;
+    int duration_ms = argc > 2 ? std::atoi(argv[2]) : 1000;
+    size_t devices = argc > 3 ? static_cast<size_t>(std::atoll(argv[3])) : 10000;
+
+    std::cout << "写线程: " << writers << ", 每项持续: " << duration_ms
+              << " ms, 设备数: " << devices << std::endl;
+
+    // 1. 单站状态：互斥锁 + 整体复制（原updateSystemStatus/checkAnomalies方式，
+    //    每轮扫描另为每个活动异常复制一次，此处按4个活动异常计）
+    {
+        std::mutex mutex;
+        SystemStatus shared = makeStatus(0);
+        auto r = runContention(writers, duration_ms,
+            [&](int, uint64_t n) {
+                SystemStatus s = makeStatus(n);
+                std::lock_guard<std::mutex> lock(mutex);
+                shared = s;
+            },
+            [&]() -> uint64_t {
+                for (int k = 0; k < 5; ++k) {
+                    SystemStatus copy;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        copy = shared;
+                    }
+                    (void)copy;
+                }
+                return 0;
+            });
+        printResult("单站状态 / 互斥锁(每轮5次复制)", r);
+    }
+
+    // 2. 单站状态：顺序锁快照（每轮一次快照）
+    {
+        SeqLock<SystemStatus> shared;
+        auto r = runContention(writers, duration_ms,
+            [&](int, uint64_t n) { shared.store(makeStatus(n)); },
+            [&]() -> uint64_t {
+                SystemStatus copy;
+                return shared.load(copy);
+            });
+        printResult("单站状态 / 顺序锁", r);
+    }
+
+    // 3. 设备群：互斥锁 + 遥测表整表复制
+    DeviceRegistry registry;
+    for (size_t i = 0; i < devices; ++i) {
+        registry.registerDevice(DeviceClass::PV_INVERTER, "pv" + std::to_string(i), 100.0, "");
+    }
+    registry.freeze();
+    {
+        std::mutex mutex;
+        TelemetryTable shared;
+        TelemetryTable scan;
+        shared.allocate(registry);
+        scan.allocate(registry);
+        auto r = runContention(writers, duration_ms,
+            [&](int w, uint64_t n) {
+                DeviceIndex d = makeDeviceIndex(DeviceClass::PV_INVERTER,
+                                                static_cast<uint32_t>((n * 7919 + w) % devices));
+                std::lock_guard<std::mutex> lock(mutex);
+                shared.setValue(d, TelemetryChannel::POWER, static_cast<double>(n));
+                shared.setValue(d, TelemetryChannel::FAULT, 0.0);
+            },
+            [&]() -> uint64_t {
+                std::lock_guard<std::mutex> lock(mutex);
+                scan.copyFrom(shared);
+                return 0;
+            });
+        printResult("设备群 / 互斥锁整表复制", r);
+    }
+
+    // 4. 设备群：顺序锁遥测存储
+    {
+        TelemetryStore store;
+        TelemetryTable scan;
+        store.allocate(registry);
+        scan.allocate(registry);
+        auto r = runContention(writers, duration_ms,
+            [&](int w, uint64_t n) {
+                DeviceIndex d = makeDeviceIndex(DeviceClass::PV_INVERTER,
+                                                static_cast<uint32_t>((n * 7919 + w) % devices));
+                ChannelUpdate updates[] = {
+                    {TelemetryChannel::POWER, static_cast<double>(n)},
+                    {TelemetryChannel::FAULT, 0.0},
+                };
+                store.writeRow(d, updates, 2, static_cast<int64_t>(n));
+            },
+            [&]() -> uint64_t {
+                store.snapshotInto(scan);
+                return 0;
+            });
+        r.reader_retries = store.readRetries();
+        printResult("设备群 / 顺序锁遥测存储", r);
+    }
+
+    return 0;
+}
@@ -0,0 +1,179 @@
+// stream_statistics.cpp
+#include "stream_statistics.h"
+#include "bit_ops.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr double NO_VALUE = std::numeric_limits<double>::quiet_NaN();
+constexpr int64_t NO_TIME = std::numeric_limits<int64_t>::min();
+
+bool usesBuffer(ChannelStatistic kind) {
+    return kind == ChannelStatistic::MEAN || kind == ChannelStatistic::STDDEV ||
+           kind == ChannelStatistic::MIN || kind == ChannelStatistic::MAX;
+}
+
+} // namespace
+
+StreamStatistics::StreamStatistics(ChannelStatistic kind, int32_t window_ms, int32_t sample_ms, size_t rows)
+    : kind_(kind),
+      window_ms_(std::max<int32_t>(1, window_ms)),
+      sample_ms_(sample_ms > 0 ? sample_ms : DEFAULT_SAMPLE_MS),
+      window_us_(static_cast<int64_t>(window_ms_) * 1000),
+      capacity_(0),
+      overflows_(0) {
+    if (usesBuffer(kind)) {
+        // 一个窗口内的样本数（含两端），按上限截断以限制内存
+        int64_t samples = (static_cast<int64_t>(window_ms_) + sample_ms_ - 1) / sample_ms_ + 1;
+        capacity_ = static_cast<uint32_t>(std::min<int64_t>(std::max<int64_t>(2, samples), MAX_CAPACITY));
+        times_.assign(rows * capacity_, 0);
+        values_.assign(rows * capacity_, 0.0);
+        head_.assign(rows, 0);
+        count_.assign(rows, 0);
+    }
+    mean_.assign(rows, kind == ChannelStatistic::EWMA ? NO_VALUE : 0.0);
+    m2_.assign(kind == ChannelStatistic::STDDEV ? rows : 0, 0.0);
+    last_time_us_.assign(rows, NO_TIME);
+    last_value_.assign(rows, NO_VALUE);
+    output_.assign(rows, NO_VALUE);
+}
+
+double StreamStatistics::update(size_t row, int64_t time_us, double value) {
+    if (std::isnan(value) || time_us <= last_time_us_[row]) {
+        return output_[row]; // 无数据或乱序
+    }
+    switch (kind_) {
+        case ChannelStatistic::EWMA:
+            if (std::isnan(mean_[row])) {
+                mean_[row] = value;
+            } else {
+                double alpha = 1.0 - std::exp(-static_cast<double>(time_us - last_time_us_[row]) /
+                                              static_cast<double>(window_us_));
+                mean_[row] += alpha * (value - mean_[row]);
+            }
+            break;
+        case ChannelStatistic::MEAN:
+        case ChannelStatistic::STDDEV:
+            expire(row, time_us);
+            if (count_[row] == capacity_) {
+                popFront(row);
+                ++overflows_;
+            }
+            pushBack(row, time_us, value);
+            break;
+        case ChannelStatistic::MIN:
+        case ChannelStatistic::MAX: {
+            expire(row, time_us);
+            // 单调队列：移除队尾不优于新样本的项，它们在窗口内不可能再成为极值
+            bool is_min = kind_ == ChannelStatistic::MIN;
+            size_t base = row * capacity_;
+            while (count_[row] > 0) {
+                double back = values_[base + (head_[row] + count_[row] - 1) % capacity_];
+                if (is_min ? back < value : back > value) {
+                    break;
+                }
+                --count_[row];
+            }
+            if (count_[row] == capacity_) {
+                // 队尾优于新样本：延长队尾的保留时间代替新样本入队，队首极值不被挤出
+                times_[base + (head_[row] + count_[row] - 1) % capacity_] = time_us;
+                ++overflows_;
+            } else {
+                pushBack(row, time_us, value);
+            }
+            break;
+        }
+        case ChannelStatistic::VALUE:
+            break;
+    }
+    last_time_us_[row] = time_us;
+    last_value_[row] = value;
+    output_[row] = evaluate(row);
+    return output_[row];
+}
+
+void StreamStatistics::updateColumn(const double* values, const int64_t* times, const uint64_t* changed,
+                                    uint64_t* output_changed, size_t rows) {
+    for (size_t w = 0; w < (rows + 63) / 64; ++w) {
+        for (uint64_t bits = changed[w]; bits != 0; bits &= bits - 1) {
+            unsigned bit = lowestSetBit(bits);
+            size_t row = w * 64 + bit;
+            double before = output_[row];
+            double after = update(row, times[row], values[row]);
+            if (after != before && !(std::isnan(after) && std::isnan(before))) {
+                output_changed[w] |= 1ull << bit;
+            }
+        }
+    }
+}
+
+void StreamStatistics::expire(size_t row, int64_t time_us) {
+    size_t base = row * capacity_;
+    while (count_[row] > 0 && time_us - times_[base + head_[row]] >= window_us_) {
+        popFront(row);
+    }
+}
+
+// 移出队首；均值与离差平方和按滑动Welford公式撤销该样本
+void StreamStatistics::popFront(size_t row) {
+    size_t base = row * capacity_;
+    double removed = values_[base + head_[row]];
+    head_[row] = (head_[row] + 1) % capacity_;
+    uint32_t n = --count_[row];
+    if (kind_ != ChannelStatistic::MEAN && kind_ != ChannelStatistic::STDDEV) {
+        return;
+    }
+    if (n == 0) {
+        mean_[row] = 0.0;
+        if (!m2_.empty()) {
+            m2_[row] = 0.0;
+        }
+        return;
+    }
+    double delta = removed - mean_[row];
+    mean_[row] -= delta / n;
+    if (!m2_.empty()) {
+        m2_[row] = std::max(0.0, m2_[row] - delta * (removed - mean_[row]));
+    }
+}
+
+void StreamStatistics::pushBack(size_t row, int64_t time_us, double value) {
+    size_t slot = row * capacity_ + (head_[row] + count_[row]) % capacity_;
+    times_[slot] = time_us;
+    values_[slot] = value;
+    uint32_t n = ++count_[row];
+    if (kind_ != ChannelStatistic::MEAN && kind_ != ChannelStatistic::STDDEV) {
+        return;
+    }
+    double delta = value - mean_[row];
+    mean_[row] += delta / n;
+    if (!m2_.empty()) {
+        m2_[row] += delta * (value - mean_[row]);
+    }
+}
+
+double StreamStatistics::evaluate(size_t row) const {
+    switch (kind_) {
+        case ChannelStatistic::EWMA:
+            return mean_[row];
+        case ChannelStatistic::MEAN:
+            return count_[row] > 0 ? mean_[row] : NO_VALUE;
+        case ChannelStatistic::STDDEV:
+            return count_[row] > 1 ? std::sqrt(m2_[row] / (count_[row] - 1)) : NO_VALUE;
+        case ChannelStatistic::MIN:
+        case ChannelStatistic::MAX:
+            return count_[row] > 0 ? values_[row * capacity_ + head_[row]] : NO_VALUE;
+        case ChannelStatistic::VALUE:
+            break;
+    }
+    return last_value_[row];
+}
+
+size_t StreamStatistics::memoryUsage() const {
+    return times_.capacity() * sizeof(int64_t) + values_.capacity() * sizeof(double) +
+           (head_.capacity() + count_.capacity()) * sizeof(uint32_t) +
+           (mean_.capacity() + m2_.capacity() + last_value_.capacity() + output_.capacity()) * sizeof(double) +
+           last_time_us_.capacity() * sizeof(int64_t);
+}
@@ -0,0 +1,81 @@
+// stream_statistics.h
+#ifndef STREAM_STATISTICS_H
+#define STREAM_STATISTICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 通道统计量：规则可对通道原值或其统计量判定
+enum class ChannelStatistic : uint8_t {
+    VALUE,      // 原值（不统计）
+    EWMA,       // 指数加权滑动平均（时间常数为窗口长度）
+    MEAN,       // 窗口内样本均值
+    STDDEV,     // 窗口内样本标准差
+    MIN,        // 窗口内最小值
+    MAX         // 窗口内最大值
+};
+
+// 单个通道统计流：每台设备一行，状态在构造时一次性分配，稳态下不再分配。
+// - EWMA按实际样本间隔计算系数，采样不均匀时时间常数不变；
+// - MEAN/STDDEV对窗口内样本环形缓冲做滑动Welford增删；
+// - MIN/MAX使用单调队列，队首即窗口极值。
+// 缓冲容量按窗口与预期最短采样间隔分配。每个样本均摊O(1)。
+// 采样快于预期而缓冲已满时计入溢出数：MEAN/STDDEV移出最早的样本（窗口相应缩短）；
+// MIN/MAX将新样本并入队尾（队尾优于新样本，其保留时间延长），窗口内极值不丢失，只会偏保守。
+// 无数据时输出NaN（不越限），无新样本时保持最近的统计量。非线程安全，仅监测线程使用。
+class StreamStatistics {
+public:
+    static constexpr int32_t DEFAULT_SAMPLE_MS = 100;   // 未指定采样间隔时按监测周期估计
+    static constexpr uint32_t MAX_CAPACITY = 4096;      // 每台设备的缓冲上限
+
+    StreamStatistics(ChannelStatistic kind, int32_t window_ms, int32_t sample_ms, size_t rows);
+
+    // 接入单个样本（时间戳us），返回更新后的统计量；不晚于上一样本的乱序或重复样本被忽略
+    double update(size_t row, int64_t time_us, double value);
+
+    // 接入整列快照：仅本轮有写入的设备（changed位图）按其采集时间接入，统计量有变化的设备
+    // 在output_changed位图中置位；已由带时间戳样本接入的同一时刻不会重复接入
+    void updateColumn(const double* values, const int64_t* times, const uint64_t* changed,
+                      uint64_t* output_changed, size_t rows);
+
+    // 各设备当前统计量（与遥测列逐行对应）
+    const double* output() const { return output_.data(); }
+    double value(size_t row) const { return output_[row]; }
+
+    ChannelStatistic kind() const { return kind_; }
+    int32_t windowMs() const { return window_ms_; }
+    int32_t sampleMs() const { return sample_ms_; }
+    uint32_t capacity() const { return capacity_; }
+    size_t rows() const { return output_.size(); }
+    uint64_t overflows() const { return overflows_; } // 缓冲已满时提前移出或合并的样本数
+
+    size_t memoryUsage() const;
+
+private:
+    void expire(size_t row, int64_t time_us);   // 移出窗口外的样本
+    void popFront(size_t row);
+    void pushBack(size_t row, int64_t time_us, double value);
+    double evaluate(size_t row) const;
+
+    ChannelStatistic kind_;
+    int32_t window_ms_;
+    int32_t sample_ms_;                         // 预期最短采样间隔
+    int64_t window_us_;
+    uint32_t capacity_;                         // 每台设备的环形缓冲容量（EWMA为0）
+    uint64_t overflows_;
+
+    // 环形缓冲（MEAN/STDDEV为窗口内样本，MIN/MAX为单调队列），按行连续存放
+    std::vector<int64_t> times_;
+    std::vector<double> values_;
+    std::vector<uint32_t> head_;
+    std::vector<uint32_t> count_;
+
+    std::vector<double> mean_;                  // EWMA值或窗口均值
+    std::vector<double> m2_;                    // 离差平方和（STDDEV）
+    std::vector<int64_t> last_time_us_;         // 最近样本时间
+    std::vector<double> last_value_;            // 最近样本值
+    std::vector<double> output_;                // 当前统计量
+};
+
+#endif // STREAM_STATISTICS_H
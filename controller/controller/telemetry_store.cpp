@@ -0,0 +1,220 @@
+// telemetry_store.cpp
+#include "telemetry_store.h"
+#include "bit_ops.h"
+#include "seqlock.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+inline uint64_t toBits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline double fromBits(uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+constexpr size_t SNAPSHOT_BLOCK = 64; // 快照按64行分块复制，兼顾列访问局部性与重试粒度
+
+} // namespace
+
+void DirtyChannelSet::allocate(const DeviceRegistry& registry) {
+    for (size_t c = 0; c < DEVICE_CLASS_COUNT; ++c) {
+        words_[c] = (registry.deviceCount(static_cast<DeviceClass>(c)) + 63) / 64;
+        for (auto& bits : bits_[c]) {
+            bits.assign(words_[c], 0);
+        }
+    }
+}
+
+void DirtyChannelSet::clear() {
+    for (auto& by_channel : bits_) {
+        for (auto& bits : by_channel) {
+            std::fill(bits.begin(), bits.end(), 0);
+        }
+    }
+}
+
+// 分配存储，初始值为NaN（尚无数据）
+void TelemetryStore::allocate(const DeviceRegistry& registry) {
+    const uint64_t nan_bits = toBits(std::numeric_limits<double>::quiet_NaN());
+    for (size_t c = 0; c < DEVICE_CLASS_COUNT; ++c) {
+        ClassBlock& block = blocks_[c];
+        block.rows = registry.deviceCount(static_cast<DeviceClass>(c));
+        block.seq.reset(new std::atomic<uint32_t>[block.rows]);
+        for (size_t i = 0; i < block.rows; ++i) {
+            block.seq[i].store(0, std::memory_order_relaxed);
+        }
+        for (auto& column : block.columns) {
+            column.reset(new std::atomic<uint64_t>[block.rows]);
+            for (size_t i = 0; i < block.rows; ++i) {
+                column[i].store(nan_bits, std::memory_order_relaxed);
+            }
+        }
+        block.times.reset(new std::atomic<int64_t>[block.rows]);
+        for (size_t i = 0; i < block.rows; ++i) {
+            block.times[i].store(NO_SAMPLE_TIME, std::memory_order_relaxed);
+        }
+        block.words = (block.rows + 63) / 64;
+        for (auto& dirty : block.dirty) {
+            dirty.reset(new std::atomic<uint64_t>[block.words]);
+            for (size_t w = 0; w < block.words; ++w) {
+                dirty[w].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+// 写入单个通道
+void TelemetryStore::write(DeviceIndex device, TelemetryChannel channel, double value, int64_t time_us) {
+    ChannelUpdate update{channel, value};
+    writeRow(device, &update, 1, time_us);
+}
+
+// 原子地写入同一设备的多个通道
+void TelemetryStore::writeRow(DeviceIndex device, const ChannelUpdate* updates, size_t count, int64_t time_us) {
+    ClassBlock& block = blocks_[static_cast<size_t>(deviceClassOf(device))];
+    uint32_t row = localIndexOf(device);
+    uint32_t s = seqWriteBegin(block.seq[row]);
+    block.times[row].store(time_us, std::memory_order_relaxed);
+    for (size_t i = 0; i < count; ++i) {
+        block.columns[static_cast<size_t>(updates[i].channel)][row].store(
+            toBits(updates[i].value), std::memory_order_relaxed);
+    }
+    seqWriteEnd(block.seq[row], s);
+    // 数据发布后再置变更位：监测线程看到变更位时必能读到本次写入
+    uint64_t bit = 1ull << (row % 64);
+    for (size_t i = 0; i < count; ++i) {
+        block.dirty[static_cast<size_t>(updates[i].channel)][row / 64].fetch_or(bit, std::memory_order_release);
+    }
+}
+
+void TelemetryStore::readRowConsistent(const ClassBlock& block, uint32_t row, double* out,
+                                       int64_t* time_us) const {
+    uint32_t spins = 0;
+    for (;;) {
+        uint32_t s = seqReadBegin(block.seq[row]);
+        for (size_t ch = 0; ch < TELEMETRY_CHANNEL_COUNT; ++ch) {
+            out[ch] = fromBits(block.columns[ch][row].load(std::memory_order_relaxed));
+        }
+        if (time_us != nullptr) {
+            *time_us = block.times[row].load(std::memory_order_relaxed);
+        }
+        if (seqReadValidate(block.seq[row], s)) {
+            return;
+        }
+        read_retries_.fetch_add(1, std::memory_order_relaxed);
+        seqBackoff(spins);
+    }
+}
+
+// 读取单台设备的一致快照
+void TelemetryStore::readRow(DeviceIndex device, double (&out)[TELEMETRY_CHANNEL_COUNT]) const {
+    const ClassBlock& block = blocks_[static_cast<size_t>(deviceClassOf(device))];
+    readRowConsistent(block, localIndexOf(device), out);
+}
+
+// 将全部设备的一致快照复制到扫描表：
+// 先按列整块复制，再逐行复查序号，仅对写入冲突的行单独重读
+void TelemetryStore::snapshotInto(TelemetryTable& table) const {
+    uint32_t begin_seq[SNAPSHOT_BLOCK];
+    for (size_t c = 0; c < DEVICE_CLASS_COUNT; ++c) {
+        const ClassBlock& block = blocks_[c];
+        DeviceClass device_class = static_cast<DeviceClass>(c);
+        double* columns[TELEMETRY_CHANNEL_COUNT];
+        for (size_t ch = 0; ch < TELEMETRY_CHANNEL_COUNT; ++ch) {
+            columns[ch] = table.column(device_class, static_cast<TelemetryChannel>(ch));
+        }
+        int64_t* times = table.sampleTimes(device_class);
+
+        for (size_t base = 0; base < block.rows; base += SNAPSHOT_BLOCK) {
+            size_t n = std::min(SNAPSHOT_BLOCK, block.rows - base);
+            for (size_t i = 0; i < n; ++i) {
+                begin_seq[i] = seqReadBegin(block.seq[base + i]);
+            }
+            for (size_t ch = 0; ch < TELEMETRY_CHANNEL_COUNT; ++ch) {
+                const std::atomic<uint64_t>* src = block.columns[ch].get() + base;
+                double* dst = columns[ch] + base;
+                for (size_t i = 0; i < n; ++i) {
+                    dst[i] = fromBits(src[i].load(std::memory_order_relaxed));
+                }
+            }
+            for (size_t i = 0; i < n; ++i) {
+                times[base + i] = block.times[base + i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            for (size_t i = 0; i < n; ++i) {
+                uint32_t s = begin_seq[i];
+                if ((s & 1u) != 0 || block.seq[base + i].load(std::memory_order_relaxed) != s) {
+                    // 该行复制期间有写入，单独重读
+                    read_retries_.fetch_add(1, std::memory_order_relaxed);
+                    double row[TELEMETRY_CHANNEL_COUNT];
+                    readRowConsistent(block, static_cast<uint32_t>(base + i), row, &times[base + i]);
+                    for (size_t ch = 0; ch < TELEMETRY_CHANNEL_COUNT; ++ch) {
+                        columns[ch][base + i] = row[ch];
+                    }
+                }
+            }
+        }
+    }
+}
+
+// 增量快照：按64台设备一组取走各通道的变更位，只重读有变更的设备；
+// 取走变更位之后才发生的写入会再次置位，在下一次收集时处理
+void TelemetryStore::collectChanges(TelemetryTable& table, DirtyChannelSet& changes) {
+    for (size_t c = 0; c < DEVICE_CLASS_COUNT; ++c) {
+        ClassBlock& block = blocks_[c];
+        DeviceClass device_class = static_cast<DeviceClass>(c);
+        double* columns[TELEMETRY_CHANNEL_COUNT];
+        uint64_t* change_words[TELEMETRY_CHANNEL_COUNT];
+        for (size_t ch = 0; ch < TELEMETRY_CHANNEL_COUNT; ++ch) {
+            columns[ch] = table.column(device_class, static_cast<TelemetryChannel>(ch));
+            change_words[ch] = changes.words(device_class, static_cast<TelemetryChannel>(ch));
+        }
+        int64_t* times = table.sampleTimes(device_class);
+
+        for (size_t w = 0; w < block.words; ++w) {
+            uint64_t rows = 0;
+            uint64_t channel_bits[TELEMETRY_CHANNEL_COUNT];
+            for (size_t ch = 0; ch < TELEMETRY_CHANNEL_COUNT; ++ch) {
+                std::atomic<uint64_t>& dirty = block.dirty[ch][w];
+                channel_bits[ch] = 0;
+                if (dirty.load(std::memory_order_relaxed) == 0) {
+                    continue; // 先读后取，无变更的字不做读改写
+                }
+                channel_bits[ch] = dirty.exchange(0, std::memory_order_acquire);
+                change_words[ch][w] |= channel_bits[ch];
+                rows |= channel_bits[ch];
+            }
+            while (rows != 0) {
+                unsigned bit = lowestSetBit(rows);
+                uint32_t row = static_cast<uint32_t>(w * 64 + bit);
+                rows &= rows - 1;
+                double values[TELEMETRY_CHANNEL_COUNT];
+                readRowConsistent(block, row, values, &times[row]);
+                // 只复制有写入的通道：派生通道列由监测线程计算，不被存储中的空值覆盖
+                for (size_t ch = 0; ch < TELEMETRY_CHANNEL_COUNT; ++ch) {
+                    if ((channel_bits[ch] >> bit) & 1) {
+                        columns[ch][row] = values[ch];
+                    }
+                }
+            }
+        }
+    }
+}
+
+size_t TelemetryStore::memoryUsage() const {
+    size_t bytes = sizeof(*this);
+    for (const auto& block : blocks_) {
+        bytes += block.rows * (sizeof(std::atomic<uint32_t>) + sizeof(std::atomic<int64_t>) +
+                               TELEMETRY_CHANNEL_COUNT * sizeof(std::atomic<uint64_t>));
+        bytes += block.words * TELEMETRY_CHANNEL_COUNT * sizeof(std::atomic<uint64_t>);
+    }
+    return bytes;
+}
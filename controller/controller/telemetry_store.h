@@ -0,0 +1,101 @@
+// telemetry_store.h
+#ifndef TELEMETRY_STORE_H
+#define TELEMETRY_STORE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "device_registry.h"
+
+// 单通道更新项
+struct ChannelUpdate {
+    TelemetryChannel channel;   // 通道
+    double value;               // 数值
+};
+
+// 带采集时间戳的遥测样本（批量接入接口使用）
+struct TelemetrySample {
+    std::chrono::system_clock::time_point timestamp; // 采集时间
+    DeviceIndex device;                              // 设备索引
+    TelemetryChannel channel;                        // 通道
+    double value;                                    // 数值
+};
+
+// 变更位图：每类设备每个通道一个位图（每64台设备一个字），记录自上次扫描以来写入过的设备。
+// 仅监测线程使用
+class DirtyChannelSet {
+public:
+    // 按注册表分配位图（全部清零）
+    void allocate(const DeviceRegistry& registry);
+
+    size_t wordCount(DeviceClass device_class) const {
+        return words_[static_cast<size_t>(device_class)];
+    }
+    uint64_t* words(DeviceClass device_class, TelemetryChannel channel) {
+        return bits_[static_cast<size_t>(device_class)][static_cast<size_t>(channel)].data();
+    }
+    const uint64_t* words(DeviceClass device_class, TelemetryChannel channel) const {
+        return bits_[static_cast<size_t>(device_class)][static_cast<size_t>(channel)].data();
+    }
+
+    // 清空全部位图（扫描结束后调用）
+    void clear();
+
+private:
+    size_t words_[DEVICE_CLASS_COUNT] = {};
+    std::vector<uint64_t> bits_[DEVICE_CLASS_COUNT][TELEMETRY_CHANNEL_COUNT];
+};
+
+// 共享遥测存储：生产者与监测线程之间的无锁快照
+// 列式布局与TelemetryTable一致，每台设备一个顺序锁序号：
+// 写者不等待读者，读者按行校验序号得到每台设备的一致快照。
+class TelemetryStore {
+public:
+    TelemetryStore() = default;
+    TelemetryStore(const TelemetryStore&) = delete;
+    TelemetryStore& operator=(const TelemetryStore&) = delete;
+
+    // 按注册表分配存储（初始化阶段调用一次）
+    void allocate(const DeviceRegistry& registry);
+
+    // 写入单个通道，time_us为采集时间(system_clock, us)，无时间戳的写入取写入时刻
+    void write(DeviceIndex device, TelemetryChannel channel, double value, int64_t time_us);
+
+    // 原子地写入同一设备的多个通道（同一采集时间）
+    void writeRow(DeviceIndex device, const ChannelUpdate* updates, size_t count, int64_t time_us);
+
+    // 读取单台设备的一致快照
+    void readRow(DeviceIndex device, double (&out)[TELEMETRY_CHANNEL_COUNT]) const;
+
+    // 将全部设备的一致快照（含采集时间）复制到扫描表
+    void snapshotInto(TelemetryTable& table) const;
+
+    // 增量快照：取走自上次收集以来写入的变更位并入changes，仅将变更设备有写入的通道及其采集时间
+    // 复制到扫描表（同一设备的各通道取自同一一致快照）。
+    // 扫描表须与存储保持同步（自分配起只经本接口或snapshotInto更新）；仅监测线程调用
+    void collectChanges(TelemetryTable& table, DirtyChannelSet& changes);
+
+    // 读者因并发写入而重试的累计次数
+    uint64_t readRetries() const { return read_retries_.load(std::memory_order_relaxed); }
+
+    size_t memoryUsage() const;
+
+private:
+    struct ClassBlock {
+        size_t rows = 0;
+        std::unique_ptr<std::atomic<uint32_t>[]> seq;                         // 每台设备的序号
+        std::unique_ptr<std::atomic<uint64_t>[]> columns[TELEMETRY_CHANNEL_COUNT]; // 数值位模式
+        std::unique_ptr<std::atomic<int64_t>[]> times;                        // 每台设备最近一次写入的采集时间
+        size_t words = 0;
+        std::unique_ptr<std::atomic<uint64_t>[]> dirty[TELEMETRY_CHANNEL_COUNT];   // 变更位（写者置位，监测线程取走）
+    };
+
+    void readRowConsistent(const ClassBlock& block, uint32_t row, double* out, int64_t* time_us = nullptr) const;
+
+    ClassBlock blocks_[DEVICE_CLASS_COUNT];
+    mutable std::atomic<uint64_t> read_retries_{0};
+};
+
+#endif // TELEMETRY_STORE_H
@@ -0,0 +1,342 @@
+// threshold_kernel.cpp
+#include "threshold_kernel.h"
+#include <atomic>
+
+// GCC/Clang的x86目标按函数启用AVX2/AVX-512指令，运行时按CPU支持情况分派；
+// SSE2是x86-64的基线指令集，编译期已启用时（含MSVC x64）直接使用，作为x86上的保底实现；
+// 其他平台使用无分支的标量实现
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define THRESHOLD_KERNEL_X86 1
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define THRESHOLD_KERNEL_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+using CompareFn = void (*)(const double*, const double*, const double*, size_t, uint64_t*);
+using CompareUniformFn = void (*)(const double*, double, double, size_t, uint64_t*);
+
+// 标量比较[begin, end)行，结果写入一个掩码字（end - begin <= 64）
+inline uint64_t compareWordScalar(const double* values, const double* low, const double* high,
+                                  size_t begin, size_t end) {
+    uint64_t word = 0;
+    for (size_t i = begin; i < end; ++i) {
+        uint64_t bit = uint64_t(values[i] <= low[i]) | uint64_t(values[i] >= high[i]);
+        word |= bit << (i - begin);
+    }
+    return word;
+}
+
+inline uint64_t compareWordUniformScalar(const double* values, double low, double high,
+                                         size_t begin, size_t end) {
+    uint64_t word = 0;
+    for (size_t i = begin; i < end; ++i) {
+        uint64_t bit = uint64_t(values[i] <= low) | uint64_t(values[i] >= high);
+        word |= bit << (i - begin);
+    }
+    return word;
+}
+
+// 整字（64行）比较：每4行无分支地求出越限位（不用短路求值），4行中有越限时才合入掩码字；
+// 越限很少时分支几乎总被正确预测，越限多时每4行只有一次分支。
+// 非x86平台与未启用SSE2的编译走此路径
+inline uint64_t compareFullWordScalar(const double* values, const double* low, const double* high) {
+    uint64_t word = 0;
+    for (size_t j = 0; j < 64; j += 4) {
+        uint64_t b0 = uint64_t(values[j] <= low[j]) | uint64_t(values[j] >= high[j]);
+        uint64_t b1 = uint64_t(values[j + 1] <= low[j + 1]) | uint64_t(values[j + 1] >= high[j + 1]);
+        uint64_t b2 = uint64_t(values[j + 2] <= low[j + 2]) | uint64_t(values[j + 2] >= high[j + 2]);
+        uint64_t b3 = uint64_t(values[j + 3] <= low[j + 3]) | uint64_t(values[j + 3] >= high[j + 3]);
+        if ((b0 | b1 | b2 | b3) != 0) {
+            word |= (b0 | (b1 << 1) | (b2 << 2) | (b3 << 3)) << j;
+        }
+    }
+    return word;
+}
+
+inline uint64_t compareFullWordUniformScalar(const double* values, double low, double high) {
+    uint64_t word = 0;
+    for (size_t j = 0; j < 64; j += 4) {
+        uint64_t b0 = uint64_t(values[j] <= low) | uint64_t(values[j] >= high);
+        uint64_t b1 = uint64_t(values[j + 1] <= low) | uint64_t(values[j + 1] >= high);
+        uint64_t b2 = uint64_t(values[j + 2] <= low) | uint64_t(values[j + 2] >= high);
+        uint64_t b3 = uint64_t(values[j + 3] <= low) | uint64_t(values[j + 3] >= high);
+        if ((b0 | b1 | b2 | b3) != 0) {
+            word |= (b0 | (b1 << 1) | (b2 << 2) | (b3 << 3)) << j;
+        }
+    }
+    return word;
+}
+
+void compareBandScalar(const double* values, const double* low, const double* high,
+                       size_t rows, uint64_t* masks) {
+    size_t full_words = rows / 64;
+    for (size_t w = 0; w < full_words; ++w) {
+        size_t base = w * 64;
+        masks[w] = compareFullWordScalar(values + base, low + base, high + base);
+    }
+    if (full_words * 64 < rows) {
+        masks[full_words] = compareWordScalar(values, low, high, full_words * 64, rows);
+    }
+}
+
+void compareBandUniformScalar(const double* values, double low, double high,
+                              size_t rows, uint64_t* masks) {
+    size_t full_words = rows / 64;
+    for (size_t w = 0; w < full_words; ++w) {
+        masks[w] = compareFullWordUniformScalar(values + w * 64, low, high);
+    }
+    if (full_words * 64 < rows) {
+        masks[full_words] = compareWordUniformScalar(values, low, high, full_words * 64, rows);
+    }
+}
+
+#ifdef THRESHOLD_KERNEL_SSE2
+
+void compareBandSse2(const double* values, const double* low, const double* high,
+                     size_t rows, uint64_t* masks) {
+    size_t full_words = rows / 64;
+    for (size_t w = 0; w < full_words; ++w) {
+        size_t base = w * 64;
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j += 2) {
+            __m128d v = _mm_loadu_pd(values + base + j);
+            __m128d below = _mm_cmple_pd(v, _mm_loadu_pd(low + base + j));
+            __m128d above = _mm_cmpge_pd(v, _mm_loadu_pd(high + base + j));
+            uint64_t bits = static_cast<uint32_t>(_mm_movemask_pd(_mm_or_pd(below, above)));
+            word |= bits << j;
+        }
+        masks[w] = word;
+    }
+    if (full_words * 64 < rows) {
+        masks[full_words] = compareWordScalar(values, low, high, full_words * 64, rows);
+    }
+}
+
+void compareBandUniformSse2(const double* values, double low, double high,
+                            size_t rows, uint64_t* masks) {
+    __m128d lo = _mm_set1_pd(low);
+    __m128d hi = _mm_set1_pd(high);
+    size_t full_words = rows / 64;
+    for (size_t w = 0; w < full_words; ++w) {
+        size_t base = w * 64;
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j += 2) {
+            __m128d v = _mm_loadu_pd(values + base + j);
+            __m128d outside = _mm_or_pd(_mm_cmple_pd(v, lo), _mm_cmpge_pd(v, hi));
+            word |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_pd(outside))) << j;
+        }
+        masks[w] = word;
+    }
+    if (full_words * 64 < rows) {
+        masks[full_words] = compareWordUniformScalar(values, low, high, full_words * 64, rows);
+    }
+}
+
+#endif // THRESHOLD_KERNEL_SSE2
+
+#ifdef THRESHOLD_KERNEL_X86
+
+__attribute__((target("avx2")))
+void compareBandAvx2(const double* values, const double* low, const double* high,
+                     size_t rows, uint64_t* masks) {
+    size_t full_words = rows / 64;
+    for (size_t w = 0; w < full_words; ++w) {
+        size_t base = w * 64;
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j += 4) {
+            __m256d v = _mm256_loadu_pd(values + base + j);
+            __m256d below = _mm256_cmp_pd(v, _mm256_loadu_pd(low + base + j), _CMP_LE_OQ);
+            __m256d above = _mm256_cmp_pd(v, _mm256_loadu_pd(high + base + j), _CMP_GE_OQ);
+            uint64_t bits = static_cast<uint32_t>(_mm256_movemask_pd(_mm256_or_pd(below, above)));
+            word |= bits << j;
+        }
+        masks[w] = word;
+    }
+    if (full_words * 64 < rows) {
+        masks[full_words] = compareWordScalar(values, low, high, full_words * 64, rows);
+    }
+}
+
+__attribute__((target("avx2")))
+void compareBandUniformAvx2(const double* values, double low, double high,
+                            size_t rows, uint64_t* masks) {
+    __m256d lo = _mm256_set1_pd(low);
+    __m256d hi = _mm256_set1_pd(high);
+    size_t full_words = rows / 64;
+    for (size_t w = 0; w < full_words; ++w) {
+        size_t base = w * 64;
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j += 4) {
+            __m256d v = _mm256_loadu_pd(values + base + j);
+            __m256d out = _mm256_or_pd(_mm256_cmp_pd(v, lo, _CMP_LE_OQ), _mm256_cmp_pd(v, hi, _CMP_GE_OQ));
+            uint64_t bits = static_cast<uint32_t>(_mm256_movemask_pd(out));
+            word |= bits << j;
+        }
+        masks[w] = word;
+    }
+    if (full_words * 64 < rows) {
+        masks[full_words] = compareWordUniformScalar(values, low, high, full_words * 64, rows);
+    }
+}
+
+__attribute__((target("avx512f")))
+void compareBandAvx512(const double* values, const double* low, const double* high,
+                       size_t rows, uint64_t* masks) {
+    size_t full_words = rows / 64;
+    for (size_t w = 0; w < full_words; ++w) {
+        size_t base = w * 64;
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j += 8) {
+            __m512d v = _mm512_loadu_pd(values + base + j);
+            __mmask8 below = _mm512_cmp_pd_mask(v, _mm512_loadu_pd(low + base + j), _CMP_LE_OQ);
+            __mmask8 above = _mm512_cmp_pd_mask(v, _mm512_loadu_pd(high + base + j), _CMP_GE_OQ);
+            word |= static_cast<uint64_t>(static_cast<uint8_t>(below | above)) << j;
+        }
+        masks[w] = word;
+    }
+    if (full_words * 64 < rows) {
+        masks[full_words] = compareWordScalar(values, low, high, full_words * 64, rows);
+    }
+}
+
+__attribute__((target("avx512f")))
+void compareBandUniformAvx512(const double* values, double low, double high,
+                              size_t rows, uint64_t* masks) {
+    __m512d lo = _mm512_set1_pd(low);
+    __m512d hi = _mm512_set1_pd(high);
+    size_t full_words = rows / 64;
+    for (size_t w = 0; w < full_words; ++w) {
+        size_t base = w * 64;
+        uint64_t word = 0;
+        for (size_t j = 0; j < 64; j += 8) {
+            __m512d v = _mm512_loadu_pd(values + base + j);
+            __mmask8 out = _mm512_cmp_pd_mask(v, lo, _CMP_LE_OQ) | _mm512_cmp_pd_mask(v, hi, _CMP_GE_OQ);
+            word |= static_cast<uint64_t>(static_cast<uint8_t>(out)) << j;
+        }
+        masks[w] = word;
+    }
+    if (full_words * 64 < rows) {
+        masks[full_words] = compareWordUniformScalar(values, low, high, full_words * 64, rows);
+    }
+}
+
+#endif // THRESHOLD_KERNEL_X86
+
+struct KernelFunctions {
+    CompareFn compare;
+    CompareUniformFn compare_uniform;
+};
+
+KernelFunctions kernelFunctions(ThresholdKernel kernel) {
+    switch (kernel) {
+#ifdef THRESHOLD_KERNEL_SSE2
+        case ThresholdKernel::SSE2:
+            return KernelFunctions{compareBandSse2, compareBandUniformSse2};
+#endif
+#ifdef THRESHOLD_KERNEL_X86
+        case ThresholdKernel::AVX2:
+            return KernelFunctions{compareBandAvx2, compareBandUniformAvx2};
+        case ThresholdKernel::AVX512:
+            return KernelFunctions{compareBandAvx512, compareBandUniformAvx512};
+#endif
+        default:
+            return KernelFunctions{compareBandScalar, compareBandUniformScalar};
+    }
+}
+
+// 按CPU支持情况选择最快实现
+ThresholdKernel detectKernel() {
+#ifdef THRESHOLD_KERNEL_X86
+    __builtin_cpu_init(); // 可能早于全局构造调用
+#endif
+    if (isThresholdKernelSupported(ThresholdKernel::AVX512)) {
+        return ThresholdKernel::AVX512;
+    }
+    if (isThresholdKernelSupported(ThresholdKernel::AVX2)) {
+        return ThresholdKernel::AVX2;
+    }
+    if (isThresholdKernelSupported(ThresholdKernel::SSE2)) {
+        return ThresholdKernel::SSE2;
+    }
+    return ThresholdKernel::SCALAR;
+}
+
+struct KernelSelection {
+    std::atomic<ThresholdKernel> kernel;
+    std::atomic<CompareFn> compare;
+    std::atomic<CompareUniformFn> compare_uniform;
+
+    KernelSelection() : kernel(detectKernel()) {
+        KernelFunctions functions = kernelFunctions(kernel.load());
+        compare.store(functions.compare);
+        compare_uniform.store(functions.compare_uniform);
+    }
+};
+
+KernelSelection& selection() {
+    static KernelSelection instance;
+    return instance;
+}
+
+} // namespace
+
+void compareBand(const double* values, const double* low, const double* high, size_t rows, uint64_t* masks) {
+    selection().compare.load(std::memory_order_relaxed)(values, low, high, rows, masks);
+}
+
+void compareBandUniform(const double* values, double low, double high, size_t rows, uint64_t* masks) {
+    selection().compare_uniform.load(std::memory_order_relaxed)(values, low, high, rows, masks);
+}
+
+ThresholdKernel activeThresholdKernel() {
+    return selection().kernel.load(std::memory_order_relaxed);
+}
+
+bool setThresholdKernel(ThresholdKernel kernel) {
+    if (!isThresholdKernelSupported(kernel)) {
+        return false;
+    }
+    KernelSelection& current = selection();
+    KernelFunctions functions = kernelFunctions(kernel);
+    current.kernel.store(kernel, std::memory_order_relaxed);
+    current.compare.store(functions.compare, std::memory_order_relaxed);
+    current.compare_uniform.store(functions.compare_uniform, std::memory_order_relaxed);
+    return true;
+}
+
+bool isThresholdKernelSupported(ThresholdKernel kernel) {
+    switch (kernel) {
+        case ThresholdKernel::SCALAR:
+            return true;
+#ifdef THRESHOLD_KERNEL_SSE2
+        case ThresholdKernel::SSE2:
+            return true; // 编译期已启用，运行的CPU必然支持
+#endif
+#ifdef THRESHOLD_KERNEL_X86
+        case ThresholdKernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+        case ThresholdKernel::AVX512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return false;
+    }
+}
+
+const char* thresholdKernelName(ThresholdKernel kernel) {
+    switch (kernel) {
+        case ThresholdKernel::SCALAR:
+            return "scalar";
+        case ThresholdKernel::SSE2:
+            return "sse2";
+        case ThresholdKernel::AVX2:
+            return "avx2";
+        case ThresholdKernel::AVX512:
+            return "avx512";
+    }
+    return "unknown";
+}
@@ -0,0 +1,40 @@
+// threshold_kernel.h
+#ifndef THRESHOLD_KERNEL_H
+#define THRESHOLD_KERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include "bit_ops.h"
+
+// 限值带比较内核实现
+enum class ThresholdKernel : uint8_t {
+    SCALAR,     // 标量实现（所有平台）
+    SSE2,       // 每次比较2台设备（x86基线指令集，编译期启用SSE2时可用）
+    AVX2,       // 每次比较4台设备
+    AVX512      // 每次比较8台设备
+};
+
+// 掩码字数：每64台设备一个字
+inline size_t maskWordCount(size_t rows) {
+    return (rows + 63) / 64;
+}
+
+// 限值带比较：values[i] <= low[i] 或 values[i] >= high[i] 时置位masks第i位（NaN不置位）。
+// masks须有maskWordCount(rows)个字，全部覆盖写入
+void compareBand(const double* values, const double* low, const double* high, size_t rows, uint64_t* masks);
+
+// 同上，所有行使用同一组限值
+void compareBandUniform(const double* values, double low, double high, size_t rows, uint64_t* masks);
+
+// 当前使用的内核（首次调用时按CPU支持情况自动选择最快实现）
+ThresholdKernel activeThresholdKernel();
+
+// 指定内核（用于基准测试与问题排查），CPU不支持时返回false
+bool setThresholdKernel(ThresholdKernel kernel);
+
+// CPU是否支持指定内核
+bool isThresholdKernelSupported(ThresholdKernel kernel);
+
+const char* thresholdKernelName(ThresholdKernel kernel);
+
+#endif // THRESHOLD_KERNEL_H
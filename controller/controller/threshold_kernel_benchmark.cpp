@@ -0,0 +1,190 @@
+// threshold_kernel_benchmark.cpp
+// 阈值检测基准测试：比较原逐字段判定逻辑与规则执行计划（标量/AVX2/AVX-512内核）的扫描耗时
+// 用法: threshold_kernel_benchmark [每项持续毫秒=300] [越限比例=0.001]
+#include "anomaly_rules.h"
+#include "device_registry.h"
+#include "threshold_kernel.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+// 等级累加值，避免判定等级的计算被优化掉
+uint64_t g_level_sum = 0;
+
+// 原checkAnomalies()的控制参数（原子变量，每次比较重新读取）
+struct LegacyParameters {
+    std::atomic<double> normal_voltage{220.0};
+    std::atomic<double> max_hydrogen_concentration{1.0};
+    std::atomic<double> max_hydrogen_pressure{1.5};
+};
+
+// 原determineAnomalyLevel()逻辑
+AnomalyLevel legacyLevel(const LegacyParameters& p, AnomalyType type, double value) {
+    switch (type) {
+        case AnomalyType::DEVICE_FAULT:
+            return AnomalyLevel::CRITICAL;
+        case AnomalyType::GRID_FAULT:
+            if (value >= 1.15 * p.normal_voltage || value <= 0.85 * p.normal_voltage ||
+                value >= 51.0 || value <= 49.0) {
+                return AnomalyLevel::CRITICAL;
+            } else if (value >= 1.1 * p.normal_voltage || value <= 0.9 * p.normal_voltage ||
+                       value >= 50.5 || value <= 49.5) {
+                return AnomalyLevel::WARNING;
+            }
+            return AnomalyLevel::INFO;
+        case AnomalyType::SAFETY_FAULT:
+            if (value >= 2.0 * p.max_hydrogen_concentration || value >= 2.0 * p.max_hydrogen_pressure) {
+                return AnomalyLevel::CRITICAL;
+            } else if (value >= 1.5 * p.max_hydrogen_concentration || value >= 1.5 * p.max_hydrogen_pressure) {
+                return AnomalyLevel::WARNING;
+            }
+            return AnomalyLevel::INFO;
+    }
+    return AnomalyLevel::INFO;
+}
+
+// 原逐字段判定：每台设备每个字段单独比较，越限后再确定等级
+uint64_t scanLegacy(const LegacyParameters& p, const TelemetryTable& table, size_t devices) {
+    uint64_t detected = 0;
+    const double* voltage = table.column(DeviceClass::GRID, TelemetryChannel::GRID_VOLTAGE);
+    const double* frequency = table.column(DeviceClass::GRID, TelemetryChannel::GRID_FREQUENCY);
+    const double* concentration = table.column(DeviceClass::HYDROGEN_SYSTEM, TelemetryChannel::HYDROGEN_CONCENTRATION);
+    const double* pressure = table.column(DeviceClass::HYDROGEN_SYSTEM, TelemetryChannel::HYDROGEN_TANK_PRESSURE);
+    for (size_t i = 0; i < devices; ++i) {
+        if (voltage[i] >= 1.1 * p.normal_voltage || voltage[i] <= 0.9 * p.normal_voltage) {
+            g_level_sum += static_cast<uint64_t>(legacyLevel(p, AnomalyType::GRID_FAULT, voltage[i]));
+            ++detected;
+        }
+        if (frequency[i] >= 50.5 || frequency[i] <= 49.5) {
+            g_level_sum += static_cast<uint64_t>(legacyLevel(p, AnomalyType::GRID_FAULT, frequency[i]));
+            ++detected;
+        }
+        if (concentration[i] >= p.max_hydrogen_concentration) {
+            g_level_sum += static_cast<uint64_t>(legacyLevel(p, AnomalyType::SAFETY_FAULT, concentration[i]));
+            ++detected;
+        }
+        if (pressure[i] >= p.max_hydrogen_pressure) {
+            g_level_sum += static_cast<uint64_t>(legacyLevel(p, AnomalyType::SAFETY_FAULT, pressure[i]));
+            ++detected;
+        }
+    }
+    return detected;
+}
+
+// 逐设备基线所覆盖的四个通道
+bool isLegacyChannel(TelemetryChannel channel) {
+    return channel == TelemetryChannel::GRID_VOLTAGE || channel == TelemetryChannel::GRID_FREQUENCY ||
+           channel == TelemetryChannel::HYDROGEN_CONCENTRATION ||
+           channel == TelemetryChannel::HYDROGEN_TANK_PRESSURE;
+}
+
+// 规则执行计划扫描（与AnomalyMonitoringController::checkAnomalies()相同）。
+// 只扫描基线覆盖的通道，事件驱动规则不参与整列扫描，两者比较同样的工作量
+uint64_t scanPlan(const AnomalyRuleEngine& rules, const TelemetryTable& table, std::vector<uint64_t>& screen) {
+    uint64_t detected = 0;
+    for (const CompiledRule& rule : rules.plan()) {
+        if (rule.event_driven || !isLegacyChannel(rule.channel)) {
+            continue;
+        }
+        const double* values = table.column(rule.device_class, rule.channel);
+        scanRule(rule, values, screen.data(), [&](size_t, int level) {
+            g_level_sum += static_cast<uint64_t>(level);
+            ++detected;
+        });
+    }
+    return detected;
+}
+
+// 重复执行直到达到持续时间，返回每轮耗时(ns)
+template <typename ScanFn>
+double timeScan(int duration_ms, ScanFn scan, uint64_t& detected) {
+    auto t0 = std::chrono::steady_clock::now();
+    auto deadline = t0 + std::chrono::milliseconds(duration_ms);
+    uint64_t rounds = 0;
+    do {
+        detected = scan();
+        ++rounds;
+    } while (std::chrono::steady_clock::now() < deadline);
+    double elapsed_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    return elapsed_ns / static_cast<double>(rounds);
+}
+
+void printRow(const char* name, double round_ns, size_t devices, double baseline_ns, uint64_t detected) {
+    std::cout << "  " << std::left << std::setw(16) << name
+              << " 每轮: " << std::right << std::setw(12) << std::fixed << std::setprecision(1) << round_ns / 1000.0
+              << " us  每台设备: " << std::setw(7) << std::setprecision(2) << round_ns / static_cast<double>(devices)
+              << " ns  加速比: " << std::setw(6) << std::setprecision(2) << baseline_ns / round_ns
+              << "  越限数: " << detected << std::endl;
+}
+
+void runScale(size_t devices, int duration_ms, double violation_ratio) {
+    // 每个并网点、储氢系统各devices台
+    DeviceRegistry registry;
+    for (size_t i = 0; i < devices; ++i) {
+        registry.registerDevice(DeviceClass::GRID, "grid" + std::to_string(i), 100.0, "");
+        registry.registerDevice(DeviceClass::HYDROGEN_SYSTEM, "h2_" + std::to_string(i), 100.0, "");
+    }
+    registry.freeze();
+
+    TelemetryTable table;
+    table.allocate(registry);
+    std::mt19937_64 rng(devices);
+    std::uniform_real_distribution<double> noise(-1.0, 1.0);
+    std::bernoulli_distribution violate(violation_ratio);
+    for (size_t i = 0; i < devices; ++i) {
+        uint32_t row = static_cast<uint32_t>(i);
+        DeviceIndex grid = makeDeviceIndex(DeviceClass::GRID, row);
+        DeviceIndex h2 = makeDeviceIndex(DeviceClass::HYDROGEN_SYSTEM, row);
+        table.setValue(grid, TelemetryChannel::GRID_VOLTAGE, violate(rng) ? 250.0 : 220.0 + 5.0 * noise(rng));
+        table.setValue(grid, TelemetryChannel::GRID_FREQUENCY, violate(rng) ? 51.2 : 50.0 + 0.2 * noise(rng));
+        table.setValue(h2, TelemetryChannel::HYDROGEN_CONCENTRATION, violate(rng) ? 1.2 : 0.5 + 0.2 * noise(rng));
+        table.setValue(h2, TelemetryChannel::HYDROGEN_TANK_PRESSURE, violate(rng) ? 3.5 : 1.0 + 0.2 * noise(rng));
+    }
+
+    LegacyParameters legacy;
+    AnomalyRuleEngine rules;
+    rules.loadBuiltinRules();
+    double base_values[THRESHOLD_BASE_COUNT] = {1.0, 220.0, 50.0, 1.0, 1.5, 1.0};
+    rules.compile(base_values, registry);
+    std::vector<uint64_t> screen(maskWordCount(devices), 0);
+
+    std::cout << "设备数: " << devices << " (并网点与储氢系统各" << devices << "台, 共4个检测通道)" << std::endl;
+    uint64_t detected = 0;
+    double baseline_ns = timeScan(duration_ms, [&]() { return scanLegacy(legacy, table, devices); }, detected);
+    printRow("原逐字段判定", baseline_ns, devices, baseline_ns, detected);
+
+    const ThresholdKernel kernels[] = {ThresholdKernel::SCALAR, ThresholdKernel::SSE2, ThresholdKernel::AVX2,
+                                       ThresholdKernel::AVX512};
+    ThresholdKernel original = activeThresholdKernel();
+    for (ThresholdKernel kernel : kernels) {
+        if (!setThresholdKernel(kernel)) {
+            std::cout << "  " << thresholdKernelName(kernel) << ": CPU不支持，跳过" << std::endl;
+            continue;
+        }
+        double round_ns = timeScan(duration_ms, [&]() { return scanPlan(rules, table, screen); }, detected);
+        std::string name = std::string("规则计划/") + thresholdKernelName(kernel);
+        printRow(name.c_str(), round_ns, devices, baseline_ns, detected);
+    }
+    setThresholdKernel(original);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int duration_ms = argc > 1 ? std::atoi(argv[1]) : 300;
+    double violation_ratio = argc > 2 ? std::atof(argv[2]) : 0.001;
+
+    std::cout << "自动选择的内核: " << thresholdKernelName(activeThresholdKernel())
+              << ", 每项持续: " << duration_ms << " ms, 越限比例: " << violation_ratio << std::endl;
+    const size_t kScales[] = {1000, 10000, 100000};
+    for (size_t devices : kScales) {
+        runScale(devices, duration_ms, violation_ratio);
+    }
+    return 0;
+}
@@ -0,0 +1,139 @@
+// timing_wheel.cpp
+#include "timing_wheel.h"
+#include <algorithm>
+#include "bit_ops.h"
+
+TimingWheel::TimingWheel() {
+    std::fill(std::begin(heads_), std::end(heads_), NIL);
+    std::fill(std::begin(occupied_), std::end(occupied_), 0ull);
+}
+
+// 设置定时器
+TimingWheel::TimerId TimingWheel::arm(uint64_t payload, int64_t deadline) {
+    uint32_t node;
+    if (free_head_ != NIL) {
+        node = free_head_;
+        free_head_ = nodes_[node].next;
+    } else {
+        node = static_cast<uint32_t>(nodes_.size());
+        nodes_.push_back(Node{});
+    }
+    nodes_[node].payload = payload;
+    nodes_[node].deadline = deadline;
+    link(node, now_ + 1); // 当前tick的槽已处理，已过期的在下一tick触发
+    ++count_;
+    return node;
+}
+
+// 取消定时器
+bool TimingWheel::cancel(TimerId id) {
+    if (id >= nodes_.size() || nodes_[id].slot == NIL) {
+        return false;
+    }
+    unlink(id);
+    release(id);
+    return true;
+}
+
+int64_t TimingWheel::deadline(TimerId id) const {
+    if (id >= nodes_.size() || nodes_[id].slot == NIL) {
+        return NO_DEADLINE;
+    }
+    return nodes_[id].deadline;
+}
+
+// 最早可能到期的tick
+int64_t TimingWheel::nextExpiry() const {
+    if (count_ == 0) {
+        return NO_DEADLINE;
+    }
+    int64_t boundary = (now_ | (SLOTS - 1)) + 1; // 下一次层间下移
+    if (occupied_[0] != 0) {
+        unsigned start = static_cast<unsigned>((now_ + 1) & (SLOTS - 1));
+        int64_t next = now_ + 1 + lowestSetBit(rotateRight(occupied_[0], start));
+        bool upper_empty = occupied_[1] == 0 && occupied_[2] == 0 && occupied_[3] == 0;
+        return upper_empty ? next : std::min(next, boundary);
+    }
+    return boundary;
+}
+
+// 按到期时间放入对应槽：第l层容纳距当前64^l ~ 64^(l+1)个tick的定时器
+void TimingWheel::link(uint32_t node, int64_t earliest) {
+    Node& n = nodes_[node];
+    int64_t deadline = std::max(n.deadline, earliest);
+    int64_t delta = deadline - now_;
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (int64_t(1) << (SLOT_BITS * (level + 1)))) {
+        ++level;
+    }
+    if (delta >= (int64_t(1) << (SLOT_BITS * LEVELS))) {
+        deadline = now_ + (int64_t(1) << (SLOT_BITS * LEVELS)) - 1; // 超出范围：下移时重新定位
+    }
+    uint32_t index = static_cast<uint32_t>((deadline >> (SLOT_BITS * level)) & (SLOTS - 1));
+    uint32_t slot = static_cast<uint32_t>(level * SLOTS) + index;
+
+    n.slot = slot;
+    n.prev = NIL;
+    n.next = heads_[slot];
+    if (n.next != NIL) {
+        nodes_[n.next].prev = node;
+    }
+    heads_[slot] = node;
+    occupied_[level] |= 1ull << index;
+}
+
+void TimingWheel::unlink(uint32_t node) {
+    Node& n = nodes_[node];
+    if (n.prev != NIL) {
+        nodes_[n.prev].next = n.next;
+    } else {
+        heads_[n.slot] = n.next;
+        if (n.next == NIL) {
+            occupied_[n.slot / SLOTS] &= ~(1ull << (n.slot % SLOTS));
+        }
+    }
+    if (n.next != NIL) {
+        nodes_[n.next].prev = n.prev;
+    }
+    n.slot = NIL;
+}
+
+void TimingWheel::release(uint32_t node) {
+    nodes_[node].slot = NIL;
+    nodes_[node].next = free_head_;
+    free_head_ = node;
+    --count_;
+}
+
+uint32_t TimingWheel::detachSlot(uint32_t slot) {
+    uint32_t head = heads_[slot];
+    heads_[slot] = NIL;
+    occupied_[slot / SLOTS] &= ~(1ull << (slot % SLOTS));
+    return head;
+}
+
+// 将第level层当前槽的定时器按剩余时间重新放入较低层
+void TimingWheel::cascade(int level) {
+    uint32_t index = static_cast<uint32_t>((now_ >> (SLOT_BITS * level)) & (SLOTS - 1));
+    uint32_t node = detachSlot(static_cast<uint32_t>(level * SLOTS) + index);
+    while (node != NIL) {
+        uint32_t next = nodes_[node].next;
+        link(node, now_); // 当前tick的槽尚未处理，恰在本tick到期的放入当前槽
+        node = next;
+    }
+}
+
+// 取出第0层当前槽中已到期的定时器
+void TimingWheel::expireCurrentSlot(std::vector<uint32_t>& due) {
+    uint32_t node = detachSlot(static_cast<uint32_t>(now_ & (SLOTS - 1)));
+    while (node != NIL) {
+        uint32_t next = nodes_[node].next;
+        if (nodes_[node].deadline <= now_) {
+            nodes_[node].slot = NIL;
+            due.push_back(node);
+        } else {
+            link(node, now_ + 1);
+        }
+        node = next;
+    }
+}
@@ -0,0 +1,105 @@
+// timing_wheel.h
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// 分层时间轮：4层×64槽，以tick为单位（调用方约定，本项目为1ms），
+// 覆盖64^4个tick，更远的定时先放在最高层，层间下移时重新定位。
+// 定时器节点存放在连续的节点池中，槽内为双向链表：
+// 设置、取消均为O(1)，推进时只访问到期槽及需要下移的槽。非线程安全。
+class TimingWheel {
+public:
+    using TimerId = uint32_t;
+    static constexpr TimerId INVALID_TIMER = 0xFFFFFFFFu;
+    static constexpr int64_t NO_DEADLINE = std::numeric_limits<int64_t>::max();
+
+    TimingWheel();
+
+    // 设置定时器：deadline（tick）到达时以payload回调，不晚于当前tick的在下一tick触发
+    TimerId arm(uint64_t payload, int64_t deadline);
+
+    // 取消定时器，存在并已取消返回true（已到期或取消的标识可能被新定时器复用）
+    bool cancel(TimerId id);
+
+    // 定时器的到期tick，不存在（已到期或取消）时返回NO_DEADLINE
+    int64_t deadline(TimerId id) const;
+
+    // 推进到now（tick），对每个到期定时器调用on_expire(payload)；回调中可设置或取消定时器
+    template <typename OnExpire>
+    void advance(int64_t now, OnExpire on_expire);
+
+    // 最早可能到期的tick（下一个非空槽或下一次层间下移），无定时器时返回NO_DEADLINE
+    int64_t nextExpiry() const;
+
+    int64_t now() const { return now_; }
+    size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+private:
+    static constexpr int LEVELS = 4;
+    static constexpr int SLOT_BITS = 6;
+    static constexpr int SLOTS = 1 << SLOT_BITS;
+    static constexpr uint32_t NIL = 0xFFFFFFFFu;
+
+    struct Node {
+        uint64_t payload;
+        int64_t deadline;
+        uint32_t prev;
+        uint32_t next;
+        uint32_t slot;      // 所在槽（层×64+槽号），NIL为空闲节点
+    };
+
+    void link(uint32_t node, int64_t earliest); // 按到期时间放入对应槽（不早于earliest）
+    void unlink(uint32_t node);             // 从所在槽移除
+    void release(uint32_t node);            // 归还节点池
+    uint32_t detachSlot(uint32_t slot);     // 取下整槽链表，返回首节点
+    void cascade(int level);                // 将当前层槽内定时器下移
+    void expireCurrentSlot(std::vector<uint32_t>& due);
+
+    std::vector<Node> nodes_;               // 节点池
+    uint32_t free_head_ = NIL;              // 空闲节点链表
+    uint32_t heads_[LEVELS * SLOTS];        // 各槽链表头
+    uint64_t occupied_[LEVELS];             // 各层非空槽位图
+    int64_t now_ = 0;                       // 当前tick
+    size_t count_ = 0;                      // 已设置的定时器数
+    std::vector<uint32_t> due_;             // 推进时的到期节点（复用容量）
+};
+
+template <typename OnExpire>
+void TimingWheel::advance(int64_t now, OnExpire on_expire) {
+    while (now_ < now) {
+        if (count_ == 0) {
+            now_ = now;
+            break;
+        }
+        if (occupied_[0] == 0) {
+            // 第0层为空：直接跳到下一次层间下移前
+            int64_t boundary = (now_ | (SLOTS - 1)) + 1;
+            if (boundary > now) {
+                now_ = now;
+                break;
+            }
+            now_ = boundary - 1;
+        }
+        ++now_;
+        for (int level = 1; level < LEVELS; ++level) {
+            if (((now_ >> (SLOT_BITS * (level - 1))) & (SLOTS - 1)) != 0) {
+                break;
+            }
+            cascade(level);
+        }
+        due_.clear();
+        expireCurrentSlot(due_);
+        for (uint32_t node : due_) {
+            uint64_t payload = nodes_[node].payload;
+            release(node);
+            on_expire(payload);
+        }
+    }
+}
+
+#endif // TIMING_WHEEL_H
@@ -0,0 +1,121 @@
+// trend_forecaster.cpp
+#include "trend_forecaster.h"
+#include "bit_ops.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr int64_t NO_TIME = std::numeric_limits<int64_t>::min();
+constexpr int64_t GAP_RESET_US = 60000000;  // 中断超过60s重新初始化
+constexpr double SIGNIFICANCE = 2.0;        // 变化率显著性（标准差倍数）
+
+} // namespace
+
+std::vector<ForecastSpec> builtinForecasters() {
+    return {
+        // 氢浓度：通风见效慢，提前60s预测
+        {DeviceClass::HYDROGEN_SYSTEM, TelemetryChannel::HYDROGEN_CONCENTRATION,
+         TelemetryChannel::HYDROGEN_CONCENTRATION_FORECAST, 60000, 0.01, 0.0005},
+        // 氢罐压力：泄压阀开启存在机械延迟，提前30s预测
+        {DeviceClass::HYDROGEN_SYSTEM, TelemetryChannel::HYDROGEN_TANK_PRESSURE,
+         TelemetryChannel::HYDROGEN_PRESSURE_FORECAST, 30000, 0.005, 0.001},
+    };
+}
+
+TrendForecaster::TrendForecaster(const ForecastSpec& spec)
+    : spec_(spec),
+      horizon_s_(0.0),
+      measurement_variance_(spec.measurement_sigma * spec.measurement_sigma),
+      acceleration_variance_(spec.acceleration_sigma * spec.acceleration_sigma) {
+    setHorizon(spec.horizon_ms);
+}
+
+void TrendForecaster::allocate(size_t rows) {
+    states_.assign(rows, RowState{});
+    for (RowState& state : states_) {
+        reset(state);
+    }
+}
+
+void TrendForecaster::setHorizon(int32_t horizon_ms) {
+    spec_.horizon_ms = std::max<int32_t>(0, horizon_ms);
+    horizon_s_ = spec_.horizon_ms * 1e-3;
+}
+
+void TrendForecaster::reset(RowState& state) {
+    state = RowState{};
+    state.last_time_us = NO_TIME;
+    state.last_value = std::numeric_limits<double>::quiet_NaN();
+    state.output = std::numeric_limits<double>::quiet_NaN();
+}
+
+double TrendForecaster::risingRate(const RowState& state) const {
+    return std::max(0.0, state.rate - SIGNIFICANCE * std::sqrt(state.p11));
+}
+
+double TrendForecaster::update(size_t row, int64_t time_us, double value) {
+    RowState& state = states_[row];
+    if (std::isnan(value) || (state.last_time_us != NO_TIME && time_us <= state.last_time_us)) {
+        return state.output; // 无数据或乱序
+    }
+    if (state.last_time_us == NO_TIME || time_us - state.last_time_us > GAP_RESET_US) {
+        // 初始化：水平取首个样本，变化率未知（初始不确定度为每秒一个测量噪声标准差）
+        state.level = value;
+        state.rate = 0.0;
+        state.p00 = measurement_variance_;
+        state.p01 = 0.0;
+        state.p11 = measurement_variance_;
+    } else {
+        // 预测：x' = F·x，P' = F·P·Fᵀ + Q（连续白噪声加速度离散化）
+        double dt = (time_us - state.last_time_us) * 1e-6;
+        double q = acceleration_variance_;
+        state.level += state.rate * dt;
+        state.p00 += dt * (2.0 * state.p01 + dt * state.p11) + q * dt * dt * dt / 3.0;
+        state.p01 += dt * state.p11 + q * dt * dt * 0.5;
+        state.p11 += q * dt;
+
+        // 更新：观测矩阵H = [1 0]
+        double innovation = value - state.level;
+        double inverse_s = 1.0 / (state.p00 + measurement_variance_);
+        double k0 = state.p00 * inverse_s;
+        double k1 = state.p01 * inverse_s;
+        state.level += k0 * innovation;
+        state.rate += k1 * innovation;
+        state.p11 -= k1 * state.p01;
+        state.p01 -= k0 * state.p01;
+        state.p00 -= k0 * state.p00;
+    }
+    state.output = state.level + risingRate(state) * horizon_s_;
+    state.last_time_us = time_us;
+    state.last_value = value;
+    return state.output;
+}
+
+void TrendForecaster::updateColumn(const double* values, const int64_t* times, const uint64_t* changed,
+                                   double* outputs, uint64_t* output_changed, size_t rows) {
+    for (size_t w = 0; w < (rows + 63) / 64; ++w) {
+        for (uint64_t bits = changed[w]; bits != 0; bits &= bits - 1) {
+            unsigned bit = lowestSetBit(bits);
+            size_t row = w * 64 + bit;
+            double output = update(row, times[row], values[row]);
+            if (output != outputs[row] && !(std::isnan(output) && std::isnan(outputs[row]))) {
+                outputs[row] = output;
+                output_changed[w] |= 1ull << bit;
+            }
+        }
+    }
+}
+
+double TrendForecaster::timeToReach(size_t row, double limit) const {
+    const RowState& state = states_[row];
+    if (state.last_time_us == NO_TIME) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    if (state.level >= limit) {
+        return 0.0;
+    }
+    double rate = risingRate(state);
+    return rate > 0.0 ? (limit - state.level) / rate : std::numeric_limits<double>::infinity();
+}
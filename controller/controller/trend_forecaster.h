@@ -0,0 +1,74 @@
+// trend_forecaster.h
+#ifndef TREND_FORECASTER_H
+#define TREND_FORECASTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "device_registry.h"
+
+// 趋势预测器定义：由源通道计算派生通道（预测时域末的外推值，单位同源通道）
+struct ForecastSpec {
+    DeviceClass device_class;       // 适用设备类别
+    TelemetryChannel source;        // 源通道
+    TelemetryChannel output;        // 派生通道
+    int32_t horizon_ms;             // 预测时域(ms)：外推值越限即预计在时域内越限
+    double measurement_sigma;       // 测量噪声标准差（源通道单位）
+    double acceleration_sigma;      // 变化率的随机游走强度（源通道单位/s²）
+};
+
+// 内置趋势预测器：氢浓度、氢罐压力（泄压阀等执行机构存在机械延迟，需提前动作）
+std::vector<ForecastSpec> builtinForecasters();
+
+// 流式趋势预测：每台设备一个二维卡尔曼滤波器（水平、变化率，匀速模型），
+// 每个样本固定的十几次乘加，无循环无分配，可在安全快速路径上运行。
+// 外推只采用显著上升的变化率（估计值减两倍标准差），噪声与下降不会提前告警；
+// 输出取当前水平与时域末外推值的较大者。非线程安全，仅监测线程使用。
+class TrendForecaster {
+public:
+    explicit TrendForecaster(const ForecastSpec& spec);
+
+    // 按设备行数分配状态
+    void allocate(size_t rows);
+
+    // 修改预测时域，下一个样本起生效
+    void setHorizon(int32_t horizon_ms);
+    int32_t horizon() const { return spec_.horizon_ms; }
+
+    // 接入单个样本（时间戳us），返回预测值；乱序样本被忽略
+    double update(size_t row, int64_t time_us, double value);
+
+    // 接入整列快照：仅本轮有写入的设备（changed位图）按其采集时间接入，结果写入outputs对应行，
+    // 结果有变化的设备在output_changed位图中置位；已由带时间戳样本接入的同一时刻不会重复接入
+    void updateColumn(const double* values, const int64_t* times, const uint64_t* changed,
+                      double* outputs, uint64_t* output_changed, size_t rows);
+
+    // 按当前估计到达limit的时间(s)：已达到返回0，未显著上升返回无穷大，无数据返回NaN
+    double timeToReach(size_t row, double limit) const;
+
+    double output(size_t row) const { return states_[row].output; }
+    const ForecastSpec& spec() const { return spec_; }
+
+private:
+    struct RowState {
+        int64_t last_time_us;           // 最近样本时间
+        double last_value;              // 最近样本值
+        double level;                   // 水平估计
+        double rate;                    // 变化率估计（源通道单位/s）
+        double p00;                     // 协方差矩阵（对称，存上三角）
+        double p01;
+        double p11;
+        double output;
+    };
+
+    void reset(RowState& state);
+    double risingRate(const RowState& state) const; // 显著上升的变化率，否则为0
+
+    ForecastSpec spec_;
+    double horizon_s_;
+    double measurement_variance_;
+    double acceleration_variance_;
+    std::vector<RowState> states_;
+};
+
+#endif // TREND_FORECASTER_H